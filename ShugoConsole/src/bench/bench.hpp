@@ -0,0 +1,73 @@
+#ifndef SHUGOCONSOLE_BENCH_BENCH_HPP
+#define SHUGOCONSOLE_BENCH_BENCH_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "shugoconsole/cry/cvar.hpp"
+#include "shugoconsole/cry/region_source.hpp"
+
+namespace shugoconsole::bench
+{
+
+using clock_type = std::chrono::steady_clock;
+
+inline double elapsed_ms(clock_type::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(clock_type::now() - start)
+		.count();
+}
+
+// Peak resident memory of the process in bytes
+size_t peak_memory();
+
+struct result
+{
+	double first_ms = -1;
+	double all_ms = -1;
+	size_t found = 0;
+	bool correct = true;
+};
+
+// Counts the CVars found and compares them to the expected ones, if known
+void check(
+	result& r,
+	const std::vector<cry::cvar*>& found,
+	const std::vector<cry::cvar*>& expected);
+
+// Prints the best of runs calls of f, the scan of size bytes
+// Returns false if a call found other CVars than the expected ones
+bool report(
+	const std::string& name,
+	size_t size,
+	size_t runs,
+	const std::function<result()>& f);
+
+// Suites of benchmarks, each returns false if a result was not the expected
+// one
+
+// Every scan of source, expected is empty if the addresses of the targets
+// are not known
+bool run_scanner_benchmarks(
+	cry::region_source& source,
+	size_t size,
+	const std::vector<cry::cvar*>& expected,
+	size_t runs);
+
+// Scans of the candidate regions of the process and of its heap blocks
+bool run_process_benchmarks(size_t runs);
+
+bool run_layout_benchmarks();
+bool run_allocation_benchmarks();
+bool run_tear_benchmarks();
+bool run_enforcement_benchmarks();
+bool run_pacing_benchmarks();
+bool run_hook_benchmarks();
+bool run_registration_benchmarks();
+
+} // namespace shugoconsole::bench
+
+#endif // SHUGOCONSOLE_BENCH_BENCH_HPP
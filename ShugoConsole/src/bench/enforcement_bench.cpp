@@ -0,0 +1,441 @@
+#include "bench/bench.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "shugoconsole/cry/check_interval.hpp"
+#include "shugoconsole/cry/cvar_layout.hpp"
+#include "shugoconsole/cry/cvar_liveness.hpp"
+#include "shugoconsole/cry/override_stats.hpp"
+#include "testing/allocations.hpp"
+#include "testing/fake_cvars.hpp"
+
+#if defined _WIN32
+#	define NOMINMAX
+#	define WIN32_LEAN_AND_MEAN
+#	include <Windows.h>
+#	include "shugoconsole/win/write_watch.hpp"
+#else
+#	include "shugoconsole/posix/write_watch.hpp"
+#endif
+
+namespace shugoconsole::bench
+{
+
+using namespace testing;
+
+// Allocations and time of the checks and writes of the enforcement loop,
+// with values compared and written through cvar::value and with an apply
+// plan rendered once
+bool run_allocation_benchmarks()
+{
+	constexpr size_t ticks = 100000;
+	const std::vector<cry::cvar::value> values{
+		90.0f,
+		1,
+		30.0f,
+		0,
+		144,
+		std::string{"a string value longer than the SSO"}};
+
+	std::vector<std::byte> memory(TARGET_NAMES.size() * record_size);
+	std::vector<cry::cvar*> vars;
+	for (size_t i = 0; i < TARGET_NAMES.size(); ++i)
+	{
+		vars.push_back(
+			write_record(memory.data() + i * record_size, TARGET_NAMES[i]));
+	}
+
+	const auto source = cry::make_process_region_source();
+	const auto vtable = reinterpret_cast<std::uintptr_t>(vars.front()->dummy0);
+
+	// The game overwrites one CVar every 16 ticks
+	const auto overwrite = [&](size_t tick) {
+		if (tick % 16 == 0)
+			*vars[(tick / 16) % vars.size()] = 0.5f;
+	};
+
+	// check(i) checks and writes CVar i, returns the number of writes
+	const auto time = [&](const auto& check) {
+		for (size_t i = 0; i < vars.size(); ++i)
+			check(i);
+
+		const auto before = allocation_count();
+		const auto start = clock_type::now();
+		size_t writes = 0;
+		for (size_t tick = 0; tick < ticks; ++tick)
+		{
+			overwrite(tick);
+			for (size_t i = 0; i < vars.size(); ++i)
+				writes += check(i);
+		}
+		const auto ns = elapsed_ms(start) * 1e6 / (ticks * vars.size());
+		return std::make_tuple(allocation_count() - before, ns, writes);
+	};
+
+	// As the loop did before: pattern built on each check, compare and write
+	// through the variant
+	const auto [valueAllocations, valueNs, valueWrites] = time([&](size_t i) {
+		const cry::cvar::pattern pattern{TARGET_NAMES[i]};
+		cry::check_liveness(*source, pattern, vars[i], vtable);
+
+		cry::cvar_ref var{vars[i], cry::native_layout{}};
+		if (var == values[i])
+			return 0;
+		var = values[i];
+		return 1;
+	});
+
+	std::vector<cry::cvar::pattern> patterns;
+	std::vector<cry::cvar_assignment> plan;
+	for (size_t i = 0; i < vars.size(); ++i)
+	{
+		patterns.emplace_back(TARGET_NAMES[i]);
+		plan.emplace_back(values[i]);
+	}
+
+	const auto [planAllocations, planNs, planWrites] = time([&](size_t i) {
+		cry::check_liveness(*source, patterns[i], vars[i], vtable);
+
+		if (plan[i].matches(vars[i], cry::native_layout{}))
+			return 0;
+		plan[i].write(vars[i], cry::native_layout{});
+		return 1;
+	});
+
+	fmt::print("\n");
+	fmt::print(
+		"Enforcement with values: {:d} allocations, {:.1f} ns per CVar, "
+		"{:d} writes\n",
+		valueAllocations,
+		valueNs,
+		valueWrites);
+	fmt::print(
+		"Enforcement with apply plan: {:d} allocations{}, {:.1f} ns per CVar, "
+		"{:d} writes\n",
+		planAllocations,
+		planAllocations == 0 ? "" : " (MISMATCH)",
+		planNs,
+		planWrites);
+	return planAllocations == 0;
+}
+
+// Reads of a CVar by another thread that mix two values, while the CVar is
+// written back and forth with separate stores and with cvar_assignment
+// A torn state is counted once however many times it is read: with a single
+// core, the reader sees one each time the writer is preempted inside a write
+bool run_tear_benchmarks()
+{
+	using namespace std::chrono_literals;
+
+	alignas(16) std::array<std::byte, record_size> record{};
+	const auto var = write_record(record.data(), TARGET_NAMES.front());
+	constexpr cry::native_layout layout;
+
+	const cry::cvar_assignment first{90.0f};
+	const cry::cvar_assignment second{120.0f};
+
+	struct outcome
+	{
+		size_t reads = 0;
+		size_t numberTears = 0;
+		size_t stringTears = 0;
+		size_t writes = 0;
+	};
+
+	// Reads the fields one by one like the getters of the game
+	const auto run = [&](const auto& write) {
+		first.write(var, layout);
+
+		std::atomic<bool> done{false};
+		outcome result;
+		std::thread reader{[&] {
+			const auto fields =
+				reinterpret_cast<volatile const std::byte*>(var);
+			bool torn = false;
+			while (!done.load(std::memory_order_relaxed))
+			{
+				int i;
+				float f;
+				std::array<char, 16> s;
+				for (size_t b = 0; b < sizeof(i); ++b)
+				{
+					reinterpret_cast<std::byte*>(&i)[b] =
+						fields[offsetof(cry::cvar, int_value) + b];
+				}
+				for (size_t b = 0; b < sizeof(f); ++b)
+				{
+					reinterpret_cast<std::byte*>(&f)[b] =
+						fields[offsetof(cry::cvar, float_value) + b];
+				}
+				for (size_t b = 0; b < s.size(); ++b)
+				{
+					s[b] = static_cast<char>(
+						fields[offsetof(cry::cvar, string_value) + b]);
+				}
+				s.back() = '\0';
+
+				++result.reads;
+				const bool numberTorn = i != static_cast<int>(f);
+				const bool stringTorn =
+					!numberTorn && std::strtof(s.data(), nullptr) != f;
+				if (!torn)
+				{
+					result.numberTears += numberTorn;
+					result.stringTears += stringTorn;
+				}
+				torn = numberTorn || stringTorn;
+			}
+		}};
+
+		const auto start = clock_type::now();
+		while (clock_type::now() - start < 1s)
+		{
+			for (size_t n = 0; n < 1000; ++n)
+				write(n % 2 ? second : first);
+			result.writes += 1000;
+		}
+		done = true;
+		reader.join();
+		return result;
+	};
+
+	// As cvar::set does: int, float then string
+	const auto separate = run([&](const cry::cvar_assignment& value) {
+		*var = &value == &first ? 90.0f : 120.0f;
+	});
+	const auto published = run(
+		[&](const cry::cvar_assignment& value) { value.write(var, layout); });
+
+	const auto print = [](const char* name, const outcome& o) {
+		fmt::print(
+			"{}: {:d} writes, {:d} reads, torn states: {:d} int/float, {:d} "
+			"string\n",
+			name,
+			o.writes,
+			o.reads,
+			o.numberTears,
+			o.stringTears);
+	};
+	fmt::print("\n");
+	print("Writes with separate stores", separate);
+	print("Writes with cvar_assignment", published);
+
+	// Not checked: the fields are read one by one, so even a single store
+	// can be seen between the read of the int and the one of the float. The
+	// tests read them together
+	return true;
+}
+
+namespace
+{
+
+#if defined _WIN32
+using write_watch = win::write_watch;
+
+bool wait_for_write(write_watch& watch, std::chrono::milliseconds timeout)
+{
+	return ::WaitForSingleObject(
+			   watch.event_handle(), static_cast<DWORD>(timeout.count())) ==
+		   WAIT_OBJECT_0;
+}
+#else
+using write_watch = posix::write_watch;
+
+bool wait_for_write(write_watch& watch, std::chrono::milliseconds timeout)
+{
+	return watch.wait(timeout);
+}
+#endif
+
+} // namespace
+
+// Wakeups and reaction time of the enforcement loop while another thread
+// overwrites a CVar every 25 ms, then leaves it alone for 500 ms
+bool run_enforcement_benchmarks()
+{
+	using namespace std::chrono_literals;
+	constexpr size_t overwrites = 20;
+	const cry::cvar_assignment wanted{90.0f};
+	const cry::cvar_assignment overwritten{60.0f};
+	constexpr cry::native_layout layout;
+
+	// The CVar has a page of its own, like a CVar among data written rarely
+	constexpr size_t page = 64 * 1024;
+	std::vector<std::byte> memory(2 * page);
+	const auto address = reinterpret_cast<std::uintptr_t>(memory.data());
+	const auto var = write_record(
+		memory.data() + ((address + page - 1) / page * page - address),
+		TARGET_NAMES.front());
+
+	struct outcome
+	{
+		size_t wakeups = 0;
+		size_t idleWakeups = 0;
+		size_t repairs = 0;
+		double reactionMs = 0.0;
+	};
+
+	// loop(done, check, changed) runs the enforcement until done is set,
+	// calling check after every wakeup; changed() tells if the CVar has to be
+	// written again
+	const auto run = [&](const auto& loop) {
+		wanted.write(var, layout);
+
+		std::atomic<bool> idle{false};
+		std::atomic<bool> done{false};
+		std::atomic<clock_type::rep> lastWrite{0};
+
+		std::thread game{[&] {
+			for (size_t i = 0; i < overwrites; ++i)
+			{
+				std::this_thread::sleep_for(25ms);
+				lastWrite = clock_type::now().time_since_epoch().count();
+				overwritten.write(var, layout);
+			}
+			idle = true;
+			std::this_thread::sleep_for(500ms);
+			done = true;
+			// Wakes a loop waiting for writes
+			overwritten.write(var, layout);
+		}};
+
+		outcome result;
+		const auto changed = [&] { return !wanted.matches(var, layout); };
+		loop(done, changed, [&] {
+			++result.wakeups;
+			result.idleWakeups += idle.load();
+			if (changed())
+			{
+				const auto written =
+					clock_type::time_point{clock_type::duration{lastWrite}};
+				result.reactionMs += elapsed_ms(written);
+				++result.repairs;
+				wanted.write(var, layout);
+			}
+		});
+
+		game.join();
+		if (result.repairs)
+			result.reactionMs /= static_cast<double>(result.repairs);
+		return result;
+	};
+
+	const auto polled = run([](std::atomic<bool>& done, auto&&, auto&& check) {
+		while (!done)
+		{
+			check();
+			std::this_thread::sleep_for(100ms);
+		}
+	});
+
+	auto watch = write_watch::create();
+	if (!watch)
+	{
+		fmt::print("\nNo write watch\n");
+		return true;
+	}
+	const auto watched = run([&](std::atomic<bool>& done,
+									 auto&& changed,
+									 auto&& check) {
+		while (!done)
+		{
+			watch->release_all();
+			check();
+
+			// A write made before the page was protected is not caught
+			watch->watch(var, sizeof(cry::cvar));
+			if (!changed())
+				wait_for_write(*watch, 2000ms);
+		}
+		watch->release_all();
+	});
+
+	const auto print = [](const char* name, const outcome& o) {
+		fmt::print(
+			"Enforcement by {}: {:d} wakeups ({:d} while idle), {:d} repairs, "
+			"{:.2f} ms mean reaction\n",
+			name,
+			o.wakeups,
+			o.idleWakeups,
+			o.repairs,
+			o.reactionMs);
+	};
+	fmt::print("\n");
+	print("polling", polled);
+	print("write watch", watched);
+	fmt::print("Writes caught: {:d}\n", watch->take_writes());
+
+	// Overwrites close together are repaired at once, but each burst wakes
+	// the loop
+	return polled.repairs > 0 && watched.repairs > 0;
+}
+
+// Checks made and override-to-restore latency over 10 simulated minutes in
+// which the game resets a CVar five times, 200 ms apart, once a minute
+bool run_pacing_benchmarks()
+{
+	using namespace std::chrono_literals;
+	using milliseconds = std::chrono::milliseconds;
+	constexpr milliseconds duration = 10min;
+
+	std::vector<milliseconds> overrides;
+	for (milliseconds burst = 30037ms; burst < duration; burst += 1min)
+	{
+		for (int i = 0; i < 5; ++i)
+			overrides.push_back(burst + i * 200ms);
+	}
+
+	// next(overridden) returns the time to wait after a check
+	const auto simulate = [&](const char* name, auto&& next) {
+		cry::override_stats stats;
+		size_t checks = 0;
+		size_t pending = 0;
+		bool overridden = false;
+		for (milliseconds now{0}; now < duration; now += next(overridden))
+		{
+			++checks;
+			overridden =
+				pending < overrides.size() && overrides[pending] <= now;
+			if (overridden)
+			{
+				stats.record(now - overrides[pending]);
+				while (pending < overrides.size() && overrides[pending] <= now)
+					++pending;
+			}
+		}
+
+		fmt::print(
+			"{}: {:d} checks, {:d} restores, {:.1f} ms mean and {:.1f} ms max "
+			"latency ({})\n",
+			name,
+			checks,
+			stats.overrides,
+			stats.mean_latency().count() / 1000.0,
+			stats.max_latency.count() / 1000.0,
+			cry::format_latency_histogram(stats));
+	};
+
+	fmt::print("\n");
+	simulate("Checks every 100 ms", [](bool) { return 100ms; });
+	cry::check_interval shortInterval{100ms, 800ms};
+	simulate("Checks from 100 to 800 ms", [&](bool overridden) {
+		return shortInterval.next(overridden);
+	});
+	cry::check_interval interval{100ms, 3200ms};
+	simulate("Checks from 100 to 3200 ms", [&](bool overridden) {
+		return interval.next(overridden);
+	});
+	return true;
+}
+
+} // namespace shugoconsole::bench
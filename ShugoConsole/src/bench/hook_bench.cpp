@@ -0,0 +1,211 @@
+#include "bench/bench.hpp"
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "shugoconsole/cry/cvar_layout.hpp"
+#include "shugoconsole/cry/method_address.hpp"
+#include "shugoconsole/cry/register_hook.hpp"
+#include "shugoconsole/cry/registered_cvars.hpp"
+#include "shugoconsole/cry/set_hooks.hpp"
+#include "shugoconsole/cry/set_interceptor.hpp"
+#include "shugoconsole/cry/signature.hpp"
+#include "testing/fake_cvars.hpp"
+#include "testing/fake_engine.hpp"
+
+namespace shugoconsole::bench
+{
+
+using namespace testing;
+
+// Cost of a Set of the engine and values seen after it, with the Set methods
+// hooked by a copy of the vtable of the fake engine CVars in place of Detours
+bool run_hook_benchmarks()
+{
+	constexpr size_t sets = 1000000;
+	constexpr float wanted = 90.0f;
+
+	fake_engine_cvar managed;
+	fake_engine_cvar unmanaged;
+	fake_engine_cvar plain;
+
+	// Set(const char*), Set(float) and Set(int) are in slots 1, 2 and 3
+	std::array<void*, 4> vtable;
+	std::memcpy(
+		vtable.data(),
+		*reinterpret_cast<void***>(&managed),
+		sizeof(vtable));
+
+	using cry::set_hooks::method;
+	const std::pair<method, size_t> methods[] = {
+		{method::string, 1}, {method::floating, 2}, {method::integer, 3}};
+	for (const auto& [m, slot] : methods)
+	{
+		const auto target = cry::set_hooks::reserve(m, vtable[slot]);
+		vtable[slot] = target->replacement;
+	}
+
+	for (auto var : {&managed, &unmanaged})
+	{
+		const auto patched = vtable.data();
+		std::memcpy(static_cast<void*>(var), &patched, sizeof(patched));
+	}
+
+	const auto time = [&](fake_engine_cvar& var) {
+		// Calls through a pointer the compiler can't see through
+		fake_engine_cvar* volatile p = &var;
+		size_t overridden = 0;
+		const auto start = clock_type::now();
+		for (size_t i = 0; i < sets; ++i)
+		{
+			p->set(static_cast<float>(i & 63));
+			overridden += p->value != wanted;
+		}
+		const auto ns = elapsed_ms(start) * 1e6 / sets;
+		return std::make_pair(ns, overridden);
+	};
+
+	const auto print = [&](const char* name, std::pair<double, size_t> r) {
+		fmt::print(
+			"{}: {:.1f} ns per Set, value not the configured one after {:d} "
+			"of {:d} Sets\n",
+			name,
+			r.first,
+			r.second,
+			sets);
+	};
+
+	fmt::print("\n");
+	print("Set without hook", time(plain));
+
+	bool correct = true;
+	for (const auto mode :
+		 {cry::set_interceptor::mode::rewrite,
+		  cry::set_interceptor::mode::reject})
+	{
+		const auto rewrite = mode == cry::set_interceptor::mode::rewrite;
+		cry::set_interceptor interceptor{mode};
+		cry::set_hooks::use(&interceptor);
+		interceptor.manage(
+			reinterpret_cast<const cry::cvar*>(&managed),
+			cry::cvar_assignment{wanted});
+
+		managed.value = wanted;
+		const auto hooked = time(managed);
+		print(rewrite ? "Hooked Set, rewrite" : "Hooked Set, reject", hooked);
+		print("Hooked Set, unmanaged CVar", time(unmanaged));
+
+		// The other overloads go through the hooks too
+		fake_engine_cvar* volatile p = &managed;
+		p->set("60");
+		p->set(60);
+		fmt::print(
+			"  after Set(\"60\") and Set(60): {}, {:d} Sets intercepted\n",
+			managed.value,
+			interceptor.take_intercepted());
+
+		cry::set_hooks::use(nullptr);
+		correct = correct && hooked.second == 0 && managed.value == wanted;
+	}
+
+	// The objects get their own vtable back before they are destroyed
+	for (auto var : {&managed, &unmanaged})
+		std::memcpy(static_cast<void*>(var), &plain, sizeof(void*));
+	cry::set_hooks::release_all();
+	return correct;
+}
+
+bool run_registration_benchmarks()
+{
+	constexpr size_t count = 5000;
+
+	// CVars of the engine with the targets last, as the console creates them
+	std::vector<std::string> names;
+	for (size_t i = 0; names.size() < count; ++i)
+		names.push_back(fmt::format("{}var{:d}", FAKE_PREFIXES[i % 10], i));
+	names.insert(names.end(), TARGET_NAMES.begin(), TARGET_NAMES.end());
+
+	std::vector<std::byte> records(names.size() * record_size);
+	std::vector<cry::cvar*> vars;
+	for (size_t i = 0; i < names.size(); ++i)
+	{
+		vars.push_back(
+			write_record(records.data() + i * record_size, names[i]));
+	}
+
+	// Registrations are called through a pointer the compiler can't see
+	// through, like the engine does
+	using register_method = void (fake_engine_console::*)(cry::cvar*, void*);
+	const auto target = cry::register_hook::reserve(
+		cry::code_of(&fake_engine_console::register_var));
+	fake_engine_console console;
+	const auto time = [&](void* code) {
+		const volatile auto m = cry::method_at<register_method>(code);
+		const auto start = clock_type::now();
+		for (const auto var : vars)
+			(console.*m)(var, nullptr);
+		return elapsed_ms(start) * 1e6 / static_cast<double>(vars.size());
+	};
+
+	const auto registered = std::make_unique<cry::registered_cvars>();
+	const auto plainNs = time(target.function);
+	cry::register_hook::use(registered.get());
+	const auto hookedNs = time(target.replacement);
+	cry::register_hook::use(nullptr);
+
+	fmt::print(
+		"\nRegistration of {:d} CVars: {:.1f} ns each without hook, {:.1f} "
+		"ns hooked, {:d} recorded, {:d} reached the console\n",
+		vars.size(),
+		plainNs,
+		hookedNs,
+		registered->size(),
+		console.registered);
+
+	size_t found = 0;
+	const auto lookupStart = clock_type::now();
+	for (size_t i = 0; i < TARGET_NAMES.size(); ++i)
+	{
+		const auto r = registered->lookup(TARGET_NAMES[i]);
+		found += r && r->var == vars[count + i];
+	}
+	fmt::print(
+		"Lookup of the {:d} targets: {:.2f} us, {:d} found\n",
+		TARGET_NAMES.size(),
+		elapsed_ms(lookupStart) * 1e3,
+		found);
+
+	// Code of the client module with the registration function at the end
+	const auto signature = cry::signature::parse(
+		"48 89 5C 24 ?? 48 89 74 24 ?? 57 48 83 EC ?? 48 8B 02 48 8B FA");
+	const std::uint8_t code[] = {0x48, 0x89, 0x5C, 0x24, 0x08, 0x48, 0x89,
+								 0x74, 0x24, 0x10, 0x57, 0x48, 0x83, 0xEC,
+								 0x20, 0x48, 0x8B, 0x02, 0x48, 0x8B, 0xFA};
+	std::vector<std::byte> module(64 << 20);
+	std::mt19937 random{7};
+	fill_noise(module.data(), module.size(), random);
+	const auto offset = module.size() - 4096;
+	std::memcpy(module.data() + offset, code, sizeof(code));
+
+	const auto scanStart = clock_type::now();
+	const auto match =
+		signature->find(module.data(), module.data() + module.size());
+	fmt::print(
+		"Signature search in {:d} MB of code: {:.1f} ms, {}\n",
+		module.size() >> 20,
+		elapsed_ms(scanStart),
+		match == module.data() + offset ? "found" : "NOT found");
+
+	return registered->size() == vars.size() &&
+		   console.registered == 2 * vars.size() &&
+		   found == TARGET_NAMES.size() && match == module.data() + offset;
+}
+
+} // namespace shugoconsole::bench
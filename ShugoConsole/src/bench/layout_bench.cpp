@@ -0,0 +1,108 @@
+#include "bench/bench.hpp"
+
+#include <array>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "shugoconsole/cry/cvar_layout.hpp"
+#include "testing/fake_cvars.hpp"
+
+namespace shugoconsole::bench
+{
+
+using namespace testing;
+
+// Probe of the value layout of records holding numbers, with the built-in
+// layout and with values moved by 16 bytes
+bool run_layout_benchmarks()
+{
+	constexpr size_t count = 8;
+	constexpr size_t stride = 512;
+	constexpr auto native = cry::cvar_layout::native();
+	constexpr cry::cvar_layout shifted{
+		native.int_offset + 16,
+		native.float_offset + 16,
+		native.string_offset + 16,
+		native.string_size};
+
+	const auto source = cry::make_process_region_source();
+	fmt::print("\n");
+
+	bool correct = true;
+	for (const auto& expected : {native, shifted})
+	{
+		std::vector<std::byte> records(count * stride);
+		std::vector<cry::layout_sample> samples;
+		for (size_t i = 0; i < count; ++i)
+		{
+			const auto var = write_record(
+				records.data() + i * stride,
+				TARGET_NAMES[i % TARGET_NAMES.size()]);
+
+			const bool integer = i % 2 == 0;
+			const auto number = static_cast<int>(i * 25 + 1);
+			const cry::cvar::value value =
+				integer ? cry::cvar::value{number} :
+						  cry::cvar::value{static_cast<float>(number) + 0.5f};
+			cry::set_value(var, value, expected);
+
+			samples.push_back(
+				{var,
+				 integer ? cry::cvar::type::integer :
+						   cry::cvar::type::floating});
+		}
+
+		const auto probeStart = clock_type::now();
+		const auto probed = cry::probe_layout(*source, samples);
+		const auto probeMs = elapsed_ms(probeStart);
+		correct = correct && probed == expected;
+
+		fmt::print(
+			"Layout probe ({}): {} in {:.3f} ms\n",
+			expected == native ? "built-in" : "shifted",
+			probed == expected ? "found" : "MISMATCH",
+			probeMs);
+	}
+
+	// Compare and write with compile time and run time offsets
+	alignas(16) std::array<std::byte, stride> record{};
+	const auto var = write_record(record.data(), TARGET_NAMES.front());
+	const cry::cvar_layout runtime =
+		cry::probe_layout(*source, {}).value_or(native);
+	const cry::cvar::value values[] = {90.0f, 120.0f};
+
+	// Values mostly match, like in the apply loop
+	constexpr size_t writes = 10000000;
+	const auto time = [&](const auto& layout) {
+		const auto start = clock_type::now();
+		size_t changed = 0;
+		for (size_t i = 0; i < writes; ++i)
+		{
+			const auto& value = values[(i >> 12) & 1];
+			cry::cvar_ref ref{var, layout};
+			if (ref != value)
+			{
+				ref = value;
+				++changed;
+			}
+		}
+		return std::make_pair(elapsed_ms(start) * 1e6 / writes, changed);
+	};
+	// Dispatch resolves the probed layout to native_layout
+	time(runtime);
+	const auto [staticNs, staticChanged] = cry::dispatch_layout(runtime, time);
+	const auto [runtimeNs, runtimeChanged] = time(runtime);
+	fmt::print(
+		"Apply: {:.2f} ns per CVar with dispatched offsets, {:.2f} ns with "
+		"run time offsets ({:d}/{:d} writes)\n",
+		staticNs,
+		runtimeNs,
+		staticChanged,
+		runtimeChanged);
+	return correct;
+}
+
+
+} // namespace shugoconsole::bench
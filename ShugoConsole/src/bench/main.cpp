@@ -0,0 +1,119 @@
+// Benchmark of the CVar scanner against synthetic CryEngine heaps, and of
+// the enforcement of the values
+// Usage: ShugoConsoleBench [heap size in MB] [fake CVar count] [runs]
+//        ShugoConsoleBench --replay <dump file> [runs]  (not on Windows)
+// Returns 1 if a benchmark did not get the expected result
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+#include "bench/bench.hpp"
+#include "shugoconsole/cry/memory.hpp"
+#include "testing/fake_cvars.hpp"
+#include "testing/synthetic_heap.hpp"
+
+#if !defined _WIN32
+#	include "shugoconsole/posix/dump_region_source.hpp"
+#endif
+
+using namespace shugoconsole;
+using namespace shugoconsole::bench;
+using namespace shugoconsole::testing;
+
+namespace
+{
+
+size_t argument(int argc, char** argv, int index, size_t defaultValue)
+{
+	return argc > index ? std::strtoul(argv[index], nullptr, 10) : defaultValue;
+}
+
+#if !defined _WIN32
+// Replay of a dump written with the scanner.dump_path setting
+int replay(const char* path, size_t runs)
+{
+	const auto dump = posix::dump_region_source::open(path);
+	if (!dump)
+	{
+		fmt::print("Could not load dump file '{}'\n", path);
+		return 1;
+	}
+
+	fmt::print("Dump: {}, {:d} MB\n", path, dump->size() >> 20);
+
+	std::vector<std::byte> buffer(64 * 1024);
+	const auto found = cry::find_cvar_ptrs(
+		*dump, cry::cvar::pattern_set{target_patterns()}, buffer);
+	for (size_t i = 0; i < found.size(); ++i)
+	{
+		if (found[i])
+		{
+			const auto* address =
+				static_cast<const std::byte*>(static_cast<void*>(found[i]));
+			fmt::print(
+				"  {} at {:#x}\n",
+				TARGET_NAMES[i],
+				dump->original_address(address));
+		}
+		else
+		{
+			fmt::print("  {} not found\n", TARGET_NAMES[i]);
+		}
+	}
+
+	return run_scanner_benchmarks(*dump, dump->size(), {}, runs) ? 0 : 1;
+}
+#endif
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	spdlog::set_level(spdlog::level::off);
+
+#if !defined _WIN32
+	if (argc > 2 && std::strcmp(argv[1], "--replay") == 0)
+		return replay(argv[2], std::max<size_t>(argument(argc, argv, 3, 3), 1));
+#endif
+
+	const size_t heapSize = argument(argc, argv, 1, 256) << 20;
+	const size_t fakeCount = argument(argc, argv, 2, 5000);
+	const size_t runs = std::max<size_t>(argument(argc, argv, 3, 3), 1);
+
+	bool correct = true;
+	{
+		const auto setupStart = clock_type::now();
+		synthetic_heap heap{heapSize, fakeCount, 42};
+		fmt::print(
+			"Synthetic heap: {:d} MB, {:d} fake CVars, {:d} targets, built in "
+			"{:.0f} ms\n",
+			heapSize >> 20,
+			fakeCount,
+			TARGET_NAMES.size(),
+			elapsed_ms(setupStart));
+
+		correct &= run_scanner_benchmarks(heap, heapSize, heap.targets(), runs);
+	}
+
+	// The synthetic heap is freed first, it holds CVars with the same names
+	correct &= run_process_benchmarks(runs);
+	correct &= run_layout_benchmarks();
+	correct &= run_allocation_benchmarks();
+	correct &= run_tear_benchmarks();
+	correct &= run_enforcement_benchmarks();
+	correct &= run_pacing_benchmarks();
+	correct &= run_hook_benchmarks();
+	correct &= run_registration_benchmarks();
+
+	if (!correct)
+	{
+		fmt::print("\nSome results were not the expected ones\n");
+		return 1;
+	}
+	return 0;
+}
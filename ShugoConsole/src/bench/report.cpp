@@ -0,0 +1,78 @@
+#include "bench/bench.hpp"
+
+#include <fmt/format.h>
+
+#if defined _WIN32
+#	define NOMINMAX
+#	define WIN32_LEAN_AND_MEAN
+#	include <Windows.h>
+#	include <Psapi.h>
+#else
+#	include <sys/resource.h>
+#endif
+
+namespace shugoconsole::bench
+{
+
+size_t peak_memory()
+{
+#if defined _WIN32
+	PROCESS_MEMORY_COUNTERS counters{};
+	if (::GetProcessMemoryInfo(
+			::GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return counters.PeakWorkingSetSize;
+	}
+	return 0;
+#else
+	rusage usage{};
+	::getrusage(RUSAGE_SELF, &usage);
+	return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+void check(
+	result& r,
+	const std::vector<cry::cvar*>& found,
+	const std::vector<cry::cvar*>& expected)
+{
+	r.found = 0;
+	for (size_t i = 0; i < found.size(); ++i)
+	{
+		r.found += found[i] != nullptr;
+		r.correct = r.correct && (expected.empty() || found[i] == expected[i]);
+	}
+}
+
+bool report(
+	const std::string& name,
+	size_t size,
+	size_t runs,
+	const std::function<result()>& f)
+{
+	result best;
+	for (size_t i = 0; i < runs; ++i)
+	{
+		const auto r = f();
+		if (i == 0 || r.all_ms < best.all_ms)
+			best = r;
+		best.correct = best.correct && r.correct;
+	}
+
+	const auto ms = [](double v) {
+		return v < 0 ? std::string{"-"} : fmt::format("{:.2f}", v);
+	};
+
+	fmt::print(
+		"{:<28} {:>10.2f} {:>10} {:>10} {:>6} {:>10} {}\n",
+		name,
+		static_cast<double>(size) / (best.all_ms / 1000.0) / (1 << 30),
+		ms(best.first_ms),
+		ms(best.all_ms),
+		best.found,
+		peak_memory() >> 20,
+		best.correct ? "" : "MISMATCH");
+	return best.correct;
+}
+
+} // namespace shugoconsole::bench
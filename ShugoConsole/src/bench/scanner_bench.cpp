@@ -0,0 +1,460 @@
+#include "bench/bench.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "shugoconsole/cry/cvar_liveness.hpp"
+#include "shugoconsole/cry/cvar_registry.hpp"
+#include "shugoconsole/cry/heap_blocks.hpp"
+#include "shugoconsole/cry/incremental_region_source.hpp"
+#include "shugoconsole/cry/match_filters.hpp"
+#include "shugoconsole/cry/memory.hpp"
+#include "shugoconsole/cry/region_policy.hpp"
+#include "shugoconsole/cry/slot_filter.hpp"
+#include "testing/fake_cvars.hpp"
+#include "testing/process_heap.hpp"
+
+namespace shugoconsole::bench
+{
+
+using namespace testing;
+
+namespace
+{
+
+// Old approach, one scan per CVar
+result bench_per_variable(
+	cry::region_source& source,
+	const std::vector<cry::cvar*>& expected,
+	std::vector<std::byte>& buffer)
+{
+	result r;
+	std::vector<cry::cvar*> found;
+
+	const auto start = clock_type::now();
+	for (const auto& name : TARGET_NAMES)
+	{
+		const cry::cvar::pattern_set patterns{{cry::cvar::pattern{name}}};
+		found.push_back(cry::find_cvar_ptrs(source, patterns, buffer).front());
+		if (found.back() && r.first_ms < 0)
+			r.first_ms = elapsed_ms(start);
+	}
+	r.all_ms = elapsed_ms(start);
+
+	check(r, found, expected);
+	return r;
+}
+
+result bench_find(
+	cry::region_source& source,
+	const std::vector<cry::cvar*>& expected,
+	std::vector<std::byte>& buffer,
+	cry::scan_mode mode,
+	unsigned threads,
+	std::optional<cry::cvar::vtable_range> vtables = std::nullopt)
+{
+	cry::scan_options options;
+	options.mode = mode;
+	options.threads = threads;
+	options.vtables = vtables;
+
+	result r;
+	const auto start = clock_type::now();
+	const auto found = cry::find_cvar_ptrs(
+		source, cry::cvar::pattern_set{target_patterns()}, buffer, options);
+	r.all_ms = elapsed_ms(start);
+
+	check(r, found, expected);
+	return r;
+}
+
+// Every match of the targets, the first one accepted by filter is kept
+result bench_all_matches(
+	cry::region_source& source,
+	const std::vector<cry::cvar*>& expected,
+	std::vector<std::byte>& buffer,
+	const cry::match_filter& filter)
+{
+	result r;
+	const auto start = clock_type::now();
+
+	std::vector<cry::cvar*> found(TARGET_NAMES.size());
+	for (const auto& match : cry::cvar_matches{
+			 source, cry::cvar::pattern_set{target_patterns()}, buffer, filter})
+	{
+		if (found[match.pattern] == nullptr)
+			found[match.pattern] = match.var;
+	}
+	r.all_ms = elapsed_ms(start);
+
+	check(r, found, expected);
+	return r;
+}
+
+// Targets and missing names scanned together, optionally with the vtables
+// of the CVars found by a previous scan
+result bench_many_patterns(
+	cry::region_source& source,
+	const std::vector<cry::cvar*>& expected,
+	std::vector<std::byte>& buffer,
+	std::optional<cry::cvar::vtable_range> vtables)
+{
+	auto patterns = target_patterns();
+	patterns.insert(patterns.end(), MISSING_NAMES.begin(), MISSING_NAMES.end());
+
+	cry::scan_options options;
+	options.vtables = vtables;
+
+	result r;
+	const auto start = clock_type::now();
+	auto found = cry::find_cvar_ptrs(
+		source, cry::cvar::pattern_set{std::move(patterns)}, buffer, options);
+	r.all_ms = elapsed_ms(start);
+
+	found.resize(TARGET_NAMES.size());
+	check(r, found, expected);
+	return r;
+}
+
+// Resumable scanner stepped one slice at a time to time the matches
+result bench_scanner(
+	cry::region_source& source,
+	const std::vector<cry::cvar*>& expected,
+	std::vector<std::byte>& buffer,
+	cry::scan_mode mode)
+{
+	cry::scan_options options;
+	options.mode = mode;
+
+	result r;
+	const auto start = clock_type::now();
+	cry::scanner scanner{
+		source, cry::cvar::pattern_set{target_patterns()}, buffer, options};
+
+	cry::scan_budget budget;
+	budget.bytes = cry::scan_budget::slice_size;
+
+	while (!scanner.step(budget))
+	{
+		if (r.first_ms < 0)
+		{
+			const auto found = scanner.results();
+			if (std::any_of(
+					found.begin(), found.end(), [](const cry::cvar* var) {
+						return var != nullptr;
+					}))
+			{
+				r.first_ms = elapsed_ms(start);
+			}
+		}
+	}
+	r.all_ms = elapsed_ms(start);
+
+	check(r, scanner.results(), expected);
+	return r;
+}
+
+// First CVar found by the scanner, the anchor of the registry search
+cry::cvar* find_anchor(
+	cry::region_source& source, std::vector<std::byte>& buffer)
+{
+	cry::scanner scanner{
+		source, cry::cvar::pattern_set{target_patterns()}, buffer};
+
+	cry::scan_budget budget;
+	budget.bytes = cry::scan_budget::slice_size;
+
+	for (;;)
+	{
+		const bool finished = scanner.step(budget);
+		for (auto* var : scanner.results())
+		{
+			if (var)
+				return var;
+		}
+
+		if (finished)
+			return nullptr;
+	}
+}
+
+// Registry found from the first CVar found, then every target looked up
+result bench_registry(
+	cry::region_source& source,
+	const std::vector<cry::cvar*>& expected,
+	std::vector<std::byte>& buffer)
+{
+	result r;
+	const auto start = clock_type::now();
+
+	const auto anchor = find_anchor(source, buffer);
+	if (anchor)
+		r.first_ms = elapsed_ms(start);
+
+	const auto registry =
+		anchor ? cry::cvar_registry::find(source, anchor) : std::nullopt;
+
+	std::vector<cry::cvar*> found;
+	for (const auto& name : TARGET_NAMES)
+		found.push_back(registry ? registry->lookup(name) : nullptr);
+	r.all_ms = elapsed_ms(start);
+
+	check(r, found, expected);
+	return r;
+}
+
+// Walk of a registry already found, then every target looked up
+result bench_registry_refresh(
+	cry::region_source& source,
+	const std::vector<cry::cvar*>& expected,
+	std::vector<std::byte>& buffer)
+{
+	const auto anchor = find_anchor(source, buffer);
+	auto registry =
+		anchor ? cry::cvar_registry::find(source, anchor) : std::nullopt;
+
+	result r;
+	const auto start = clock_type::now();
+
+	std::vector<cry::cvar*> found;
+	const bool valid = registry && registry->refresh(source);
+	for (const auto& name : TARGET_NAMES)
+		found.push_back(valid ? registry->lookup(name) : nullptr);
+	r.all_ms = elapsed_ms(start);
+
+	check(r, found, expected);
+	return r;
+}
+
+// Second pass over unchanged memory, through the incremental source
+result bench_incremental(
+	cry::region_source& source, std::vector<std::byte>& buffer)
+{
+	cry::incremental_region_source incremental{source};
+
+	// Nothing is found in the first pass so that it covers all regions
+	const cry::cvar::pattern_set missing{{cry::cvar::pattern{"bench_missing"}}};
+	cry::find_cvar_ptrs(incremental, missing, buffer);
+
+	result r;
+	const auto start = clock_type::now();
+	const auto found = cry::find_cvar_ptrs(incremental, missing, buffer);
+	r.all_ms = elapsed_ms(start);
+	r.correct = found.front() == nullptr;
+	return r;
+}
+
+// Bytes of the regions of source
+size_t region_bytes(cry::region_source& source)
+{
+	size_t bytes = 0;
+	cry::region r;
+	source.reset();
+	while (source.next(r))
+		bytes += r.size;
+	return bytes;
+}
+
+} // namespace
+
+bool run_scanner_benchmarks(
+	cry::region_source& source,
+	size_t size,
+	const std::vector<cry::cvar*>& expected,
+	size_t runs)
+{
+	fmt::print(
+		"Slot filter: {}, {:d} hardware threads, best of {:d} runs\n\n",
+		cry::slot_filter::isa_name(cry::slot_filter::best_isa()),
+		std::thread::hardware_concurrency(),
+		runs);
+
+	fmt::print(
+		"{:<28} {:>10} {:>10} {:>10} {:>6} {:>10}\n",
+		"benchmark",
+		"GB/s",
+		"first ms",
+		"all ms",
+		"found",
+		"peak MB");
+
+	bool correct = true;
+	std::vector<std::byte> buffer(64 * 1024);
+	const unsigned allThreads =
+		std::max(1u, std::thread::hardware_concurrency());
+
+	correct &= report("find_cvar_ptr per variable", size, runs, [&] {
+		return bench_per_variable(source, expected, buffer);
+	});
+	correct &= report("find_cvar_ptrs copy", size, runs, [&] {
+		return bench_find(source, expected, buffer, cry::scan_mode::copy, 1);
+	});
+	correct &= report("find_cvar_ptrs in-place", size, runs, [&] {
+		return bench_find(
+			source, expected, buffer, cry::scan_mode::in_place, 1);
+	});
+
+	// Vtables of the targets, as learned by ShugoConsole after a first scan
+	const auto vtables = cry::cvar::vtable_range::around(cry::find_cvar_ptrs(
+		source, cry::cvar::pattern_set{target_patterns()}, buffer));
+
+	correct &= report("16 patterns", size, runs, [&] {
+		return bench_many_patterns(source, expected, buffer, std::nullopt);
+	});
+	correct &= report("16 patterns vtable filter", size, runs, [&] {
+		return bench_many_patterns(source, expected, buffer, vtables);
+	});
+	correct &= report(
+		fmt::format("find_cvar_ptrs {:d} threads", allThreads),
+		size,
+		runs,
+		[&] {
+			return bench_find(
+				source, expected, buffer, cry::scan_mode::in_place, allThreads);
+		});
+	correct &= report("scanner copy", size, runs, [&] {
+		return bench_scanner(source, expected, buffer, cry::scan_mode::copy);
+	});
+	correct &= report("scanner in-place", size, runs, [&] {
+		return bench_scanner(
+			source, expected, buffer, cry::scan_mode::in_place);
+	});
+
+	// Regions ordered by the statistics of a previous run
+	cry::region_policy policy;
+	policy.record(
+		source,
+		cry::find_cvar_ptrs(
+			source, cry::cvar::pattern_set{target_patterns()}, buffer));
+	cry::prioritized_region_source ordered{source, policy};
+
+	correct &= report("scanner policy order", size, runs, [&] {
+		return bench_scanner(
+			ordered, expected, buffer, cry::scan_mode::in_place);
+	});
+	correct &= report("registry search", size, runs, [&] {
+		return bench_registry(source, expected, buffer);
+	});
+	correct &= report("registry refresh", size, runs, [&] {
+		return bench_registry_refresh(source, expected, buffer);
+	});
+	correct &= report("incremental unchanged pass", size, runs, [&] {
+		return bench_incremental(source, buffer);
+	});
+	return correct;
+}
+
+bool run_process_benchmarks(size_t runs)
+{
+	const auto setupStart = clock_type::now();
+	process_heap heap{20000, 32, 4 << 20, 42};
+	const auto setupMs = elapsed_ms(setupStart);
+
+	const auto regions = cry::make_process_region_source();
+	const auto blocks = cry::make_heap_block_source();
+	const auto regionSize = region_bytes(*regions);
+	const auto blockSize = region_bytes(*blocks);
+
+	fmt::print(
+		"\nProcess heap: built in {:.0f} ms, regions {:d} MB, heap blocks "
+		"{:d} MB ({:.1f}x fewer bytes)\n\n",
+		setupMs,
+		regionSize >> 20,
+		blockSize >> 20,
+		static_cast<double>(regionSize) / std::max<size_t>(blockSize, 1));
+
+	// The vtable filter rejects the stale copies
+	const auto vtables = cry::cvar::vtable_range::around(heap.targets());
+	const auto filter = cry::match_filters::all_of(
+		{cry::match_filters::layout(), cry::match_filters::vtable(*vtables)});
+
+	bool correct = true;
+	std::vector<std::byte> buffer(64 * 1024);
+	correct &= report("process regions", regionSize, runs, [&] {
+		return bench_find(
+			*regions,
+			heap.targets(),
+			buffer,
+			cry::scan_mode::in_place,
+			1,
+			vtables);
+	});
+	correct &= report("heap blocks", blockSize, runs, [&] {
+		return bench_find(
+			*blocks,
+			heap.targets(),
+			buffer,
+			cry::scan_mode::in_place,
+			1,
+			vtables);
+	});
+	// Not checked: without the vtables, the first matches are the stale
+	// copies
+	report("process regions first match", regionSize, runs, [&] {
+		return bench_find(*regions, {}, buffer, cry::scan_mode::in_place, 1);
+	});
+	correct &= report("process regions all matches", regionSize, runs, [&] {
+		return bench_all_matches(*regions, heap.targets(), buffer, filter);
+	});
+
+	// Check run on every CVar before it is written to
+	constexpr size_t checks = 100000;
+	const auto checkStart = clock_type::now();
+	size_t alive = 0;
+	for (size_t i = 0; i < checks; ++i)
+	{
+		const auto index = i % TARGET_NAMES.size();
+		const auto var = heap.targets()[index];
+		alive += cry::check_liveness(
+					 *regions,
+					 cry::cvar::pattern{TARGET_NAMES[index]},
+					 var,
+					 reinterpret_cast<std::uintptr_t>(var->dummy0)) ==
+				 cry::liveness::alive;
+	}
+	fmt::print(
+		"\nLiveness check: {:.0f} ns per CVar, {:d}/{:d} alive{}\n",
+		elapsed_ms(checkStart) * 1e6 / checks,
+		alive,
+		checks,
+		alive == checks ? "" : " (MISMATCH)");
+
+	// Re-resolution of a reallocated CVar, around its old address then
+	// everywhere
+	const auto old = heap.targets().front();
+	const auto vtable = reinterpret_cast<std::uintptr_t>(old->dummy0);
+	const auto moved = heap.move_target(0);
+	const cry::cvar::pattern pattern{TARGET_NAMES.front()};
+
+	const auto nearStart = clock_type::now();
+	const auto nearFound = cry::resolve_moved_cvar(
+		*regions, pattern, old, vtable, buffer, 16 << 20, false);
+	const auto nearMs = elapsed_ms(nearStart);
+
+	const auto fullStart = clock_type::now();
+	const auto fullFound = cry::resolve_moved_cvar(
+		*regions, pattern, old, vtable, buffer, 0, true);
+	const auto fullMs = elapsed_ms(fullStart);
+
+	fmt::print(
+		"Moved by {:d} KB: {} in {:.2f} ms around the old address, {} in "
+		"{:.2f} ms in all regions\n",
+		static_cast<size_t>(std::abs(
+			reinterpret_cast<std::intptr_t>(moved) -
+			reinterpret_cast<std::intptr_t>(old))) >> 10,
+		nearFound == moved ? "found" : "not found",
+		nearMs,
+		fullFound == moved ? "found" : "NOT found",
+		fullMs);
+
+	// The CVar may have moved further than the search around the old address
+	return correct && alive == checks && fullFound == moved;
+}
+
+} // namespace shugoconsole::bench
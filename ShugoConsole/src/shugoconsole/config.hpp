@@ -7,6 +7,7 @@
 #include <optional>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -341,6 +342,468 @@ class string final
 
 } // namespace types
 
+// Readers of the optional keys of a settings table, invalid values are
+// logged and leave value unchanged
+namespace settings_reader
+{
+
+inline void read_integer(
+	const toml::value& table,
+	const char* tableName,
+	const char* key,
+	int min,
+	int max,
+	unsigned& value)
+{
+	try
+	{
+		const auto v = toml::find(table, key);
+		if (v.is_integer() && v.as_integer() >= min &&
+			v.as_integer() <= max)
+		{
+			value = static_cast<unsigned>(v.as_integer());
+			log::info("{}.{}={}", tableName, key, value);
+		}
+		else
+		{
+			log::error(
+				"'{}.{}': '{}' is not a valid value. It should be an "
+				"integer between {} and {}.",
+				tableName,
+				key,
+				toml::format(v),
+				min,
+				max);
+		}
+	}
+	catch (std::out_of_range&) // key not found
+	{
+	}
+}
+
+inline void read_string(
+	const toml::value& table,
+	const char* tableName,
+	const char* key,
+	std::string& value)
+{
+	try
+	{
+		const auto v = toml::find(table, key);
+		if (v.is_string())
+		{
+			value = v.as_string();
+			log::info("{}.{}={}", tableName, key, value);
+		}
+		else
+		{
+			log::error(
+				"'{}.{}': '{}' is not a valid value. It should be a "
+				"string.",
+				tableName,
+				key,
+				toml::format(v));
+		}
+	}
+	catch (std::out_of_range&) // key not found
+	{
+	}
+}
+
+inline void read_boolean(
+	const toml::value& table,
+	const char* tableName,
+	const char* key,
+	bool& value)
+{
+	try
+	{
+		const auto v = toml::find(table, key);
+		if (v.is_boolean())
+		{
+			value = v.as_boolean();
+			log::info("{}.{}={}", tableName, key, value);
+		}
+		else
+		{
+			log::error(
+				"'{}.{}': '{}' is not a valid value. It should be a "
+				"boolean.",
+				tableName,
+				key,
+				toml::format(v));
+		}
+	}
+	catch (std::out_of_range&) // key not found
+	{
+	}
+}
+
+} // namespace settings_reader
+
+// Settings of the CVar memory scanner, read from the [scanner] table
+struct scanner_settings final
+{
+	// Priority of the thread while it scans memory
+	enum class thread_priority
+	{
+		normal,
+		below_normal,
+		lowest,
+		idle
+	};
+
+	// Number of threads scanning memory, 0 to use every core
+	unsigned threads = 1;
+
+	// Budget of a single scan step, the scan runs in one go if both are 0
+	// Time-sliced scans run on a single thread
+	unsigned step_bytes = 0;
+	unsigned step_time_us = 0;
+
+	// Wait between two scan steps
+	unsigned step_pause_ms = 1;
+
+	thread_priority priority = thread_priority::normal;
+
+	// Only scan the live heap blocks of CVar size, except every few scans
+	// that scan all regions in case CVars are outside of the heaps
+	bool heap_blocks = false;
+
+	// Scan all memory and keep the first match of each CVar that looks live,
+	// instead of stopping at the first matches, which may be stale copies
+	// Ignored by time-sliced scans
+	bool all_matches = false;
+
+	// Regions at least this large are skipped once previous runs found that
+	// they never hold CVars, 0 to scan them all
+	unsigned large_region_mb = 64;
+
+	// If not empty, the candidate regions are dumped to this file before the
+	// first scan, to replay them offline
+	std::string dump_path;
+
+	bool time_sliced() const { return step_bytes != 0 || step_time_us != 0; }
+
+	static scanner_settings from_toml(const toml::value& root)
+	{
+		scanner_settings settings;
+
+		try
+		{
+			const auto& table = toml::find(root, "scanner");
+
+			using namespace settings_reader;
+			read_integer(table, "scanner", "threads", 0, 64, settings.threads);
+			read_integer(
+				table,
+				"scanner",
+				"step_bytes",
+				0,
+				1 << 30,
+				settings.step_bytes);
+			read_integer(
+				table,
+				"scanner",
+				"step_time_us",
+				0,
+				1000000,
+				settings.step_time_us);
+			read_integer(
+				table,
+				"scanner",
+				"step_pause_ms",
+				0,
+				1000,
+				settings.step_pause_ms);
+			read_priority(table, settings.priority);
+			read_boolean(table, "scanner", "heap_blocks", settings.heap_blocks);
+			read_boolean(table, "scanner", "all_matches", settings.all_matches);
+			read_integer(
+				table,
+				"scanner",
+				"large_region_mb",
+				0,
+				1 << 20,
+				settings.large_region_mb);
+			read_string(table, "scanner", "dump_path", settings.dump_path);
+		}
+		catch (std::out_of_range&) // table not found
+		{
+		}
+		catch (toml::exception& e)
+		{
+			log::error("'scanner': error while reading value: {}", e.what());
+		}
+
+		return settings;
+	}
+
+private:
+	static void read_priority(const toml::value& table, thread_priority& value)
+	{
+		constexpr std::pair<const char*, thread_priority> priorities[] = {
+			{"normal", thread_priority::normal},
+			{"below_normal", thread_priority::below_normal},
+			{"lowest", thread_priority::lowest},
+			{"idle", thread_priority::idle}};
+
+		try
+		{
+			const auto v = toml::find(table, "priority");
+			if (v.is_string())
+			{
+				const std::string& name = v.as_string();
+				for (const auto& p : priorities)
+				{
+					if (name == p.first)
+					{
+						value = p.second;
+						log::info("scanner.priority={}", p.first);
+						return;
+					}
+				}
+			}
+
+			log::error(
+				"'scanner.priority': '{}' is not a valid value. It should be "
+				"one of: normal, below_normal, lowest, idle.",
+				toml::format(v));
+		}
+		catch (std::out_of_range&) // key not found
+		{
+		}
+	}
+};
+
+// Settings of the loop applying the configured values, read from the
+// [enforcement] table
+struct enforcement_settings final
+{
+	// Make the pages of the CVars read-only and apply the values when they
+	// are written to, instead of checking every CVar every 100 ms
+	// The pages are shared with other heap data: writes by the kernel to
+	// them fail, and other writes fault once per check. This is opt-in
+	bool write_watch = false;
+
+	// Longest wait between two checks of the CVars when write_watch is set
+	unsigned write_watch_check_ms = 2000;
+
+	// Without write_watch, the wait between two checks doubles from
+	// check_min_ms up to check_max_ms while the values stay in place, and
+	// drops back to check_min_ms once the game overwrites one of them
+	unsigned check_min_ms = 100;
+	unsigned check_max_ms = 3200;
+
+	// Detour the Set methods of the CVar classes, so that the engine can't
+	// change the continuously checked CVars: its Sets get the configured
+	// value, or are dropped with set_hooks_reject
+	// A wrong slot hooks another method, so this is opt-in
+	bool set_hooks = false;
+	bool set_hooks_reject = false;
+
+	// Slots of Set(const char*), Set(float) and Set(int) in the vtable of
+	// ICVar: MSVC places overloads next to each other in reverse order,
+	// after the destructor, Release, GetIVal, GetFVal and GetString
+	unsigned set_string_slot = 7;
+	unsigned set_float_slot = 6;
+	unsigned set_int_slot = 5;
+
+	static enforcement_settings from_toml(const toml::value& root)
+	{
+		enforcement_settings settings;
+
+		try
+		{
+			const auto& table = toml::find(root, "enforcement");
+
+			using namespace settings_reader;
+			read_boolean(
+				table, "enforcement", "write_watch", settings.write_watch);
+			read_integer(
+				table,
+				"enforcement",
+				"write_watch_check_ms",
+				100,
+				60000,
+				settings.write_watch_check_ms);
+			read_integer(
+				table,
+				"enforcement",
+				"check_min_ms",
+				10,
+				60000,
+				settings.check_min_ms);
+			read_integer(
+				table,
+				"enforcement",
+				"check_max_ms",
+				10,
+				60000,
+				settings.check_max_ms);
+			read_boolean(
+				table, "enforcement", "set_hooks", settings.set_hooks);
+			read_boolean(
+				table,
+				"enforcement",
+				"set_hooks_reject",
+				settings.set_hooks_reject);
+			read_integer(
+				table,
+				"enforcement",
+				"set_string_slot",
+				0,
+				255,
+				settings.set_string_slot);
+			read_integer(
+				table,
+				"enforcement",
+				"set_float_slot",
+				0,
+				255,
+				settings.set_float_slot);
+			read_integer(
+				table,
+				"enforcement",
+				"set_int_slot",
+				0,
+				255,
+				settings.set_int_slot);
+		}
+		catch (std::out_of_range&) // table not found
+		{
+		}
+		catch (toml::exception& e)
+		{
+			log::error(
+				"'enforcement': error while reading value: {}", e.what());
+		}
+
+		return settings;
+	}
+};
+
+// Settings of the hook recording the CVars as the engine registers them, read
+// from the [registration] table
+struct registration_settings final
+{
+	// Detour the function of module through which the console registers its
+	// CVars, found by its signature, e.g. "48 89 5C 24 ?? 57 48 83 EC 20"
+	// Memory is only scanned once module is loaded, for the CVars that were
+	// not recorded
+	bool hook = false;
+	std::string module = "CrySystem.dll";
+	std::string signature;
+
+	static registration_settings from_toml(const toml::value& root)
+	{
+		registration_settings settings;
+
+		try
+		{
+			const auto& table = toml::find(root, "registration");
+
+			using namespace settings_reader;
+			read_boolean(table, "registration", "hook", settings.hook);
+			read_string(table, "registration", "module", settings.module);
+			read_string(
+				table, "registration", "signature", settings.signature);
+		}
+		catch (std::out_of_range&) // table not found
+		{
+		}
+		catch (toml::exception& e)
+		{
+			log::error(
+				"'registration': error while reading value: {}", e.what());
+		}
+
+		return settings;
+	}
+};
+
+// When the configured value of a variable is written to its CVar
+struct enforcement_policy final
+{
+	enum class mode
+	{
+		// Whenever the game changes the CVar
+		continuous,
+		// Once after the CVar is found, and once more if the configured value
+		// changes. The CVar is checked to still exist every 10 s
+		once,
+		// Once after the CVar is found, and again after every change of the
+		// configuration file. The CVar is checked to still exist every 10 s
+		on_config_change,
+		// Whenever the game changes the CVar, checked at most once every
+		// interval_ms
+		rate_limited
+	};
+
+	mode when = mode::continuous;
+	unsigned interval_ms = 1000;
+
+	// true if the CVar is checked between two changes of the configuration
+	bool checked_continuously() const
+	{
+		return when == mode::continuous || when == mode::rate_limited;
+	}
+
+	static const char* name(mode m)
+	{
+		switch (m)
+		{
+		case mode::once:
+			return "once";
+		case mode::on_config_change:
+			return "on_config_change";
+		case mode::rate_limited:
+			return "rate_limited";
+		default:
+			return "continuous";
+		}
+	}
+
+	// Reads the policy keys of the table of a variable, invalid values are
+	// logged and leave the policy unchanged
+	void read(const toml::value& table, const std::string& varName)
+	{
+		constexpr mode modes[] = {
+			mode::continuous,
+			mode::once,
+			mode::on_config_change,
+			mode::rate_limited};
+
+		try
+		{
+			const auto v = toml::find(table, "policy");
+			const auto it =
+				std::find_if(std::begin(modes), std::end(modes), [&](mode m) {
+					return v.is_string() && v.as_string() == name(m);
+				});
+			if (it != std::end(modes))
+			{
+				when = *it;
+			}
+			else
+			{
+				log::error(
+					"'{}.policy': '{}' is not a valid value. It should be "
+					"one of: continuous, once, on_config_change, "
+					"rate_limited.",
+					varName,
+					toml::format(v));
+			}
+		}
+		catch (std::out_of_range&) // key not found
+		{
+		}
+
+		settings_reader::read_integer(
+			table, varName.c_str(), "interval_ms", 10, 3600000, interval_ms);
+	}
+};
+
 class configuration final
 {
 public:
@@ -361,6 +824,8 @@ class configuration final
 
 		std::string name;
 		type_variant type;
+		// Used when the configuration file doesn't set one
+		enforcement_policy policy{};
 	};
 
 	using variable_definition_set = std::initializer_list<variable_definition>;
@@ -369,9 +834,13 @@ class configuration final
 	{
 		const variable_definition def;
 		std::optional<cry::cvar::value> opt_value;
+		enforcement_policy policy = def.policy;
 	};
 
 	std::vector<variable> vars;
+	scanner_settings scanner;
+	enforcement_settings enforcement;
+	registration_settings registration;
 
 	// Creates a configuration with empty values
 	explicit configuration(variable_definition_set var_set)
@@ -390,8 +859,9 @@ class configuration final
 		std::filesystem::path configPath)
 	{
 		// Use ifstream to open file because toml11 does not
-		// support wchar_t filenames
-		std::ifstream configStream{configPath.wstring()};
+		// support wchar_t filenames, the path overload opens wide
+		// filenames on Windows and builds everywhere
+		std::ifstream configStream{configPath};
 
 		if (!configStream.is_open())
 		{
@@ -410,7 +880,15 @@ class configuration final
 			{
 				try
 				{
-					const auto toml_value = toml::find(root, var.def.name);
+					// Either the value or a table with the value and the
+					// policy
+					auto toml_value = toml::find(root, var.def.name);
+					if (toml_value.is_table())
+					{
+						var.policy.read(toml_value, var.def.name);
+						toml_value = toml::find(toml_value, "value");
+					}
+
 					const auto result = std::visit(
 						[&](const auto& t) { return t.from_toml(toml_value); },
 						var.def.type);
@@ -420,9 +898,10 @@ class configuration final
 						var.opt_value = result.value();
 
 						log::info(
-							"{}={}",
+							"{}={} ({})",
 							var.def.name,
-							cry::to_string(var.opt_value.value()));
+							cry::to_string(var.opt_value.value()),
+							enforcement_policy::name(var.policy.when));
 					}
 					else
 					{
@@ -448,6 +927,10 @@ class configuration final
 				}
 			}
 
+			cfg.scanner = scanner_settings::from_toml(root);
+			cfg.enforcement = enforcement_settings::from_toml(root);
+			cfg.registration = registration_settings::from_toml(root);
+
 			return cfg;
 		}
 		catch (toml::exception& e)
@@ -0,0 +1,87 @@
+#include "shugoconsole/cry/address_hint.hpp"
+#include "shugoconsole/log.hpp"
+
+#include <array>
+
+namespace shugoconsole::cry
+{
+
+std::vector<std::optional<address_hint>> make_address_hints(
+	region_source& source, const std::vector<cvar*>& vars)
+{
+	std::vector<std::optional<address_hint>> hints(vars.size());
+
+	source.reset();
+
+	region candidate{};
+	while (source.next(candidate))
+	{
+		for (size_t i = 0; i < vars.size(); ++i)
+		{
+			const auto address = reinterpret_cast<std::byte*>(vars[i]);
+			if (address >= candidate.base &&
+				address < candidate.base + candidate.size)
+			{
+				hints[i] = address_hint{static_cast<std::uintptr_t>(
+					address - candidate.allocation_base)};
+			}
+		}
+	}
+
+	return hints;
+}
+
+std::vector<cvar*> resolve_address_hints(
+	region_source& source,
+	const cvar::pattern_set& patterns,
+	const std::vector<std::optional<address_hint>>& hints)
+{
+	std::vector<cvar*> results(patterns.size(), nullptr);
+	size_t remaining = 0;
+	for (size_t i = 0; i < patterns.size(); ++i)
+		remaining += hints[i] ? 1 : 0;
+
+	// Large enough for the longest possible pattern
+	std::array<std::byte, sizeof(cvar)> buffer;
+
+	source.reset();
+
+	region candidate{};
+	while (remaining && source.next(candidate))
+	{
+		for (size_t i = 0; i < patterns.size(); ++i)
+		{
+			if (results[i] || !hints[i])
+				continue;
+
+			const auto& pattern = patterns[i];
+			const auto address =
+				candidate.allocation_base + hints[i]->allocation_offset;
+
+			if (address < candidate.base ||
+				address + pattern.size() > candidate.base + candidate.size)
+			{
+				continue;
+			}
+
+			// Read through the source, the memory is not scanned yet and may
+			// not be readable anymore
+			if (source.read(address, buffer.data(), pattern.size()) ==
+					pattern.size() &&
+				pattern.match(
+					static_cast<const cvar*>(static_cast<void*>(buffer.data()))))
+			{
+				log::trace(
+					"Address hint of {} matched at {}",
+					pattern.name(),
+					static_cast<void*>(address));
+				results[i] = static_cast<cvar*>(static_cast<void*>(address));
+				--remaining;
+			}
+		}
+	}
+
+	return results;
+}
+
+} // namespace shugoconsole::cry
@@ -0,0 +1,38 @@
+#ifndef SHUGOCONSOLE_CRY_ADDRESS_HINT_HPP
+#define SHUGOCONSOLE_CRY_ADDRESS_HINT_HPP
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "shugoconsole/cry/cvar.hpp"
+#include "shugoconsole/cry/region_source.hpp"
+
+namespace shugoconsole::cry
+{
+
+// Location of a CVar relative to the allocation it was found in
+// The same client build allocates its CVars at the same offsets, hints can
+// be saved and checked on the next run before scanning memory
+struct address_hint
+{
+	// Offset of the CVar from the base address of its allocation
+	std::uintptr_t allocation_offset;
+};
+
+// Makes a hint for each CVar of vars, nullptr entries get no hint
+std::vector<std::optional<address_hint>> make_address_hints(
+	region_source& source, const std::vector<cvar*>& vars);
+
+// Tests the addresses predicted by hints, in the same order as patterns,
+// with a direct match of the pattern
+// Every candidate allocation of source is tried without scanning it
+// Returns the address of each CVar found, or nullptr
+std::vector<cvar*> resolve_address_hints(
+	region_source& source,
+	const cvar::pattern_set& patterns,
+	const std::vector<std::optional<address_hint>>& hints);
+
+} // namespace shugoconsole::cry
+
+#endif // SHUGOCONSOLE_CRY_ADDRESS_HINT_HPP
@@ -0,0 +1,48 @@
+#ifndef SHUGOCONSOLE_CRY_CHECK_INTERVAL_HPP
+#define SHUGOCONSOLE_CRY_CHECK_INTERVAL_HPP
+
+#include <algorithm>
+#include <chrono>
+
+namespace shugoconsole::cry
+{
+
+// Time between two checks of the CVars: doubles after every check that found
+// the values in place, up to max, and drops back to min as soon as one of them
+// was overwritten
+class check_interval final
+{
+public:
+	check_interval(
+		std::chrono::milliseconds min, std::chrono::milliseconds max) :
+		min_{min},
+		max_{std::max(min, max)},
+		current_{min}
+	{
+	}
+
+	// Time to wait after a check, overridden is true if the check had to
+	// write a value again
+	std::chrono::milliseconds next(bool overridden) noexcept
+	{
+		if (overridden)
+			current_ = min_;
+		else
+			current_ = std::min(current_ * 2, max_);
+		return current_;
+	}
+
+	// Checks again at min, for instance once the values to apply changed
+	void reset() noexcept { current_ = min_; }
+
+	std::chrono::milliseconds current() const noexcept { return current_; }
+
+private:
+	std::chrono::milliseconds min_;
+	std::chrono::milliseconds max_;
+	std::chrono::milliseconds current_;
+};
+
+} // namespace shugoconsole::cry
+
+#endif // SHUGOCONSOLE_CRY_CHECK_INTERVAL_HPP
@@ -1 +1,120 @@
 #include "shugoconsole/cry/cvar.hpp"
+
+namespace shugoconsole::cry
+{
+
+static std::uint32_t load_key(const char* name)
+{
+	std::uint32_t key;
+	std::memcpy(&key, name, sizeof(key));
+	return key;
+}
+
+cvar::pattern_set::pattern_set(std::vector<pattern> patterns) :
+	patterns_{std::move(patterns)}
+{
+	// Keep the load factor at 50% at most so that probing stays short
+	size_t capacity = 4;
+	shift_ = 32 - 2;
+	while (capacity < patterns_.size() * 2)
+	{
+		capacity *= 2;
+		--shift_;
+	}
+	table_.assign(capacity, entry{0, npos});
+
+	for (size_t i = 0; i < patterns_.size(); ++i)
+	{
+		const std::string name = patterns_[i].name();
+		const size_t size = patterns_[i].size();
+
+		min_size_ = i == 0 ? size : std::min(min_size_, size);
+		max_size_ = std::max(max_size_, size);
+
+		// Bytes after the null character are unknown in memory, only names
+		// whose key fits before or on the null character can be hashed
+		if (name.size() + 1 < key_size)
+		{
+			short_patterns_.push_back(i);
+			continue;
+		}
+
+		const auto key = load_key(name.c_str());
+		size_t b = bucket(key);
+		while (table_[b].index != npos)
+			b = (b + 1) & (table_.size() - 1);
+		table_[b] = entry{key, i};
+	}
+}
+
+size_t cvar::pattern_set::bucket(std::uint32_t key) const noexcept
+{
+	// Fibonacci hashing
+	return static_cast<size_t>((key * 2654435769u) >> shift_);
+}
+
+size_t cvar::pattern_set::match(const std::byte* slot, size_t available) const
+{
+	if (available < min_size_)
+		return npos;
+
+	// It's ok to alias to cvar* here since slot points to std::byte
+	// and this type is an exception to the C/C++ aliasing rules
+	const auto var = static_cast<const cvar*>(static_cast<const void*>(slot));
+	if (var->cat != 0 && var->cat != 1)
+		return npos;
+
+	if (available >= offsetof(cvar, name) + key_size)
+	{
+		const auto key = load_key(var->name.data());
+		for (size_t b = bucket(key); table_[b].index != npos;
+			 b = (b + 1) & (table_.size() - 1))
+		{
+			const auto& e = table_[b];
+			if (e.key == key && patterns_[e.index].size() <= available &&
+				patterns_[e.index].match(var))
+			{
+				return e.index;
+			}
+		}
+	}
+
+	for (const size_t i : short_patterns_)
+	{
+		if (patterns_[i].size() <= available && patterns_[i].match(var))
+			return i;
+	}
+
+	return npos;
+}
+
+std::optional<cvar::vtable_range> cvar::vtable_range::around(
+	const std::vector<cvar*>& vars, std::uintptr_t margin)
+{
+	std::optional<vtable_range> range;
+
+	for (const auto var : vars)
+	{
+		if (var == nullptr)
+			continue;
+
+		const auto vtable = reinterpret_cast<std::uintptr_t>(var->dummy0);
+		if (!range)
+			range = vtable_range{vtable, vtable};
+
+		range->first = std::min(range->first, vtable);
+		range->last = std::max(range->last, vtable);
+	}
+
+	if (range)
+	{
+		range->first = range->first > margin ? range->first - margin : 0;
+		range->last = range->last < UINTPTR_MAX - margin ?
+			range->last + margin :
+			UINTPTR_MAX;
+	}
+
+	return range;
+}
+
+} // namespace shugoconsole::cry
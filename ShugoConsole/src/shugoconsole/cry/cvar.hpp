@@ -4,14 +4,35 @@
 #include <algorithm>
 #include <array>
 #include <charconv>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <variant>
+#include <vector>
 
 namespace shugoconsole::cry
 {
 
+// Size of a buffer holding any int or float formatted by format_number
+constexpr size_t max_number_size = 64;
+
+// Formats i like std::to_string, returns the end of the characters written
+inline char* format_number(char* first, char* last, int i)
+{
+	return std::to_chars(first, last, i).ptr;
+}
+
+// Formats f like std::to_string, "%f", returns the end of the characters
+// written
+inline char* format_number(char* first, char* last, float f)
+{
+	return std::to_chars(first, last, f, std::chars_format::fixed, 6).ptr;
+}
+
 // Aion's CryEngine CVar memory model
 // Dummy member types are probably not accurate but they model the gap
 // between name and int_value by abusing memory alignment
@@ -70,6 +91,75 @@ struct cvar final
 		}
 	};
 
+	// Set of patterns matched together during a single memory scan
+	// Patterns are indexed by the first bytes of their name so that testing
+	// a memory slot costs one hash lookup whatever the number of patterns
+	class pattern_set final
+	{
+	public:
+		static constexpr size_t npos = static_cast<size_t>(-1);
+
+		explicit pattern_set(std::vector<pattern> patterns);
+
+		inline size_t size() const noexcept { return patterns_.size(); }
+		inline bool empty() const noexcept { return patterns_.empty(); }
+
+		inline const pattern& operator[](size_t i) const
+		{
+			return patterns_[i];
+		}
+
+		// Smallest and largest pattern::size() of the set
+		inline size_t min_size() const noexcept { return min_size_; }
+		inline size_t max_size() const noexcept { return max_size_; }
+
+		// Index of the pattern matching the cvar starting at slot, or npos
+		// available is the number of readable bytes starting at slot
+		size_t match(const std::byte* slot, size_t available) const;
+
+	private:
+		// Number of name bytes used as hash key
+		static constexpr size_t key_size = sizeof(std::uint32_t);
+
+		struct entry
+		{
+			std::uint32_t key;
+			size_t index;
+		};
+
+		size_t bucket(std::uint32_t key) const noexcept;
+
+		std::vector<pattern> patterns_;
+		// Open addressing hash table of patterns with names of at least
+		// key_size - 1 characters
+		std::vector<entry> table_;
+		size_t shift_ = 0;
+		// Patterns too short to be hashed, tested one by one
+		std::vector<size_t> short_patterns_;
+		size_t min_size_ = 0;
+		size_t max_size_ = 0;
+	};
+
+	// Addresses the vtable pointer (dummy0) of a CVar can take
+	// The vtables of the CVar classes are next to each other in the
+	// read-only data of their module, a range around the ones already seen
+	// also covers the classes that were not seen yet
+	struct vtable_range
+	{
+		std::uintptr_t first;
+		std::uintptr_t last;
+
+		inline bool contains(std::uintptr_t vtable) const noexcept
+		{
+			return vtable >= first && vtable <= last;
+		}
+
+		// Range around the vtables of vars, nullptr entries are ignored
+		// Returns nullopt if vars holds no CVar
+		static std::optional<vtable_range> around(
+			const std::vector<cvar*>& vars, std::uintptr_t margin = 64 * 1024);
+	};
+
 	// Can't be constructed, detroyed, copied or moved
 	// The only way to make a cvar is to get a pointer to an
 	// existing instance in memory
@@ -81,28 +171,38 @@ struct cvar final
 	~cvar() = delete;
 
 	// Set all fields
-	inline void set(int i, float f, const std::string& s)
+	inline void set(int i, float f, std::string_view s)
 	{
 		int_value = i;
 		float_value = f;
+#if defined _MSC_VER
 		::strncpy_s(
 			string_value.data(),
 			string_value.size(),
-			s.c_str(),
-			s.size());
+			s.data(),
+			std::min(s.size(), string_value.size() - 1));
+#else
+		const size_t size = std::min(s.size(), string_value.size() - 1);
+		std::memcpy(string_value.data(), s.data(), size);
+		string_value[size] = '\0';
+#endif
 	}
 
 	// Set int field and cast value for float and string fields
 	inline cvar& operator=(int i)
 	{
-		set(i, float(i), std::to_string(i));
+		std::array<char, max_number_size> s;
+		const auto end = format_number(s.data(), s.data() + s.size(), i);
+		set(i, float(i), {s.data(), static_cast<size_t>(end - s.data())});
 		return *this;
 	}
 
 	// Set float field and cast value for int and string fields
 	inline cvar& operator=(float f)
 	{
-		set(int(f), f, std::to_string(f));
+		std::array<char, max_number_size> s;
+		const auto end = format_number(s.data(), s.data() + s.size(), f);
+		set(int(f), f, {s.data(), static_cast<size_t>(end - s.data())});
 		return *this;
 	}
 
@@ -142,13 +242,13 @@ struct cvar final
 };
 
 // Assert known offsets
-#if defined _M_X64
+#if defined _M_X64 || defined __x86_64__
 static_assert(offsetof(cvar, cat) == 8);
 static_assert(offsetof(cvar, name) == 9);
 static_assert(offsetof(cvar, int_value) == 184);
 static_assert(offsetof(cvar, float_value) == 188);
 static_assert(offsetof(cvar, string_value) == 192);
-#elif defined _M_IX86
+#elif defined _M_IX86 || defined __i386__
 static_assert(offsetof(cvar, cat) == 4);
 static_assert(offsetof(cvar, name) == 5);
 static_assert(offsetof(cvar, int_value) == 160);
@@ -188,7 +288,7 @@ inline bool operator==(const cvar& v, const std::string& s)
 			   std::min(v.string_value.size(), s.size() + 1)) == 0;
 }
 
-inline bool operator==(const cvar& v, cvar::value val)
+inline bool operator==(const cvar& v, const cvar::value& val)
 {
 	return std::visit([&v](auto&& x) { return v == x; }, val);
 }
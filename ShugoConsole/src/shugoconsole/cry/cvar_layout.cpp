@@ -0,0 +1,159 @@
+#include "shugoconsole/cry/cvar_layout.hpp"
+#include "shugoconsole/log.hpp"
+
+#include <array>
+#include <cmath>
+#include <map>
+#include <set>
+
+namespace shugoconsole::cry
+{
+
+namespace
+{
+
+// Offsets of the int, float and string fields
+using offsets = std::array<size_t, 3>;
+
+// Offsets of the fields holding the same non-zero number in the size bytes
+// of window, none of them before first
+std::set<offsets> find_candidates(
+	const std::byte* window, size_t size, size_t first, cvar::type t)
+{
+	std::set<offsets> result;
+	const auto chars = static_cast<const char*>(static_cast<const void*>(window));
+
+	for (size_t s = first; s < size; ++s)
+	{
+		const auto end = static_cast<const char*>(std::memchr(
+			chars + s, '\0', std::min(size - s, max_number_size)));
+		if (end == nullptr || end == chars + s)
+			continue;
+
+		// The whole string has to be a number
+		double number = 0.0;
+		const auto parsed = std::from_chars(chars + s, end, number);
+		if (parsed.ec != std::errc{} || parsed.ptr != end || number == 0.0 ||
+			!std::isfinite(number) || std::abs(number) > 1e9)
+		{
+			continue;
+		}
+		if (t == cvar::type::integer && number != std::trunc(number))
+			continue;
+
+		const auto stringEnd = static_cast<size_t>(end - chars) + 1;
+		const auto outsideString = [&](size_t o) {
+			return o + 4 <= s || o >= stringEnd;
+		};
+
+		const int i = static_cast<int>(number);
+		const float f = static_cast<float>(number);
+		std::vector<size_t> ints;
+		std::vector<size_t> floats;
+		for (size_t o = (first + 3) / 4 * 4; o + 4 <= size; o += 4)
+		{
+			if (!outsideString(o))
+				continue;
+
+			int vi;
+			float vf;
+			std::memcpy(&vi, window + o, sizeof(vi));
+			std::memcpy(&vf, window + o, sizeof(vf));
+			if (vi == i)
+				ints.push_back(o);
+			if (vf == f)
+				floats.push_back(o);
+		}
+
+		for (const auto io : ints)
+		{
+			for (const auto fo : floats)
+			{
+				if (io != fo)
+					result.insert({io, fo, s});
+			}
+		}
+	}
+
+	return result;
+}
+
+} // namespace
+
+std::optional<cvar_layout> probe_layout(
+	region_source& source,
+	const std::vector<layout_sample>& samples,
+	size_t window)
+{
+	constexpr auto native = cvar_layout::native();
+
+	std::vector<std::byte> buffer(window);
+	std::map<offsets, size_t> votes;
+	size_t informative = 0;
+
+	for (const auto& sample : samples)
+	{
+		if (sample.var == nullptr || sample.type == cvar::type::string)
+			continue;
+
+		const auto address =
+			static_cast<const std::byte*>(static_cast<const void*>(sample.var));
+		const auto size = source.read(address, buffer.data(), buffer.size());
+		if (size <= offsetof(cvar, name))
+			continue;
+
+		// Values are after the name, which is found at a fixed offset
+		const auto name =
+			static_cast<const char*>(static_cast<const void*>(buffer.data())) +
+			offsetof(cvar, name);
+		const auto nameEnd = std::memchr(name, '\0', size - offsetof(cvar, name));
+		if (nameEnd == nullptr)
+			continue;
+		const auto first =
+			static_cast<size_t>(static_cast<const char*>(nameEnd) - name) +
+			offsetof(cvar, name) + 1;
+
+		const auto candidates =
+			find_candidates(buffer.data(), size, first, sample.type);
+		if (candidates.empty())
+			continue;
+
+		++informative;
+		for (const auto& c : candidates)
+			++votes[c];
+	}
+
+	if (informative == 0)
+	{
+		log::warn("No CVar holds a number to probe the value layout with");
+		return std::nullopt;
+	}
+
+	std::vector<offsets> consistent;
+	for (const auto& [c, count] : votes)
+	{
+		if (count == informative)
+			consistent.push_back(c);
+	}
+
+	const auto toLayout = [&](const offsets& c) {
+		return cvar_layout{c[0], c[1], c[2], native.string_size};
+	};
+
+	if (consistent.size() == 1)
+		return toLayout(consistent.front());
+
+	for (const auto& c : consistent)
+	{
+		if (toLayout(c) == native)
+			return native;
+	}
+
+	log::warn(
+		"{} value layouts are consistent with {} CVars, can't pick one",
+		consistent.size(),
+		informative);
+	return std::nullopt;
+}
+
+} // namespace shugoconsole::cry
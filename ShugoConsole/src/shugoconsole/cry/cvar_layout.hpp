@@ -0,0 +1,388 @@
+#ifndef SHUGOCONSOLE_CRY_CVAR_LAYOUT_HPP
+#define SHUGOCONSOLE_CRY_CVAR_LAYOUT_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "shugoconsole/cry/cvar.hpp"
+#include "shugoconsole/cry/region_source.hpp"
+
+#if defined _MSC_VER
+#	include <intrin.h>
+#endif
+
+namespace shugoconsole::cry
+{
+
+// Offsets of the value fields of a CVar, found at run time
+struct cvar_layout
+{
+	size_t int_offset;
+	size_t float_offset;
+	size_t string_offset;
+	size_t string_size;
+
+	// Layout of struct cvar
+	static constexpr cvar_layout native()
+	{
+		return {
+			offsetof(cvar, int_value),
+			offsetof(cvar, float_value),
+			offsetof(cvar, string_value),
+			sizeof(cvar::string_value)};
+	}
+
+	bool operator==(const cvar_layout& other) const noexcept
+	{
+		return int_offset == other.int_offset &&
+			   float_offset == other.float_offset &&
+			   string_offset == other.string_offset &&
+			   string_size == other.string_size;
+	}
+	bool operator!=(const cvar_layout& other) const noexcept
+	{
+		return !(*this == other);
+	}
+};
+
+// Layout known at compile time, accessors using it compile to the same code
+// as the fields of struct cvar
+template<
+	size_t IntOffset,
+	size_t FloatOffset,
+	size_t StringOffset,
+	size_t StringSize>
+struct static_layout
+{
+	static constexpr size_t int_offset = IntOffset;
+	static constexpr size_t float_offset = FloatOffset;
+	static constexpr size_t string_offset = StringOffset;
+	static constexpr size_t string_size = StringSize;
+
+	constexpr operator cvar_layout() const
+	{
+		return {int_offset, float_offset, string_offset, string_size};
+	}
+};
+
+using native_layout = static_layout<
+	offsetof(cvar, int_value),
+	offsetof(cvar, float_value),
+	offsetof(cvar, string_value),
+	sizeof(cvar::string_value)>;
+
+// Layouts with compile time offsets, one per client generation whose layout
+// is known
+using known_layouts = std::tuple<native_layout>;
+
+// Accessors of the value fields of var, Layout is cvar_layout or a
+// static_layout
+namespace layout_access
+{
+
+inline const std::byte* field(const cvar* var, size_t offset)
+{
+	return static_cast<const std::byte*>(static_cast<const void*>(var)) +
+		   offset;
+}
+
+inline std::byte* field(cvar* var, size_t offset)
+{
+	return static_cast<std::byte*>(static_cast<void*>(var)) + offset;
+}
+
+template<typename Layout>
+inline int get_int(const cvar* var, const Layout& layout)
+{
+	int i;
+	std::memcpy(&i, field(var, layout.int_offset), sizeof(i));
+	return i;
+}
+
+template<typename Layout>
+inline float get_float(const cvar* var, const Layout& layout)
+{
+	float f;
+	std::memcpy(&f, field(var, layout.float_offset), sizeof(f));
+	return f;
+}
+
+template<typename Layout>
+inline const char* get_string(const cvar* var, const Layout& layout)
+{
+	return static_cast<const char*>(static_cast<const void*>(
+		field(var, layout.string_offset)));
+}
+
+// Stores i and f at address, 8-byte aligned, with a single store so that a
+// reader sees either both old values or both new ones
+inline void store_pair(std::byte* address, int i, float f) noexcept
+{
+	std::array<std::byte, 8> bytes;
+	std::memcpy(bytes.data(), &i, sizeof(i));
+	std::memcpy(bytes.data() + sizeof(i), &f, sizeof(f));
+	std::uint64_t word;
+	std::memcpy(&word, bytes.data(), sizeof(word));
+
+#if defined _MSC_VER
+	// Also a single store on x86, with cmpxchg8b
+	::_InterlockedExchange64(
+		reinterpret_cast<volatile long long*>(address),
+		static_cast<long long>(word));
+#else
+	__atomic_store_n(
+		reinterpret_cast<std::uint64_t*>(address), word, __ATOMIC_RELEASE);
+#endif
+}
+
+} // namespace layout_access
+
+// Value of var read as type t
+template<typename Layout>
+inline cvar::value get_value(
+	const cvar* var, cvar::type t, const Layout& layout)
+{
+	switch (t)
+	{
+	case cvar::type::integer:
+		return layout_access::get_int(var, layout);
+	case cvar::type::floating:
+		return layout_access::get_float(var, layout);
+	default:
+	{
+		const auto s = layout_access::get_string(var, layout);
+		return std::string{s, std::find(s, s + layout.string_size, '\0')};
+	}
+	}
+}
+
+// Same comparison as operator==(const cvar&, cvar::value)
+template<typename Layout>
+inline bool has_value(
+	const cvar* var, const cvar::value& v, const Layout& layout)
+{
+	if (const auto i = std::get_if<int>(&v))
+		return layout_access::get_int(var, layout) == *i;
+
+	if (const auto f = std::get_if<float>(&v))
+		return layout_access::get_float(var, layout) == *f;
+
+	const auto& s = std::get<std::string>(v);
+	return std::strncmp(
+			   layout_access::get_string(var, layout),
+			   s.c_str(),
+			   std::min(layout.string_size, s.size() + 1)) == 0;
+}
+
+// Value to assign to CVars, rendered once into the bytes of the int, float
+// and string fields with the conversions of cvar::operator=, so that
+// comparing and writing it doesn't allocate
+class cvar_assignment final
+{
+public:
+	explicit cvar_assignment(const cvar::value& v)
+	{
+		if (const auto pi = std::get_if<int>(&v))
+		{
+			type_ = cvar::type::integer;
+			int_ = *pi;
+			float_ = static_cast<float>(int_);
+			render(int_);
+		}
+		else if (const auto pf = std::get_if<float>(&v))
+		{
+			type_ = cvar::type::floating;
+			float_ = *pf;
+			int_ = static_cast<int>(float_);
+			render(float_);
+		}
+		else
+		{
+			const auto& s = std::get<std::string>(v);
+			type_ = cvar::type::string;
+			std::from_chars(s.data(), s.data() + s.size(), int_);
+			std::from_chars(s.data(), s.data() + s.size(), float_);
+			size_ = std::min(s.size(), string_.size() - 1);
+			std::memcpy(string_.data(), s.data(), size_);
+		}
+	}
+
+	// Same comparison as operator==(const cvar&, const cvar::value&), a
+	// string is compared as write() stores it
+	template<typename Layout>
+	bool matches(const cvar* var, const Layout& layout) const noexcept
+	{
+		switch (type_)
+		{
+		case cvar::type::integer:
+			return layout_access::get_int(var, layout) == int_;
+		case cvar::type::floating:
+			return layout_access::get_float(var, layout) == float_;
+		default:
+			return holds_string(var, layout);
+		}
+	}
+
+	// Writes the string, then the int and the float with a single store when
+	// they are adjacent and aligned, so that the game never reads the number
+	// of one value with the number of another
+	// A reader of the string can still see it half written
+	template<typename Layout>
+	void write(cvar* var, const Layout& layout) const noexcept
+	{
+		using layout_access::field;
+
+		const size_t size = stored_size(layout);
+		auto* string = field(var, layout.string_offset);
+		std::memcpy(string, string_.data(), size);
+		string[size] = std::byte{0};
+		std::atomic_thread_fence(std::memory_order_release);
+
+		auto* numbers = field(var, layout.int_offset);
+		if (layout.float_offset == layout.int_offset + sizeof(int) &&
+			reinterpret_cast<std::uintptr_t>(numbers) % 8 == 0)
+		{
+			layout_access::store_pair(numbers, int_, float_);
+		}
+		else
+		{
+			std::memcpy(numbers, &int_, sizeof(int_));
+			std::memcpy(
+				field(var, layout.float_offset), &float_, sizeof(float_));
+		}
+	}
+
+	// true if the three fields hold the value, checked after write() to find
+	// out if another thread wrote to the CVar at the same time
+	template<typename Layout>
+	bool holds(const cvar* var, const Layout& layout) const noexcept
+	{
+		return layout_access::get_int(var, layout) == int_ &&
+			   layout_access::get_float(var, layout) == float_ &&
+			   holds_string(var, layout);
+	}
+
+	cvar::type type() const noexcept { return type_; }
+	int int_value() const noexcept { return int_; }
+	float float_value() const noexcept { return float_; }
+	const char* string_value() const noexcept { return string_.data(); }
+
+private:
+	// Characters stored by write(), the string is truncated to fit the field
+	template<typename Layout>
+	size_t stored_size(const Layout& layout) const noexcept
+	{
+		return std::min(size_, layout.string_size - 1);
+	}
+
+	// true if the string field holds the string stored by write()
+	template<typename Layout>
+	bool holds_string(const cvar* var, const Layout& layout) const noexcept
+	{
+		const size_t size = stored_size(layout);
+		const char* string = layout_access::get_string(var, layout);
+		return std::strncmp(string, string_.data(), size) == 0 &&
+			   string[size] == '\0';
+	}
+
+	template<typename T>
+	void render(T number)
+	{
+		const auto first = string_.data();
+		size_ = static_cast<size_t>(
+			format_number(first, first + string_.size(), number) - first);
+	}
+
+	cvar::type type_;
+	int int_ = 0;
+	float float_ = 0.0f;
+	// size_ characters, with room for the null character
+	std::array<char, sizeof(cvar::string_value)> string_{};
+	size_t size_ = 0;
+};
+
+// Same conversions as cvar::operator=(const cvar::value&)
+template<typename Layout>
+inline void set_value(cvar* var, const cvar::value& v, const Layout& layout)
+{
+	cvar_assignment{v}.write(var, layout);
+}
+
+// CVar accessed through Layout, with the operators of struct cvar
+template<typename Layout>
+class cvar_ref final
+{
+public:
+	cvar_ref(cvar* var, const Layout& layout) : var_{var}, layout_{layout} {}
+
+	cvar_ref& operator=(const cvar::value& v)
+	{
+		set_value(var_, v, layout_);
+		return *this;
+	}
+
+	cvar::value to_value(cvar::type t) const
+	{
+		return get_value(var_, t, layout_);
+	}
+
+	bool operator==(const cvar::value& v) const
+	{
+		return has_value(var_, v, layout_);
+	}
+	bool operator!=(const cvar::value& v) const { return !(*this == v); }
+
+private:
+	cvar* var_;
+	Layout layout_;
+};
+
+// Calls f with the known layout equal to layout, or with layout itself if
+// none is, so that code instantiated by f picks its offsets once
+// Returns what f returns
+template<size_t I = 0, typename F>
+inline decltype(auto) dispatch_layout(const cvar_layout& layout, F&& f)
+{
+	if constexpr (I == std::tuple_size_v<known_layouts>)
+	{
+		return f(layout);
+	}
+	else
+	{
+		using known = std::tuple_element_t<I, known_layouts>;
+		constexpr cvar_layout knownLayout = known{};
+		if (layout == knownLayout)
+			return f(known{});
+		return dispatch_layout<I + 1>(layout, std::forward<F>(f));
+	}
+}
+
+// CVar confirmed by a scan, with the type of its value
+struct layout_sample
+{
+	const cvar* var;
+	cvar::type type;
+};
+
+// Infers the offsets of the value fields from CVars whose int, float and
+// string fields hold the same number, the way the client keeps them
+// Offsets consistent with every sample holding a non-zero number are kept,
+// the native layout wins ties. string_size can't be observed and is the
+// native one
+// Returns nullopt if no sample is usable or if several layouts remain
+std::optional<cvar_layout> probe_layout(
+	region_source& source,
+	const std::vector<layout_sample>& samples,
+	size_t window = 512);
+
+} // namespace shugoconsole::cry
+
+#endif // SHUGOCONSOLE_CRY_CVAR_LAYOUT_HPP
@@ -0,0 +1,183 @@
+#include "shugoconsole/cry/cvar_liveness.hpp"
+#include "shugoconsole/log.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace shugoconsole::cry
+{
+
+namespace
+{
+
+struct header_copy
+{
+	std::byte* buffer;
+	size_t size;
+};
+
+void CopyHeader(void* context, const std::byte* view)
+{
+	const auto& copy = *static_cast<header_copy*>(context);
+	std::memcpy(copy.buffer, view, copy.size);
+}
+
+// Distance between address and the closest byte of r
+size_t distance(const region& r, const std::byte* address)
+{
+	if (address < r.base)
+		return static_cast<size_t>(r.base - address);
+	if (address >= r.base + r.size)
+		return static_cast<size_t>(address - (r.base + r.size)) + 1;
+	return 0;
+}
+
+} // namespace
+
+const char* to_string(liveness l)
+{
+	switch (l)
+	{
+	case liveness::alive:
+		return "alive";
+	case liveness::unreadable:
+		return "unreadable";
+	case liveness::replaced:
+		return "replaced";
+	default:
+		return "unknown";
+	}
+}
+
+liveness check_liveness(
+	region_source& source,
+	const cvar::pattern& pattern,
+	const cvar* var,
+	std::uintptr_t vtable)
+{
+	std::array<std::byte, sizeof(cvar)> buffer;
+	const auto address =
+		static_cast<const std::byte*>(static_cast<const void*>(var));
+
+	// A guarded read in place avoids a system call on every check
+	header_copy copy{buffer.data(), pattern.size()};
+	if (!source.read_in_place(address, copy.size, &CopyHeader, &copy) &&
+		source.read(address, buffer.data(), copy.size) != copy.size)
+	{
+		return liveness::unreadable;
+	}
+
+	const auto& header =
+		*static_cast<const cvar*>(static_cast<const void*>(buffer.data()));
+	if (!pattern.match(&header) ||
+		reinterpret_cast<std::uintptr_t>(header.dummy0) != vtable)
+	{
+		return liveness::replaced;
+	}
+
+	return liveness::alive;
+}
+
+void neighbourhood_region_source::reset()
+{
+	regions_.clear();
+	next_ = 0;
+	loaded_ = true;
+
+	const auto center = reinterpret_cast<std::uintptr_t>(center_);
+	const auto first = center > maxDistance_ ? center - maxDistance_ : 0;
+	const auto last = center + std::min(maxDistance_, UINTPTR_MAX - center);
+
+	region r;
+	inner_.reset();
+	while (inner_.next(r))
+	{
+		const auto base = reinterpret_cast<std::uintptr_t>(r.base);
+		const auto end = base + r.size;
+		if (end <= first || base > last)
+			continue;
+
+		// Clipped on whole slots so that the scan stays aligned
+		const auto clippedBase = first > base ?
+			base + ((first - base) & ~std::uintptr_t{15}) :
+			base;
+		const auto clippedEnd = std::min(end, last + 1);
+
+		r.size = static_cast<size_t>(clippedEnd - clippedBase);
+		r.base = reinterpret_cast<std::byte*>(clippedBase);
+		regions_.push_back(r);
+	}
+
+	std::stable_sort(
+		regions_.begin(),
+		regions_.end(),
+		[this](const region& a, const region& b) {
+			return distance(a, center_) < distance(b, center_);
+		});
+}
+
+bool neighbourhood_region_source::next(region& r)
+{
+	if (!loaded_)
+		reset();
+
+	if (next_ == regions_.size())
+		return false;
+
+	r = regions_[next_++];
+	return true;
+}
+
+cvar* resolve_moved_cvar(
+	region_source& source,
+	const cvar::pattern& pattern,
+	const cvar* old,
+	std::uintptr_t vtable,
+	std::vector<std::byte>& buffer,
+	size_t max_distance,
+	bool full_scan)
+{
+	const cvar::pattern_set patterns{{pattern}};
+
+	// Only slots with the same vtable pointer are tested, stale copies left
+	// in freed memory lost theirs
+	scan_options options;
+	options.vtables = cvar::vtable_range{vtable, vtable};
+
+	const auto oldAddress =
+		static_cast<const std::byte*>(static_cast<const void*>(old));
+	neighbourhood_region_source neighbourhood{
+		source, oldAddress, max_distance};
+	if (const auto var =
+			find_cvar_ptrs(neighbourhood, patterns, buffer, options).front())
+	{
+		log::info(
+			"{} moved from {} to {}",
+			pattern.name(),
+			static_cast<const void*>(old),
+			static_cast<void*>(var));
+		return var;
+	}
+
+	if (!full_scan)
+		return nullptr;
+
+	log::info(
+		"{} is not around {} anymore, scanning all memory",
+		pattern.name(),
+		static_cast<const void*>(old));
+
+	const auto var = find_cvar_ptrs(source, patterns, buffer, options).front();
+	if (var)
+	{
+		log::info(
+			"{} moved from {} to {}",
+			pattern.name(),
+			static_cast<const void*>(old),
+			static_cast<void*>(var));
+	}
+	return var;
+}
+
+} // namespace shugoconsole::cry
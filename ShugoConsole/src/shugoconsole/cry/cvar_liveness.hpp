@@ -0,0 +1,91 @@
+#ifndef SHUGOCONSOLE_CRY_CVAR_LIVENESS_HPP
+#define SHUGOCONSOLE_CRY_CVAR_LIVENESS_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "shugoconsole/cry/cvar.hpp"
+#include "shugoconsole/cry/memory.hpp"
+#include "shugoconsole/cry/region_source.hpp"
+
+namespace shugoconsole::cry
+{
+
+// State of a CVar pointer found by a previous scan
+enum class liveness
+{
+	alive,
+	// The memory is not committed or not readable anymore
+	unreadable,
+	// The memory holds another name or another vtable pointer
+	replaced
+};
+
+const char* to_string(liveness l);
+
+// Checks that var still holds the CVar of pattern, with the vtable pointer
+// it had when it was found
+// Costs one guarded read of the start of the CVar
+liveness check_liveness(
+	region_source& source,
+	const cvar::pattern& pattern,
+	const cvar* var,
+	std::uintptr_t vtable);
+
+// Region source that returns the parts of the regions of another source
+// that are at most max_distance bytes away from an address, the region
+// holding the address first, then by increasing distance
+class neighbourhood_region_source final : public region_source
+{
+public:
+	neighbourhood_region_source(
+		region_source& inner, const std::byte* center, size_t max_distance) :
+		inner_{inner},
+		center_{center},
+		maxDistance_{max_distance}
+	{
+	}
+
+	void reset() override;
+	bool next(region& r) override;
+
+	size_t read(const std::byte* address, std::byte* buffer, size_t size)
+		override
+	{
+		return inner_.read(address, buffer, size);
+	}
+
+	bool read_in_place(
+		const std::byte* address,
+		size_t size,
+		void (*f)(void* context, const std::byte* view),
+		void* context) override
+	{
+		return inner_.read_in_place(address, size, f, context);
+	}
+
+private:
+	region_source& inner_;
+	const std::byte* center_;
+	size_t maxDistance_;
+	std::vector<region> regions_;
+	size_t next_ = 0;
+	bool loaded_ = false;
+};
+
+// Finds the CVar of pattern again after it moved from old, with the same
+// vtable pointer: first at most max_distance bytes around old, then in
+// every region of source if full_scan is true
+// Returns nullptr if it was not found
+cvar* resolve_moved_cvar(
+	region_source& source,
+	const cvar::pattern& pattern,
+	const cvar* old,
+	std::uintptr_t vtable,
+	std::vector<std::byte>& buffer,
+	size_t max_distance = 16 * 1024 * 1024,
+	bool full_scan = true);
+
+} // namespace shugoconsole::cry
+
+#endif // SHUGOCONSOLE_CRY_CVAR_LIVENESS_HPP
@@ -0,0 +1,297 @@
+#include "shugoconsole/cry/cvar_registry.hpp"
+#include "shugoconsole/log.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
+namespace shugoconsole::cry
+{
+
+namespace
+{
+
+using map_node = cvar_registry::map_node;
+
+// Trees of a few thousand nodes are never deeper than this
+constexpr size_t max_depth = 128;
+
+// Bytes of a cvar holding its category and name
+constexpr size_t cvar_header_size =
+	offsetof(cvar, name) + std::tuple_size_v<decltype(cvar::name)>;
+
+bool read_node(region_source& source, const std::byte* address, map_node& node)
+{
+	if (address == nullptr ||
+		reinterpret_cast<std::uintptr_t>(address) % alignof(map_node) != 0)
+	{
+		return false;
+	}
+
+	return source.read(
+			   address,
+			   static_cast<std::byte*>(static_cast<void*>(&node)),
+			   sizeof(node)) == sizeof(node) &&
+		   (node.color == 0 || node.color == 1) &&
+		   (node.is_nil == 0 || node.is_nil == 1);
+}
+
+// Reads a null-terminated string of at most max_size characters
+std::optional<std::string> read_string(
+	region_source& source, const std::byte* address, size_t maxSize)
+{
+	std::array<char, std::tuple_size_v<decltype(cvar::name)>> buffer;
+	maxSize = std::min(maxSize, buffer.size());
+
+	// Reads stop at page boundaries, the string may end before an
+	// unreadable page
+	size_t size = 0;
+	while (size < maxSize)
+	{
+		const auto pageEnd =
+			(reinterpret_cast<std::uintptr_t>(address + size) | 4095) + 1;
+		const auto chunk = std::min(
+			maxSize - size,
+			static_cast<size_t>(
+				pageEnd - reinterpret_cast<std::uintptr_t>(address + size)));
+
+		char* first = buffer.data() + size;
+		if (source.read(
+				address + size,
+				static_cast<std::byte*>(static_cast<void*>(first)),
+				chunk) != chunk)
+		{
+			return std::nullopt;
+		}
+
+		const auto end = std::find(first, first + chunk, '\0');
+		if (end != first + chunk)
+			return std::string{buffer.data(), end};
+
+		size += chunk;
+	}
+
+	return std::nullopt;
+}
+
+// Name of the CVar at address if it looks valid
+std::optional<std::string> read_cvar_name(
+	region_source& source, const std::byte* address)
+{
+	std::array<std::byte, cvar_header_size> header;
+	if (address == nullptr ||
+		source.read(address, header.data(), header.size()) != header.size())
+	{
+		return std::nullopt;
+	}
+
+	const auto cat = static_cast<char>(header[offsetof(cvar, cat)]);
+	if (cat != 0 && cat != 1)
+		return std::nullopt;
+
+	const auto* name = static_cast<const char*>(
+		static_cast<const void*>(header.data() + offsetof(cvar, name)));
+	const auto* last = name + (header.size() - offsetof(cvar, name));
+	const auto* end = std::find(name, last, '\0');
+	if (end == last || end == name)
+		return std::nullopt;
+
+	return std::string{name, end};
+}
+
+struct pointer_search
+{
+	const std::byte* value;
+	size_t size;
+	// Addresses of the matching words, relative to the searched range
+	std::vector<size_t>* matches;
+};
+
+void SearchPointer(void* context, const std::byte* view)
+{
+	const auto& search = *static_cast<pointer_search*>(context);
+	const auto value = reinterpret_cast<std::uintptr_t>(search.value);
+
+	for (size_t offset = 0; offset + sizeof(value) <= search.size;
+		 offset += sizeof(value))
+	{
+		std::uintptr_t word;
+		std::memcpy(&word, view + offset, sizeof(word));
+		if (word == value)
+			search.matches->push_back(offset);
+	}
+}
+
+// Walks the tree of head in order and records every valid CVar
+bool walk(
+	region_source& source,
+	std::byte* head,
+	std::unordered_map<std::string, cvar*>& vars)
+{
+	map_node headNode{};
+	if (!read_node(source, head, headNode) || headNode.is_nil != 1)
+		return false;
+
+	// Empty tree
+	if (headNode.parent == head)
+		return true;
+
+	std::vector<map_node> stack;
+	std::byte* current = headNode.parent;
+	size_t count = 0;
+
+	while (current != head || !stack.empty())
+	{
+		// Go down the left branch
+		while (current != head)
+		{
+			map_node node{};
+			if (stack.size() >= max_depth ||
+				!read_node(source, current, node) || node.is_nil != 0)
+			{
+				return false;
+			}
+
+			stack.push_back(node);
+			current = node.left;
+		}
+
+		const map_node node = stack.back();
+		stack.pop_back();
+
+		if (++count > cvar_registry::max_nodes)
+			return false;
+
+		// Entries that don't look like CVars are skipped, the map may hold
+		// other kinds of console variables
+		if (const auto name = read_cvar_name(source, node.value))
+			vars[*name] = static_cast<cvar*>(static_cast<void*>(node.value));
+
+		current = node.right;
+	}
+
+	return true;
+}
+
+} // namespace
+
+std::optional<cvar_registry> cvar_registry::find(
+	region_source& source, const cvar* anchor)
+{
+	auto* anchorAddress =
+		static_cast<std::byte*>(static_cast<void*>(const_cast<cvar*>(anchor)));
+	const auto anchorName = read_cvar_name(source, anchorAddress);
+	if (!anchorName)
+		return std::nullopt;
+
+	log::trace(
+		"cvar_registry: Searching the map node of {} at {}",
+		*anchorName,
+		static_cast<const void*>(anchor));
+
+	// Nodes are aligned on pointers, their value is the address of the CVar
+	constexpr size_t valueOffset = offsetof(map_node, value);
+	std::vector<size_t> matches;
+
+	source.reset();
+
+	region candidate{};
+	while (source.next(candidate))
+	{
+		matches.clear();
+		pointer_search search{anchorAddress, candidate.size, &matches};
+		if (!source.read_in_place(
+				candidate.base, candidate.size, &SearchPointer, &search))
+		{
+			// Copy the region page by page instead
+			std::vector<std::byte> page(4096);
+			matches.clear();
+			for (size_t offset = 0; offset < candidate.size;
+				 offset += page.size())
+			{
+				const auto size =
+					std::min(page.size(), candidate.size - offset);
+				if (source.read(candidate.base + offset, page.data(), size) !=
+					size)
+				{
+					continue;
+				}
+
+				std::vector<size_t> pageMatches;
+				pointer_search pageSearch{anchorAddress, size, &pageMatches};
+				SearchPointer(&pageSearch, page.data());
+				for (const auto match : pageMatches)
+					matches.push_back(offset + match);
+			}
+		}
+
+		for (const auto match : matches)
+		{
+			if (match < valueOffset)
+				continue;
+
+			std::byte* nodeAddress = candidate.base + match - valueOffset;
+			map_node node{};
+			if (!read_node(source, nodeAddress, node) || node.is_nil != 0)
+				continue;
+
+			// The key is the name of the CVar
+			const auto key =
+				read_string(source, node.key, anchorName->size() + 1);
+			if (!key || *key != *anchorName)
+				continue;
+
+			// Climb to the head of the tree
+			std::byte* head = nodeAddress;
+			map_node current = node;
+			size_t depth = 0;
+			while (current.is_nil == 0 && depth++ < max_depth)
+			{
+				head = current.parent;
+				if (!read_node(source, head, current))
+					break;
+			}
+
+			if (current.is_nil != 1)
+				continue;
+
+			cvar_registry registry{head};
+			if (registry.refresh(source) &&
+				registry.lookup(*anchorName) == anchor)
+			{
+				log::info(
+					"Found the CVar registry at {}, {:d} CVars",
+					static_cast<const void*>(head),
+					registry.size());
+				return registry;
+			}
+		}
+	}
+
+	log::debug("cvar_registry: No map references {}", *anchorName);
+	return std::nullopt;
+}
+
+bool cvar_registry::refresh(region_source& source)
+{
+	std::unordered_map<std::string, cvar*> vars;
+	if (!walk(source, head_, vars))
+	{
+		log::debug(
+			"cvar_registry: The map at {} is not valid anymore",
+			static_cast<const void*>(head_));
+		return false;
+	}
+
+	vars_ = std::move(vars);
+	return true;
+}
+
+cvar* cvar_registry::lookup(const std::string& name) const
+{
+	const auto it = vars_.find(name);
+	return it != vars_.end() ? it->second : nullptr;
+}
+
+} // namespace shugoconsole::cry
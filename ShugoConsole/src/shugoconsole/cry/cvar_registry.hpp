@@ -0,0 +1,66 @@
+#ifndef SHUGOCONSOLE_CRY_CVAR_REGISTRY_HPP
+#define SHUGOCONSOLE_CRY_CVAR_REGISTRY_HPP
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "shugoconsole/cry/cvar.hpp"
+#include "shugoconsole/cry/region_source.hpp"
+
+namespace shugoconsole::cry
+{
+
+// Registry of the console variables of the engine
+// The console keeps its CVars in a MSVC std::map<const char*, ICVar*>. The
+// map is located from a CVar found in memory: one of its nodes references
+// the CVar, and the parents of that node lead to the head of the tree. The
+// whole tree is then walked, and every registered CVar can be looked up by
+// name without scanning memory
+class cvar_registry final
+{
+public:
+	// Node of a MSVC std::map<const char*, ICVar*>
+	struct map_node
+	{
+		std::byte* left;
+		std::byte* parent;
+		std::byte* right;
+		char color;
+		char is_nil;
+		std::byte* key;
+		std::byte* value;
+	};
+
+	// Maximum number of nodes walked, protects against corrupted trees
+	static constexpr size_t max_nodes = 1 << 16;
+
+	// Searches the regions of source for the map node referencing anchor
+	// and walks the map it belongs to
+	// Returns nullopt if no valid map references anchor
+	static std::optional<cvar_registry> find(
+		region_source& source, const cvar* anchor);
+
+	// Walks the map again from its head, to see CVars registered since
+	// Returns false if the map is not valid anymore
+	bool refresh(region_source& source);
+
+	// CVar registered under name, or nullptr
+	cvar* lookup(const std::string& name) const;
+
+	size_t size() const noexcept { return vars_.size(); }
+
+	// Address of the head node of the map
+	const std::byte* head() const noexcept { return head_; }
+
+private:
+	explicit cvar_registry(std::byte* head) : head_{head} {}
+
+	std::byte* head_;
+	std::unordered_map<std::string, cvar*> vars_;
+};
+
+} // namespace shugoconsole::cry
+
+#endif // SHUGOCONSOLE_CRY_CVAR_REGISTRY_HPP
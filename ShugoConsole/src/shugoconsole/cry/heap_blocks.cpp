@@ -0,0 +1,25 @@
+#include "shugoconsole/cry/heap_blocks.hpp"
+
+namespace shugoconsole::cry
+{
+
+void append_heap_block(
+	std::vector<region>& runs, const region& block, size_t max_gap)
+{
+	if (!runs.empty())
+	{
+		auto& last = runs.back();
+		const auto end = last.base + last.size;
+		if (last.allocation_base == block.allocation_base &&
+			block.base >= end &&
+			static_cast<size_t>(block.base - end) <= max_gap)
+		{
+			last.size = block.base + block.size - last.base;
+			return;
+		}
+	}
+
+	runs.push_back(block);
+}
+
+} // namespace shugoconsole::cry
@@ -0,0 +1,46 @@
+#ifndef SHUGOCONSOLE_CRY_HEAP_BLOCKS_HPP
+#define SHUGOCONSOLE_CRY_HEAP_BLOCKS_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "shugoconsole/cry/cvar.hpp"
+#include "shugoconsole/cry/region_source.hpp"
+
+namespace shugoconsole::cry
+{
+
+// Sizes of the live heap blocks that are scanned for CVars
+struct heap_block_filter
+{
+	// CVars holding an int or a float may not have room for string_value,
+	// subclasses may have members after it
+	size_t min_size = offsetof(cvar, string_value);
+	size_t max_size = 1024;
+
+	// Accepted blocks separated by at most this many bytes, the headers of
+	// the allocator, are returned as a single region
+	size_t max_gap = 64;
+
+	inline bool accepts(size_t size) const noexcept
+	{
+		return size >= min_size && size <= max_size;
+	}
+};
+
+// Appends block to runs, or extends the last run up to the end of block if
+// the block starts at most max_gap bytes after it in the same allocation
+// Blocks must be appended in ascending address order
+void append_heap_block(
+	std::vector<region>& runs, const region& block, size_t max_gap);
+
+// Source of the runs of live heap blocks of the current process whose size
+// is accepted by filter
+// Memory that is not managed by an enumerable heap is not returned
+std::unique_ptr<region_source> make_heap_block_source(
+	const heap_block_filter& filter = {});
+
+} // namespace shugoconsole::cry
+
+#endif // SHUGOCONSOLE_CRY_HEAP_BLOCKS_HPP
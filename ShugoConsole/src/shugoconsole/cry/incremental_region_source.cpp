@@ -0,0 +1,207 @@
+#include "shugoconsole/cry/incremental_region_source.hpp"
+#include "shugoconsole/cry/cvar.hpp"
+#include "shugoconsole/log.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace shugoconsole::cry
+{
+
+namespace
+{
+
+// The word holding the cat byte and the first name bytes of every 16-byte
+// slot is sampled: a CVar constructed anywhere in a block changes it
+constexpr size_t sample_stride = 16;
+constexpr size_t sample_offset = 8;
+
+static_assert(incremental_region_source::block_size % sample_stride == 0);
+
+// Returned blocks are extended so that CVars starting at their end are
+// complete, the same way the scanner overlaps chunks
+constexpr size_t block_overlap = (sizeof(cvar) + 15) / 16 * 16;
+
+// Fletcher-style sums of the sampled words of size bytes at view: the second
+// sum weights each word by its position, so that the same write at two
+// offsets doesn't cancel out
+std::uint64_t sample_checksum(const std::byte* view, size_t size)
+{
+	std::uint64_t sum = 0;
+	std::uint64_t weighted = 0;
+	for (size_t offset = sample_offset; offset + 8 <= size;
+		 offset += sample_stride)
+	{
+		std::uint64_t word;
+		std::memcpy(&word, view + offset, sizeof(word));
+		sum += word;
+		weighted += sum;
+	}
+	return sum ^ (weighted * 0x9e3779b97f4a7c15ull);
+}
+
+struct checksum_call
+{
+	size_t size;
+	std::uint64_t checksum;
+};
+
+void ChecksumInPlace(void* context, const std::byte* view)
+{
+	auto& call = *static_cast<checksum_call*>(context);
+	call.checksum = sample_checksum(view, call.size);
+}
+
+} // namespace
+
+incremental_region_source::incremental_region_source(
+	region_source& inner, unsigned full_pass_interval) :
+	inner_{inner},
+	fullPassInterval_{std::max(full_pass_interval, 1u)}
+{
+}
+
+void incremental_region_source::reset()
+{
+	for (auto it = regions_.begin(); it != regions_.end();)
+	{
+		if (it->second.pass != pass_)
+			it = regions_.erase(it);
+		else
+			++it;
+	}
+
+	++pass_;
+	returnedBytes_ = 0;
+	skippedBytes_ = 0;
+
+	// A region left unfinished is not recorded, it is returned again
+	hasCurrent_ = false;
+	previous_ = nullptr;
+
+	inner_.reset();
+}
+
+bool incremental_region_source::next(region& r)
+{
+	size_t checked = 0;
+	// Run of consecutive changed blocks of current_ to return
+	std::optional<size_t> run;
+
+	for (;;)
+	{
+		if (!hasCurrent_)
+		{
+			if (!inner_.next(current_))
+				return false;
+			start_region();
+		}
+
+		if (block_ == sums_.size())
+		{
+			finish_region();
+			if (run)
+			{
+				r = changed_blocks(*run, current_.size);
+				return true;
+			}
+			continue;
+		}
+
+		const auto offset = block_ * block_size;
+		if (checked >= checked_per_call)
+		{
+			r = run ? changed_blocks(*run, offset) :
+					  region{
+						  current_.base + offset,
+						  0,
+						  current_.allocation_base,
+						  current_.protection};
+			return true;
+		}
+
+		const auto size = std::min(block_size, current_.size - offset);
+		const auto sum = checksum(current_.base + offset, size);
+		sums_[block_++] = sum;
+		checked += size;
+
+		if (!previous_ || !sum || sum != previous_->checksums[block_ - 1])
+		{
+			returnedBytes_ += size;
+			changed_ = true;
+			if (!run)
+				run = offset;
+			continue;
+		}
+
+		skippedBytes_ += size;
+		if (run)
+		{
+			r = changed_blocks(*run, offset);
+			return true;
+		}
+	}
+}
+
+void incremental_region_source::start_region()
+{
+	const bool fullPass = pass_ % fullPassInterval_ == 0;
+	const auto it = regions_.find(current_.base);
+	const bool known = !fullPass && it != regions_.end() &&
+					   it->second.size == current_.size &&
+					   it->second.allocation_base == current_.allocation_base;
+
+	previous_ = known ? &it->second : nullptr;
+	sums_.assign((current_.size + block_size - 1) / block_size, std::nullopt);
+	block_ = 0;
+	changed_ = false;
+	hasCurrent_ = true;
+}
+
+void incremental_region_source::finish_region()
+{
+	if (previous_ && !changed_)
+	{
+		log::trace(
+			"Region at {} unchanged since last pass - Skipping",
+			static_cast<void*>(current_.base));
+	}
+
+	regions_.insert_or_assign(
+		current_.base,
+		entry{
+			current_.size,
+			current_.allocation_base,
+			std::move(sums_),
+			pass_});
+
+	sums_ = {};
+	previous_ = nullptr;
+	hasCurrent_ = false;
+}
+
+region incremental_region_source::changed_blocks(
+	size_t first, size_t last) const noexcept
+{
+	return region{
+		current_.base + first,
+		std::min(last + block_overlap, current_.size) - first,
+		current_.allocation_base,
+		current_.protection};
+}
+
+std::optional<std::uint64_t> incremental_region_source::checksum(
+	std::byte* address, size_t size)
+{
+	checksum_call call{size, 0};
+	if (inner_.read_in_place(address, size, &ChecksumInPlace, &call))
+		return call.checksum;
+
+	// Blocks that can't be read have no checksum, they are always returned
+	buffer_.resize(block_size);
+	if (inner_.read(address, buffer_.data(), size) != size)
+		return std::nullopt;
+	return sample_checksum(buffer_.data(), size);
+}
+
+} // namespace shugoconsole::cry
@@ -0,0 +1,111 @@
+#ifndef SHUGOCONSOLE_CRY_INCREMENTAL_REGION_SOURCE_HPP
+#define SHUGOCONSOLE_CRY_INCREMENTAL_REGION_SOURCE_HPP
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "shugoconsole/cry/region_source.hpp"
+
+namespace shugoconsole::cry
+{
+
+// Region source that only returns the parts of the regions of another source
+// that may have changed since they were last returned
+// Regions are split in blocks. A block is returned again when its region is
+// new, when the region size or allocation base changed, or when a checksum
+// of the name word of every 16-byte slot changed. Writes to the other words
+// are missed, so every full_pass_interval passes all regions are returned as
+// a safety net
+// Blocks are checksummed as next() reaches them, a call checks at most
+// checked_per_call bytes: it returns an empty region when it only skipped
+// unchanged blocks, so that a resumable scan stays within its budget
+// Skipping a region is only valid while the patterns scanned for are a
+// subset of the ones of previous passes, call clear() otherwise
+class incremental_region_source final : public region_source
+{
+public:
+	// Size of the blocks regions are split into
+	static constexpr size_t block_size = 256 * 1024;
+
+	// Bytes checksummed by a call of next() at most
+	static constexpr size_t checked_per_call = 4 * block_size;
+
+	explicit incremental_region_source(
+		region_source& inner, unsigned full_pass_interval = 8);
+
+	// Starts a new pass
+	// Regions that were not enumerated by the previous pass are forgotten
+	void reset() override;
+	bool next(region& r) override;
+
+	size_t read(const std::byte* address, std::byte* buffer, size_t size)
+		override
+	{
+		return inner_.read(address, buffer, size);
+	}
+
+	bool read_in_place(
+		const std::byte* address,
+		size_t size,
+		void (*f)(void* context, const std::byte* view),
+		void* context) override
+	{
+		return inner_.read_in_place(address, size, f, context);
+	}
+
+	// Forgets all regions, the next pass returns all of them
+	void clear() { regions_.clear(); }
+
+	// Bytes returned and skipped during the current pass
+	size_t returned_bytes() const noexcept { return returnedBytes_; }
+	size_t skipped_bytes() const noexcept { return skippedBytes_; }
+
+private:
+	struct entry
+	{
+		size_t size;
+		std::byte* allocation_base;
+		// Checksum of each block, nullopt if the block could not be read
+		std::vector<std::optional<std::uint64_t>> checksums;
+		// Last pass that enumerated the region
+		unsigned pass;
+	};
+
+	// Checksum of the size bytes at address, nullopt if they can't be read
+	std::optional<std::uint64_t> checksum(std::byte* address, size_t size);
+
+	// Starts checking the blocks of current_
+	void start_region();
+	// Records the checksums of current_ once all of its blocks are checked
+	void finish_region();
+
+	// Changed blocks of current_ in [first, last), with the overlap
+	region changed_blocks(size_t first, size_t last) const noexcept;
+
+	region_source& inner_;
+	std::map<std::byte*, entry> regions_;
+
+	// Region whose blocks are being checked, from block_ on
+	region current_{};
+	bool hasCurrent_ = false;
+	// Entry of current_ in the previous passes, nullptr if it is returned
+	// whole
+	const entry* previous_ = nullptr;
+	std::vector<std::optional<std::uint64_t>> sums_;
+	size_t block_ = 0;
+	bool changed_ = false;
+
+	// Copies of the blocks that can't be read in place
+	std::vector<std::byte> buffer_;
+
+	unsigned fullPassInterval_;
+	unsigned pass_ = 0;
+	size_t returnedBytes_ = 0;
+	size_t skippedBytes_ = 0;
+};
+
+} // namespace shugoconsole::cry
+
+#endif // SHUGOCONSOLE_CRY_INCREMENTAL_REGION_SOURCE_HPP
@@ -0,0 +1,91 @@
+#include "shugoconsole/cry/match_filters.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace shugoconsole::cry::match_filters
+{
+
+namespace
+{
+
+template<size_t N>
+bool null_terminated(const std::array<char, N>& chars)
+{
+	return std::find(chars.begin(), chars.end(), '\0') != chars.end();
+}
+
+} // namespace
+
+match_filter layout()
+{
+	return [](const cvar_match& match) {
+		const auto& var = match.snapshot();
+		const auto vtable = reinterpret_cast<std::uintptr_t>(var.dummy0);
+		return vtable != 0 && vtable % sizeof(void*) == 0 &&
+			   null_terminated(var.name) && null_terminated(var.string_value);
+	};
+}
+
+match_filter vtable(const cvar::vtable_range& vtables)
+{
+	return [vtables](const cvar_match& match) {
+		return vtables.contains(
+			reinterpret_cast<std::uintptr_t>(match.snapshot().dummy0));
+	};
+}
+
+match_filter value(
+	cvar::type t, std::function<bool(const cvar::value&)> predicate)
+{
+	return [t, predicate = std::move(predicate)](const cvar_match& match) {
+		const auto& var = match.snapshot();
+		// to_value reads string_value up to its null character
+		if (t == cvar::type::string && !null_terminated(var.string_value))
+			return false;
+		return predicate(var.to_value(t));
+	};
+}
+
+match_filter plausible_value(cvar::type t)
+{
+	return value(t, [](const cvar::value& v) {
+		if (const auto f = std::get_if<float>(&v))
+			return std::isfinite(*f);
+
+		if (const auto s = std::get_if<std::string>(&v))
+		{
+			return std::all_of(s->begin(), s->end(), [](char c) {
+				return static_cast<unsigned char>(c) >= 0x20;
+			});
+		}
+
+		return true;
+	});
+}
+
+match_filter region(std::function<bool(const cry::region&)> predicate)
+{
+	return [predicate = std::move(predicate)](const cvar_match& match) {
+		return predicate(match.found_in);
+	};
+}
+
+match_filter all_of(std::vector<match_filter> filters)
+{
+	filters.erase(
+		std::remove_if(
+			filters.begin(),
+			filters.end(),
+			[](const match_filter& f) { return !f; }),
+		filters.end());
+
+	return [filters = std::move(filters)](const cvar_match& match) {
+		return std::all_of(
+			filters.begin(), filters.end(), [&match](const match_filter& f) {
+				return f(match);
+			});
+	};
+}
+
+} // namespace shugoconsole::cry::match_filters
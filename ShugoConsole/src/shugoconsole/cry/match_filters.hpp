@@ -0,0 +1,38 @@
+#ifndef SHUGOCONSOLE_CRY_MATCH_FILTERS_HPP
+#define SHUGOCONSOLE_CRY_MATCH_FILTERS_HPP
+
+#include <functional>
+#include <vector>
+
+#include "shugoconsole/cry/cvar.hpp"
+#include "shugoconsole/cry/memory.hpp"
+#include "shugoconsole/cry/region_source.hpp"
+
+// Filters of the matches of cvar_matches, built to reject the stale copies
+// of a CVar left in freed or duplicated memory
+namespace shugoconsole::cry::match_filters
+{
+
+// Vtable pointer aligned and not null, name and string value null-terminated
+// Allocators overwrite the first words of the blocks they free
+match_filter layout();
+
+// Vtable pointer in vtables
+match_filter vtable(const cvar::vtable_range& vtables);
+
+// Value of the CVar read as type t accepted by predicate
+match_filter value(
+	cvar::type t, std::function<bool(const cvar::value&)> predicate);
+
+// Finite float value and printable string value
+match_filter plausible_value(cvar::type t);
+
+// Region the CVar was found in accepted by predicate
+match_filter region(std::function<bool(const cry::region&)> predicate);
+
+// Matches accepted by every filter, empty filters accept everything
+match_filter all_of(std::vector<match_filter> filters);
+
+} // namespace shugoconsole::cry::match_filters
+
+#endif // SHUGOCONSOLE_CRY_MATCH_FILTERS_HPP
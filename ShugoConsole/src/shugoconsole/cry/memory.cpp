@@ -1,173 +1,845 @@
 #include "shugoconsole/cry/memory.hpp"
+#include "shugoconsole/cry/slot_filter.hpp"
 #include "shugoconsole/log.hpp"
-#include "shugoconsole/win/utils.hpp"
 
-#define NOMINMAX
-#define WIN32_LEAN_AND_MEAN
-#include <Windows.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 namespace shugoconsole::cry
 {
 
-static cry::cvar* LookupPage(
-	const MEMORY_BASIC_INFORMATION& memoryBasicInformation,
-	const cry::cvar::pattern& cvarDef,
-	std::vector<std::byte>& buffer)
+namespace
 {
-	std::byte* currentReadAddress =
-		static_cast<std::byte*>(memoryBasicInformation.BaseAddress);
-	size_t remainingBytesInRegion = memoryBasicInformation.RegionSize;
 
-	for (;;)
+// Pattern index and address of a match
+using raw_match = std::pair<size_t, cry::cvar*>;
+
+// State of a scan shared by all regions and all scanning threads
+class scan_state
+{
+public:
+	// If all is set, every match is appended to it and the scan never stops
+	// before the end. Such a scan must run on a single thread
+	scan_state(
+		const cry::cvar::pattern_set& patterns,
+		const cry::slot_filter& filter,
+		std::vector<raw_match>* all = nullptr) :
+		patterns{patterns},
+		filter{filter},
+		results_{new std::atomic<cry::cvar*>[patterns.size()]},
+		all_{all}
 	{
-		const size_t currentBufferSize =
-			std::min(buffer.size(), remainingBytesInRegion);
-		SIZE_T bytesRead = 0;
-
-		if (!::ReadProcessMemory(
-				::GetCurrentProcess(),
-				currentReadAddress,
-				buffer.data(),
-				currentBufferSize,
-				&bytesRead))
+		for (size_t i = 0; i < patterns.size(); ++i)
+			results_[i].store(nullptr, std::memory_order_relaxed);
+	}
+
+	const cry::cvar::pattern_set& patterns;
+	const cry::slot_filter& filter;
+
+	// true once every pattern has been found or the scan was cancelled
+	bool done() const
+	{
+		return stopped_.load(std::memory_order_relaxed) ||
+			   (!all_ &&
+				foundCount_.load(std::memory_order_relaxed) == patterns.size());
+	}
+
+	bool found(size_t index) const
+	{
+		return !all_ &&
+			   results_[index].load(std::memory_order_relaxed) != nullptr;
+	}
+
+	// Records the address of a pattern, the first address recorded wins
+	void record(size_t index, cry::cvar* var)
+	{
+		if (all_ && staging_)
 		{
-			log::debug(
-				"Could not read {:d} bytes at address {}, stopping region "
-				"scan: {}",
-				currentBufferSize,
-				static_cast<void*>(currentReadAddress),
-				win::get_last_error_as_string());
-			break;
+			if (stagedCount_ < staged_.size())
+				staged_[stagedCount_++] = {index, var};
+			else
+				overflowed_ = true;
 		}
-
-		if (bytesRead == 0)
+		else if (all_)
 		{
-			log::debug(
-				"Read 0 bytes at address {}, stopping region scan",
-				static_cast<void*>(currentReadAddress));
-			break;
+			all_->emplace_back(index, var);
 		}
 
-		// Stop reading buffer before we have an incomplete var_name
-		size_t endOffset = bytesRead - cvarDef.size();
+		cry::cvar* expected = nullptr;
+		if (results_[index].compare_exchange_strong(expected, var))
+			foundCount_.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	size_t found_count() const
+	{
+		return foundCount_.load(std::memory_order_relaxed);
+	}
+
+	void stop() { stopped_.store(true, std::memory_order_relaxed); }
+
+	// Keeps the matches aside in fixed storage until commit or discard, so
+	// that an in-place scan neither allocates nor records its matches twice
+	// when it faults and the range is copied instead
+	// Only scans setting all stage, the others run on several threads
+	void stage() noexcept
+	{
+		if (!all_)
+			return;
+
+		staging_ = true;
+		stagedCount_ = 0;
+		overflowed_ = false;
+	}
+
+	// Appends the staged matches to all
+	// Returns false, keeping none, if they didn't fit
+	bool commit()
+	{
+		if (!all_)
+			return true;
+
+		staging_ = false;
+		if (overflowed_)
+			return false;
+
+		all_->insert(
+			all_->end(), staged_.begin(), staged_.begin() + stagedCount_);
+		return true;
+	}
+
+	void discard() noexcept
+	{
+		if (all_)
+			staging_ = false;
+	}
+
+	std::vector<cry::cvar*> results() const
+	{
+		std::vector<cry::cvar*> r(patterns.size());
+		for (size_t i = 0; i < r.size(); ++i)
+			r[i] = results_[i].load();
+		return r;
+	}
+
+private:
+	std::unique_ptr<std::atomic<cry::cvar*>[]> results_;
+	std::atomic<size_t> foundCount_{0};
+	std::atomic<bool> stopped_{false};
+	std::vector<raw_match>* all_;
+
+	// Matches of the range being scanned in place
+	std::array<raw_match, 256> staged_;
+	size_t stagedCount_ = 0;
+	bool staging_ = false;
+	bool overflowed_ = false;
+};
+
+// Part of a region to scan
+// Slots starting in [base, base + scanSize) are tested, memory up to
+// base + size is read so that CVars starting near the end are complete
+struct scan_range
+{
+	std::byte* base;
+	size_t size;
+	size_t scanSize;
+};
 
-		// CryCVar structs are aligned on multiples of 16 bytes inside pages
-		for (size_t offset = 0; offset < endOffset; offset += 16)
+// Arguments of an in-place scan run by region_source::read_in_place
+struct in_place_scan
+{
+	scan_state* state;
+	scan_range range;
+};
+
+// Per-thread queues of ranges. A thread pops ranges from the front of its
+// own queue and steals from the back of the other queues once it is empty
+class range_queues
+{
+public:
+	explicit range_queues(size_t count) : queues_(count) {}
+
+	void push(size_t queue, const scan_range& range)
+	{
+		queues_[queue].ranges.push_back(range);
+	}
+
+	bool pop(size_t queue, scan_range& range)
+	{
 		{
-			// It's ok to alias to CryEngineCVar* here since g_LookupBuffer is
-			// buffer of std::byte and this type is an exception to the C/C++
-			// aliasing rules
-			const auto cvarInBuffer = static_cast<cry::cvar*>(
-				static_cast<void*>(buffer.data() + offset));
-			if (cvarDef.match(cvarInBuffer))
+			auto& own = queues_[queue];
+			std::lock_guard<std::mutex> lock{own.mutex};
+			if (!own.ranges.empty())
 			{
-				const auto cvarReadAddress = static_cast<cry::cvar*>(
-					static_cast<void*>(currentReadAddress + offset));
-				return cvarReadAddress;
+				range = own.ranges.front();
+				own.ranges.pop_front();
+				return true;
 			}
 		}
 
-		if (bytesRead < remainingBytesInRegion)
+		for (size_t i = 1; i < queues_.size(); ++i)
 		{
-			remainingBytesInRegion -= bytesRead;
-			currentReadAddress += bytesRead;
+			auto& victim = queues_[(queue + i) % queues_.size()];
+			std::lock_guard<std::mutex> lock{victim.mutex};
+			if (!victim.ranges.empty())
+			{
+				range = victim.ranges.back();
+				victim.ranges.pop_back();
+				return true;
+			}
 		}
-		else
+
+		return false;
+	}
+
+private:
+	struct queue
+	{
+		std::mutex mutex;
+		std::deque<scan_range> ranges;
+	};
+
+	std::vector<queue> queues_;
+};
+
+} // namespace
+
+// Tests the slots of data starting below endOffset, data being a view of
+// dataSize bytes of memory at address
+// Does not log nor allocate so that it can run under
+// region_source::read_in_place
+static void ScanSlots(
+	scan_state& state,
+	const std::byte* data,
+	size_t dataSize,
+	size_t endOffset,
+	std::byte* address)
+{
+	// CryCVar structs are aligned on multiples of 16 bytes inside pages
+	// The filter tests a block of slots at once, only its candidates
+	// are matched against the patterns
+	const size_t slotCount = endOffset / cry::slot_filter::slot_size;
+	for (size_t firstSlot = 0; firstSlot < slotCount && !state.done();
+		 firstSlot += cry::slot_filter::max_slots)
+	{
+		auto candidates = state.filter.candidates(
+			data + firstSlot * cry::slot_filter::slot_size,
+			std::min(cry::slot_filter::max_slots, slotCount - firstSlot));
+
+		while (candidates)
 		{
-			break;
+			const size_t offset = (firstSlot + cry::lowest_bit(candidates)) *
+								  cry::slot_filter::slot_size;
+			candidates &= candidates - 1;
+
+			const size_t index =
+				state.patterns.match(data + offset, dataSize - offset);
+			if (index != cry::cvar::pattern_set::npos && !state.found(index))
+			{
+				state.record(
+					index,
+					static_cast<cry::cvar*>(
+						static_cast<void*>(address + offset)));
+			}
 		}
 	}
+}
 
-	return nullptr;
+static void ScanInPlace(void* context, const std::byte* view)
+{
+	const auto& scan = *static_cast<in_place_scan*>(context);
+	ScanSlots(
+		*scan.state,
+		view,
+		scan.range.size,
+		scan.range.scanSize,
+		scan.range.base);
 }
 
-cry::cvar* find_cvar_ptr(
-	const cry::cvar::pattern& cvarDef,
-	std::vector<std::byte>& buffer)
+// Scans a range directly in memory, without copying it
+// Returns false if the range can't be read in place or if a page of the
+// range became unreadable during the scan
+static bool LookupPageInPlace(
+	const scan_range& range,
+	region_source& source,
+	scan_state& state)
 {
-	const std::byte* readAddress = nullptr;
-	MEMORY_BASIC_INFORMATION memoryBasicInformation{};
-	cry::cvar* cvarPtr = nullptr;
+	in_place_scan scan{&state, range};
 
-	log::trace(
-		"find_cvar_ptr: Start of memory scan for variable {}",
-		cvarDef.name());
+	return source.read_in_place(range.base, range.size, &ScanInPlace, &scan);
+}
 
-	for (;;)
+// Scans a range for every pattern not found yet by copying it chunk by
+// chunk in buffer
+static void LookupPage(
+	const scan_range& range,
+	region_source& source,
+	scan_state& state,
+	std::vector<std::byte>& buffer)
+{
+	std::byte* currentReadAddress = range.base;
+	size_t remainingBytesInRange = range.size;
+	size_t remainingBytesToScan = range.scanSize;
+
+	while (!state.done())
 	{
-		log::trace(
-			"Calling VirtualQueryEx with base address {}",
-			static_cast<const void*>(readAddress));
-
-		if (!::VirtualQueryEx(
-				::GetCurrentProcess(),
-				readAddress,
-				&memoryBasicInformation,
-				sizeof(MEMORY_BASIC_INFORMATION)))
+		const size_t currentBufferSize =
+			std::min(buffer.size(), remainingBytesInRange);
+		const size_t bytesRead =
+			source.read(currentReadAddress, buffer.data(), currentBufferSize);
+
+		if (bytesRead == 0)
 		{
 			log::debug(
-				"VirtualQueryEx failed: {}",
-				win::get_last_error_as_string());
+				"Read 0 bytes at address {}, stopping region scan",
+				static_cast<void*>(currentReadAddress));
+			break;
+		}
+
+		// Slots too close to the end of the buffer to hold the longest
+		// pattern are tested again at the start of the next read, unless
+		// this is the end of the range
+		const bool lastRead = bytesRead >= remainingBytesInRange;
+		const size_t endOffset = std::min(
+			remainingBytesToScan,
+			lastRead ? bytesRead :
+					   (bytesRead -
+						std::min(bytesRead, state.patterns.max_size())) &
+						   ~size_t{15});
+
+		ScanSlots(
+			state,
+			buffer.data(),
+			bytesRead,
+			endOffset,
+			currentReadAddress);
+
+		if (lastRead || endOffset == 0 || endOffset == remainingBytesToScan)
 			break;
+
+		remainingBytesInRange -= endOffset;
+		remainingBytesToScan -= endOffset;
+		currentReadAddress += endOffset;
+	}
+}
+
+static void ScanRange(
+	const scan_range& range,
+	region_source& source,
+	scan_state& state,
+	std::vector<std::byte>& buffer,
+	scan_mode mode)
+{
+	// Builds that can't read in place go straight to copies
+	if (mode == scan_mode::in_place && has_in_place_reads)
+	{
+		state.stage();
+		const bool scanned = LookupPageInPlace(range, source, state);
+		if (scanned && state.commit())
+			return;
+
+		// The matches found before a fault are found again by the copy
+		state.discard();
+		if (!scanned)
+		{
+			log::debug(
+				"Range at {} can't be read in place, copying it instead",
+				static_cast<void*>(range.base));
 		}
+		LookupPage(range, source, state, buffer);
+	}
+	else
+	{
+		LookupPage(range, source, state, buffer);
+	}
+}
+
+// Splits a region in ranges of at most chunkSize bytes to scan
+// Each range also covers the beginning of the next one so that CVars
+// crossing the boundary are complete
+template<typename Function>
+static void SplitRegion(
+	const region& candidate,
+	size_t chunkSize,
+	size_t overlap,
+	Function&& f)
+{
+	for (size_t offset = 0; offset < candidate.size; offset += chunkSize)
+	{
+		const size_t remaining = candidate.size - offset;
+		const size_t scanSize = std::min(chunkSize, remaining);
+		f(scan_range{
+			candidate.base + offset,
+			std::min(scanSize + overlap, remaining),
+			scanSize});
+	}
+}
 
-		if (memoryBasicInformation.Type == MEM_PRIVATE &&
-			memoryBasicInformation.State == MEM_COMMIT &&
-			(memoryBasicInformation.Protect == PAGE_READWRITE ||
-			 memoryBasicInformation.Protect == PAGE_EXECUTE_READWRITE))
+static void ScanSequential(
+	region_source& source,
+	scan_state& state,
+	std::vector<std::byte>& buffer,
+	const scan_options& options,
+	size_t overlap)
+{
+	region candidate{};
+	while (!state.done() && source.next(candidate))
+	{
+		const size_t foundBefore = state.found_count();
+
+		SplitRegion(
+			candidate,
+			options.chunk_size,
+			overlap,
+			[&](const scan_range& range) {
+				if (options.cancelled && options.cancelled())
+					state.stop();
+				if (!state.done())
+					ScanRange(range, source, state, buffer, options.mode);
+			});
+
+		if (state.found_count() > foundBefore)
 		{
 			log::trace(
-				"Candidate region at: {} - {:d} bytes - Scanning...",
-				static_cast<void*>(memoryBasicInformation.BaseAddress),
-				memoryBasicInformation.RegionSize);
+				"Found {:d} CryEngine CVars!",
+				state.found_count() - foundBefore);
+		}
+	}
+}
+
+static void ScanParallel(
+	region_source& source,
+	scan_state& state,
+	std::vector<std::byte>& buffer,
+	const scan_options& options,
+	size_t overlap,
+	size_t threadCount)
+{
+	// Regions are enumerated up front, only reads run concurrently
+	std::vector<scan_range> ranges;
+	region candidate{};
+	while (source.next(candidate))
+	{
+		SplitRegion(
+			candidate,
+			options.chunk_size,
+			overlap,
+			[&](const scan_range& range) { ranges.push_back(range); });
+	}
+
+	log::trace(
+		"Scanning {:d} ranges with {:d} threads",
+		ranges.size(),
+		threadCount);
 
-			cvarPtr = LookupPage(memoryBasicInformation, cvarDef, buffer);
+	// Each thread starts with a contiguous share of the ranges
+	range_queues queues{threadCount};
+	for (size_t i = 0; i < ranges.size(); ++i)
+		queues.push(i * threadCount / ranges.size(), ranges[i]);
 
-			if (cvarPtr)
+	const auto worker =
+		[&](size_t index, std::vector<std::byte>& workerBuffer) {
+			scan_range range{};
+			while (!state.done() && queues.pop(index, range))
 			{
-				log::trace("Found CryEngine CVar!");
-				break;
+				// Only the calling thread polls for cancellation
+				if (index == 0 && options.cancelled && options.cancelled())
+					state.stop();
+				else
+					ScanRange(range, source, state, workerBuffer, options.mode);
 			}
+		};
+
+	std::vector<std::vector<std::byte>> buffers(threadCount - 1);
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < threadCount; ++i)
+	{
+		// Also needed in place, for ranges that have to be copied instead
+		buffers[i - 1].resize(buffer.size());
+		threads.emplace_back(worker, i, std::ref(buffers[i - 1]));
+	}
+
+	worker(0, buffer);
+
+	for (auto& thread : threads)
+		thread.join();
+}
+
+std::vector<cry::cvar*> find_cvar_ptrs(
+	region_source& source,
+	const cry::cvar::pattern_set& patterns,
+	std::vector<std::byte>& buffer,
+	const scan_options& options)
+{
+	const cry::slot_filter filter{patterns, options.vtables};
+	scan_state state{patterns, filter};
+
+	// Chunks must be made of whole slots and overlap by the longest pattern
+	const size_t overlap = (patterns.max_size() + 15) & ~size_t{15};
+	scan_options checkedOptions = options;
+	checkedOptions.chunk_size =
+		std::max<size_t>(options.chunk_size & ~size_t{15}, 64 * 1024);
+
+	const size_t threadCount = options.threads == 0 ?
+		std::max(1u, std::thread::hardware_concurrency()) :
+		options.threads;
+
+	log::trace(
+		"find_cvar_ptrs: Start of memory scan for {:d} variables ({} filter, "
+		"{} mode, {:d} threads)",
+		patterns.size(),
+		cry::slot_filter::isa_name(filter.instruction_set()),
+		options.mode == scan_mode::in_place ? "in-place" : "copy",
+		threadCount);
+
+	if (options.mode == scan_mode::in_place && !has_in_place_reads)
+		log::debug("In-place scan is not supported, copying memory instead");
+
+	source.reset();
+
+	if (threadCount > 1)
+	{
+		ScanParallel(
+			source,
+			state,
+			buffer,
+			checkedOptions,
+			overlap,
+			threadCount);
+	}
+	else
+	{
+		ScanSequential(source, state, buffer, checkedOptions, overlap);
+	}
+
+	log::trace("find_cvar_ptrs: End of memory scan");
+
+	return state.results();
+}
+
+struct scanner::impl
+{
+	impl(
+		region_source& source,
+		cry::cvar::pattern_set patterns,
+		std::vector<std::byte>& buffer,
+		const scan_options& options) :
+		source{source},
+		patterns{std::move(patterns)},
+		filter{this->patterns, options.vtables},
+		state{this->patterns, filter},
+		buffer{buffer},
+		options{options},
+		overlap{(this->patterns.max_size() + 15) & ~size_t{15}}
+	{
+	}
+
+	region_source& source;
+	const cry::cvar::pattern_set patterns;
+	const cry::slot_filter filter;
+	scan_state state;
+	std::vector<std::byte>& buffer;
+	const scan_options options;
+	const size_t overlap;
+
+	scan_cursor cursor;
+	size_t scannedBytes = 0;
+};
+
+scanner::scanner(
+	region_source& source,
+	cry::cvar::pattern_set patterns,
+	std::vector<std::byte>& buffer,
+	const scan_options& options) :
+	impl_{std::make_unique<impl>(source, std::move(patterns), buffer, options)}
+{
+	log::trace(
+		"scanner: Start of resumable memory scan for {:d} variables ({} "
+		"filter)",
+		impl_->patterns.size(),
+		cry::slot_filter::isa_name(impl_->filter.instruction_set()));
+
+	source.reset();
+}
+
+scanner::~scanner() = default;
+
+bool scanner::step(const scan_budget& budget)
+{
+	auto& cursor = impl_->cursor;
+	auto& state = impl_->state;
+
+	const auto start = std::chrono::steady_clock::now();
+	size_t stepBytes = 0;
+
+	while (!cursor.finished)
+	{
+		if (budget.bytes != 0 && stepBytes >= budget.bytes)
+			break;
+
+		if (budget.time.count() != 0 &&
+			std::chrono::steady_clock::now() - start >= budget.time)
+		{
+			break;
 		}
-		else
+
+		if (impl_->options.cancelled && impl_->options.cancelled())
+			state.stop();
+
+		if (state.done())
 		{
-			log::trace(
-				"Non-candidate region at: {} - {:d} bytes - Ignoring",
-				static_cast<void*>(memoryBasicInformation.BaseAddress),
-				memoryBasicInformation.RegionSize);
+			cursor.finished = true;
+			break;
+		}
+
+		if (!cursor.has_region)
+		{
+			if (!impl_->source.next(cursor.current))
+			{
+				cursor.finished = true;
+				break;
+			}
+
+			// Sources may return empty regions to bound the work of a call,
+			// the budget is checked again
+			if (cursor.current.size == 0)
+				continue;
+
+			cursor.offset = 0;
+			cursor.has_region = true;
 		}
 
-		const std::byte* nextAddress =
-			static_cast<const std::byte*>(memoryBasicInformation.BaseAddress) +
-			memoryBasicInformation.RegionSize;
+		// Scan one slice of the current region
+		const size_t remaining = cursor.current.size - cursor.offset;
+		const size_t scanSize = std::min(scan_budget::slice_size, remaining);
+		ScanRange(
+			scan_range{
+				cursor.current.base + cursor.offset,
+				std::min(scanSize + impl_->overlap, remaining),
+				scanSize},
+			impl_->source,
+			state,
+			impl_->buffer,
+			impl_->options.mode);
+
+		cursor.offset += scanSize;
+		cursor.has_region = cursor.offset < cursor.current.size;
+		stepBytes += scanSize;
+	}
+
+	impl_->scannedBytes += stepBytes;
 
-#if defined _M_X64
-		constexpr uintptr_t VirtualMemoryMax = 0x7fffffff0000ull;
-#elif defined _M_IX86
-		constexpr uintptr_t VirtualMemoryMax = 0x78000000ul;
-#else
-#	error "Unrecognized architecture"
-#endif
+	if (cursor.finished)
+		log::trace("scanner: End of resumable memory scan");
+
+	return cursor.finished;
+}
+
+bool scanner::finished() const noexcept
+{
+	return impl_->cursor.finished;
+}
+
+const scan_cursor& scanner::cursor() const noexcept
+{
+	return impl_->cursor;
+}
 
-		if (nextAddress >= reinterpret_cast<const std::byte*>(VirtualMemoryMax))
+std::vector<cry::cvar*> scanner::results() const
+{
+	return impl_->state.results();
+}
+
+size_t scanner::scanned_bytes() const noexcept
+{
+	return impl_->scannedBytes;
+}
+
+struct cvar_matches::impl
+{
+	impl(
+		region_source& source,
+		cry::cvar::pattern_set patterns,
+		std::vector<std::byte>& buffer,
+		match_filter matchFilter,
+		const scan_options& options) :
+		source{source},
+		patterns{std::move(patterns)},
+		filter{this->patterns, options.vtables},
+		state{this->patterns, filter, &found},
+		buffer{buffer},
+		matchFilter{std::move(matchFilter)},
+		options{options},
+		overlap{(this->patterns.max_size() + 15) & ~size_t{15}}
+	{
+	}
+
+	// Scans the next slice and queues its matches
+	// Returns false once every region was scanned or the scan was cancelled
+	bool scan_slice();
+
+	region_source& source;
+	const cry::cvar::pattern_set patterns;
+	const cry::slot_filter filter;
+	std::vector<raw_match> found;
+	scan_state state;
+	std::vector<std::byte>& buffer;
+	const match_filter matchFilter;
+	const scan_options options;
+	const size_t overlap;
+
+	scan_cursor cursor;
+	size_t scannedBytes = 0;
+	std::deque<cvar_match> pending;
+	bool started = false;
+};
+
+bool cvar_matches::impl::scan_slice()
+{
+	if (options.cancelled && options.cancelled())
+		state.stop();
+
+	if (state.done())
+		return false;
+
+	if (!cursor.has_region)
+	{
+		if (!source.next(cursor.current))
 		{
-			log::trace("Reached end of user-mode address space!");
-			break;
+			cursor.finished = true;
+			return false;
 		}
-		else if (nextAddress <= readAddress)
+
+		if (cursor.current.size == 0)
+			return true;
+
+		cursor.offset = 0;
+		cursor.has_region = true;
+	}
+
+	const size_t remaining = cursor.current.size - cursor.offset;
+	const size_t scanSize = std::min(scan_budget::slice_size, remaining);
+	ScanRange(
+		scan_range{
+			cursor.current.base + cursor.offset,
+			std::min(scanSize + overlap, remaining),
+			scanSize},
+		source,
+		state,
+		buffer,
+		options.mode);
+
+	cursor.offset += scanSize;
+	cursor.has_region = cursor.offset < cursor.current.size;
+	scannedBytes += scanSize;
+
+	// Matches are copied outside of the guarded scan, the region may have
+	// been freed in between
+	const auto regionEnd = cursor.current.base + cursor.current.size;
+	for (const auto& [index, var] : found)
+	{
+		cvar_match match{var, index, cursor.current, {}};
+		const auto address = static_cast<std::byte*>(static_cast<void*>(var));
+		const auto size = std::min<size_t>(sizeof(cvar), regionEnd - address);
+		if (source.read(address, match.bytes.data(), size) == size)
+			pending.push_back(match);
+	}
+	found.clear();
+
+	return true;
+}
+
+cvar_matches::cvar_matches(
+	region_source& source,
+	cry::cvar::pattern_set patterns,
+	std::vector<std::byte>& buffer,
+	match_filter filter,
+	const scan_options& options) :
+	impl_{std::make_unique<impl>(
+		source, std::move(patterns), buffer, std::move(filter), options)}
+{
+}
+
+cvar_matches::~cvar_matches() = default;
+
+cvar_matches::iterator cvar_matches::begin()
+{
+	if (!impl_->started)
+	{
+		impl_->started = true;
+		log::trace(
+			"cvar_matches: Start of lazy memory scan for {:d} variables",
+			impl_->patterns.size());
+		impl_->source.reset();
+	}
+
+	return advance() ? iterator{this} : end();
+}
+
+const cry::cvar::pattern_set& cvar_matches::patterns() const noexcept
+{
+	return impl_->patterns;
+}
+
+size_t cvar_matches::scanned_bytes() const noexcept
+{
+	return impl_->scannedBytes;
+}
+
+bool cvar_matches::advance()
+{
+	// The front of pending is the current match once it passed the filter
+	for (;;)
+	{
+		while (!impl_->pending.empty())
 		{
-			log::trace("nextAddress <= readAddress - wtf!");
-			break;
+			const auto& front = impl_->pending.front();
+			if (!impl_->matchFilter || impl_->matchFilter(front))
+				return true;
+			impl_->pending.pop_front();
 		}
-		else
+
+		if (!impl_->scan_slice())
 		{
-			readAddress = nextAddress;
+			log::trace("cvar_matches: End of lazy memory scan");
+			return false;
 		}
 	}
+}
 
-	log::trace("find_cvar_ptr: End of memory scan");
+const cvar_match& cvar_matches::iterator::operator*() const
+{
+	return matches_->impl_->pending.front();
+}
 
-	return cvarPtr;
+cvar_matches::iterator& cvar_matches::iterator::operator++()
+{
+	matches_->impl_->pending.pop_front();
+	if (!matches_->advance())
+		matches_ = nullptr;
+	return *this;
+}
+
+std::vector<cry::cvar*> find_cvar_ptrs(
+	const cry::cvar::pattern_set& patterns,
+	std::vector<std::byte>& buffer,
+	const scan_options& options)
+{
+	const auto source = make_process_region_source();
+	return find_cvar_ptrs(*source, patterns, buffer, options);
+}
+
+cry::cvar* find_cvar_ptr(
+	const cry::cvar::pattern& cvarDef,
+	std::vector<std::byte>& buffer,
+	const scan_options& options)
+{
+	return find_cvar_ptrs(cry::cvar::pattern_set{{cvarDef}}, buffer, options)
+		.front();
 }
 
-} // namespace shugoconsole
+} // namespace shugoconsole::cry
@@ -1,15 +1,219 @@
 #ifndef SHUGOCONSOLE_CRY_MEMORY_HPP
 #define SHUGOCONSOLE_CRY_MEMORY_HPP
 
+#include <array>
+#include <chrono>
 #include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <optional>
 #include <vector>
 
 #include "shugoconsole/cry/cvar.hpp"
+#include "shugoconsole/cry/region_source.hpp"
 
 namespace shugoconsole::cry
 {
+// How memory regions are read during a scan
+enum class scan_mode
+{
+	// Copy regions chunk by chunk in a buffer with region_source::read
+	copy,
+	// Read regions directly, guarded against pages disappearing during the
+	// scan. Falls back to copy for regions that can't be read in place
+	in_place
+};
+
+// Options of a memory scan
+struct scan_options
+{
+	scan_mode mode = scan_mode::in_place;
+
+	// Number of threads scanning memory, 0 to use every core
+	// With more than one thread, regions are split in chunks that are
+	// scanned by a small work-stealing pool
+	unsigned threads = 1;
+
+	// Size of the chunks regions are split into
+	size_t chunk_size = 1024 * 1024;
+
+	// Polled between chunks, the scan stops as soon as it returns true
+	std::function<bool()> cancelled;
+
+	// If set, only slots starting with a vtable pointer in this range are
+	// matched against the patterns
+	std::optional<cvar::vtable_range> vtables;
+};
+
+// Scans the process memory for a single CVar
 cvar* find_cvar_ptr(
-	const cvar::pattern& cvarDef, std::vector<std::byte>& buffer);
+	const cvar::pattern& cvarDef,
+	std::vector<std::byte>& buffer,
+	const scan_options& options = {});
+
+// Scans the process memory once for all patterns
+// Returns the address of each CVar, in the same order as patterns, or nullptr
+// for the ones that were not found
+// buffer is used to copy memory and must not be empty
+std::vector<cvar*> find_cvar_ptrs(
+	const cvar::pattern_set& patterns,
+	std::vector<std::byte>& buffer,
+	const scan_options& options = {});
+
+// Scans the regions of source once for all patterns
+std::vector<cvar*> find_cvar_ptrs(
+	region_source& source,
+	const cvar::pattern_set& patterns,
+	std::vector<std::byte>& buffer,
+	const scan_options& options = {});
+
+// Position of a resumable scan
+struct scan_cursor
+{
+	// Region being scanned, valid if has_region is true
+	region current{};
+	// Offset of the next byte of current to scan
+	size_t offset = 0;
+	bool has_region = false;
+	// true once every region was scanned, every pattern was found or the
+	// scan was cancelled
+	bool finished = false;
+};
+
+// Work a single step of a resumable scan may do, 0 means unlimited
+// The budget is checked between slices of at most slice_size bytes, a step
+// can exceed it by one slice
+struct scan_budget
+{
+	static constexpr size_t slice_size = 64 * 1024;
+
+	size_t bytes = 0;
+	std::chrono::microseconds time{0};
+};
+
+// Scan of the regions of a source for all patterns that runs in bounded
+// steps, so that it can be interleaved with waits
+// Steps run on the calling thread, options.threads is ignored
+class scanner final
+{
+public:
+	// buffer is used to copy memory and must not be empty
+	scanner(
+		region_source& source,
+		cvar::pattern_set patterns,
+		std::vector<std::byte>& buffer,
+		const scan_options& options = {});
+	~scanner();
+
+	// Scans from the cursor until the budget is spent or the scan is finished
+	// Returns true once the scan is finished
+	bool step(const scan_budget& budget);
+
+	bool finished() const noexcept;
+	const scan_cursor& cursor() const noexcept;
+
+	// Address of each CVar found so far, in the same order as patterns
+	std::vector<cvar*> results() const;
+
+	// Bytes scanned since the scan started
+	size_t scanned_bytes() const noexcept;
+
+private:
+	struct impl;
+	std::unique_ptr<impl> impl_;
+};
+
+// CVar matching one of the patterns of a scan
+struct cvar_match
+{
+	cvar* var;
+	// Index of the pattern in the pattern set
+	size_t pattern;
+	// Region the CVar was found in
+	region found_in;
+	// Copy of the CVar when it was found, zeroed past the end of the region
+	std::array<std::byte, sizeof(cvar)> bytes;
+
+	inline const cvar& snapshot() const noexcept
+	{
+		const void* data = bytes.data();
+		return *static_cast<const cvar*>(data);
+	}
+};
+
+// Predicate a match must satisfy to be yielded, see match_filters.hpp
+using match_filter = std::function<bool(const cvar_match&)>;
+
+// Lazy scan of the regions of a source that yields every match of the
+// patterns, stale copies of a CVar included, in scan order
+// Memory is scanned one slice at a time when the matches of the previous
+// slices have all been consumed, on the calling thread
+// ```
+// for (const auto& match : cvar_matches{source, patterns, buffer, filter})
+//     ...
+// ```
+class cvar_matches final
+{
+public:
+	class iterator
+	{
+	public:
+		using iterator_category = std::input_iterator_tag;
+		using value_type = cvar_match;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const cvar_match*;
+		using reference = const cvar_match&;
+
+		iterator() = default;
+
+		reference operator*() const;
+		pointer operator->() const { return &**this; }
+		iterator& operator++();
+
+		bool operator==(const iterator& other) const noexcept
+		{
+			return matches_ == other.matches_;
+		}
+		bool operator!=(const iterator& other) const noexcept
+		{
+			return !(*this == other);
+		}
+
+	private:
+		friend class cvar_matches;
+		explicit iterator(cvar_matches* matches) : matches_{matches} {}
+
+		// nullptr once past the last match
+		cvar_matches* matches_ = nullptr;
+	};
+
+	// buffer is used to copy memory and must not be empty
+	// options.threads is ignored
+	cvar_matches(
+		region_source& source,
+		cvar::pattern_set patterns,
+		std::vector<std::byte>& buffer,
+		match_filter filter = {},
+		const scan_options& options = {});
+	~cvar_matches();
+
+	// Starts the scan, can only be called once
+	iterator begin();
+	iterator end() { return {}; }
+
+	const cvar::pattern_set& patterns() const noexcept;
+
+	// Bytes scanned so far
+	size_t scanned_bytes() const noexcept;
+
+private:
+	// Scans until a match passes the filter, returns false at the end
+	bool advance();
+
+	struct impl;
+	std::unique_ptr<impl> impl_;
+};
 }
 
 #endif // SHUGOCONSOLE_CRY_MEMORY_HPP
@@ -0,0 +1,31 @@
+#ifndef SHUGOCONSOLE_CRY_METHOD_ADDRESS_HPP
+#define SHUGOCONSOLE_CRY_METHOD_ADDRESS_HPP
+
+#include <cstring>
+
+namespace shugoconsole::cry
+{
+
+// Code address of a non-virtual method: the first word of the method
+// pointer, with the Itanium and the MSVC single inheritance representations
+template<typename M>
+void* code_of(M m) noexcept
+{
+	static_assert(sizeof(M) >= sizeof(void*));
+	void* code;
+	std::memcpy(&code, &m, sizeof(code));
+	return code;
+}
+
+// Method pointer of type M calling the code at address code
+template<typename M>
+M method_at(void* code) noexcept
+{
+	M m{};
+	std::memcpy(&m, &code, sizeof(code));
+	return m;
+}
+
+} // namespace shugoconsole::cry
+
+#endif // SHUGOCONSOLE_CRY_METHOD_ADDRESS_HPP
@@ -0,0 +1,52 @@
+#include "shugoconsole/cry/override_stats.hpp"
+
+#include <fmt/format.h>
+
+namespace shugoconsole::cry
+{
+
+void override_stats::record(std::chrono::microseconds latency) noexcept
+{
+	if (latency.count() < 0)
+		latency = std::chrono::microseconds{0};
+
+	size_t bucket = 0;
+	while (bucket + 1 < bucket_count &&
+		   latency >= std::chrono::milliseconds{1 << bucket})
+	{
+		++bucket;
+	}
+
+	++overrides;
+	++latency_buckets[bucket];
+	total_latency += latency;
+	if (latency > max_latency)
+		max_latency = latency;
+}
+
+std::string format_latency_histogram(const override_stats& stats)
+{
+	std::string result;
+	for (size_t i = 0; i < override_stats::bucket_count; ++i)
+	{
+		if (stats.latency_buckets[i] == 0)
+			continue;
+
+		if (!result.empty())
+			result += ", ";
+
+		if (i + 1 < override_stats::bucket_count)
+		{
+			result += fmt::format(
+				"<{:d} ms: {:d}", 1 << i, stats.latency_buckets[i]);
+		}
+		else
+		{
+			result += fmt::format(
+				">={:d} ms: {:d}", 1 << (i - 1), stats.latency_buckets[i]);
+		}
+	}
+	return result;
+}
+
+} // namespace shugoconsole::cry
@@ -0,0 +1,40 @@
+#ifndef SHUGOCONSOLE_CRY_OVERRIDE_STATS_HPP
+#define SHUGOCONSOLE_CRY_OVERRIDE_STATS_HPP
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace shugoconsole::cry
+{
+
+// Times the game overwrote the value of a CVar, and how long the configured
+// value took to be restored
+struct override_stats
+{
+	// Bucket 0 counts the latencies below 1 ms, bucket i those below 2^i ms
+	// and the last one every longer latency
+	static constexpr size_t bucket_count = 14;
+
+	std::uint64_t overrides = 0;
+	std::array<std::uint64_t, bucket_count> latency_buckets{};
+	std::chrono::microseconds total_latency{0};
+	std::chrono::microseconds max_latency{0};
+
+	void record(std::chrono::microseconds latency) noexcept;
+
+	std::chrono::microseconds mean_latency() const noexcept
+	{
+		if (overrides == 0)
+			return std::chrono::microseconds{0};
+		return total_latency / static_cast<std::int64_t>(overrides);
+	}
+};
+
+// Formats the non-empty buckets of stats as "<1 ms: 3, <128 ms: 9, ..."
+std::string format_latency_histogram(const override_stats& stats);
+
+} // namespace shugoconsole::cry
+
+#endif // SHUGOCONSOLE_CRY_OVERRIDE_STATS_HPP
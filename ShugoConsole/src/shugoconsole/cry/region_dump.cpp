@@ -0,0 +1,135 @@
+#include "shugoconsole/cry/region_dump.hpp"
+#include "shugoconsole/log.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace shugoconsole::cry::region_dump
+{
+
+namespace
+{
+
+bool is_zero(const std::byte* page)
+{
+	std::uint64_t bits = 0;
+	for (size_t i = 0; i < page_size; i += sizeof(bits))
+	{
+		std::uint64_t word;
+		std::memcpy(&word, page + i, sizeof(word));
+		bits |= word;
+	}
+	return bits == 0;
+}
+
+void pad(std::ofstream& stream)
+{
+	static const char zeros[page_size] = {};
+	const auto position = static_cast<std::uint64_t>(stream.tellp());
+	stream.write(zeros, (page_size - position % page_size) % page_size);
+}
+
+} // namespace
+
+bool write(region_source& source, const std::filesystem::path& path)
+{
+	std::ofstream stream{path, std::ios::binary | std::ios::trunc};
+	if (!stream.is_open())
+	{
+		log::error(
+			"Could not open dump file '{}' for writing.", path.u8string());
+		return false;
+	}
+
+	header h{};
+	std::memcpy(h.magic, magic, sizeof(magic));
+	h.version = version;
+	h.page_size = page_size;
+	h.pointer_size = sizeof(void*);
+	stream.write(reinterpret_cast<const char*>(&h), sizeof(h));
+
+	// Pages are read in batches
+	std::vector<std::byte> buffer(64 * page_size);
+	size_t regionCount = 0;
+	std::uint64_t storedPages = 0;
+	std::uint64_t zeroPages = 0;
+
+	source.reset();
+
+	region r{};
+	while (source.next(r))
+	{
+		// Region headers start on a page boundary
+		pad(stream);
+
+		region_header rh{};
+		rh.base = reinterpret_cast<std::uintptr_t>(r.base);
+		rh.size = r.size;
+		rh.allocation_base = reinterpret_cast<std::uintptr_t>(r.allocation_base);
+		rh.page_count = (r.size + page_size - 1) / page_size;
+
+		const auto headerPosition = stream.tellp();
+		std::vector<std::uint64_t> bitmap(bitmap_words(rh.page_count));
+		stream.write(reinterpret_cast<const char*>(&rh), sizeof(rh));
+		stream.write(
+			reinterpret_cast<const char*>(bitmap.data()),
+			bitmap.size() * sizeof(std::uint64_t));
+		pad(stream);
+
+		for (std::uint64_t page = 0; page < rh.page_count;
+			 page += buffer.size() / page_size)
+		{
+			const auto offset = page * page_size;
+			const auto size = std::min<std::uint64_t>(buffer.size(), r.size - offset);
+
+			// Unreadable memory is stored as zero pages
+			std::fill(buffer.begin(), buffer.end(), std::byte{0});
+			source.read(r.base + offset, buffer.data(), size);
+
+			const auto pages = (size + page_size - 1) / page_size;
+			for (std::uint64_t i = 0; i < pages; ++i)
+			{
+				const auto* data = buffer.data() + i * page_size;
+				if (is_zero(data))
+				{
+					++zeroPages;
+					continue;
+				}
+
+				bitmap[(page + i) / 64] |= std::uint64_t{1} << ((page + i) % 64);
+				stream.write(reinterpret_cast<const char*>(data), page_size);
+				++storedPages;
+			}
+		}
+
+		// Fill the bitmap now that the stored pages are known
+		const auto endPosition = stream.tellp();
+		stream.seekp(headerPosition + std::streamoff{sizeof(rh)});
+		stream.write(
+			reinterpret_cast<const char*>(bitmap.data()),
+			bitmap.size() * sizeof(std::uint64_t));
+		stream.seekp(endPosition);
+
+		++regionCount;
+	}
+
+	if (!stream)
+	{
+		log::error("Could not write dump file '{}'.", path.u8string());
+		return false;
+	}
+
+	log::info(
+		"Dumped {:d} regions to '{}': {:d} pages stored, {:d} zero pages "
+		"elided",
+		regionCount,
+		path.u8string(),
+		storedPages,
+		zeroPages);
+
+	return true;
+}
+
+} // namespace shugoconsole::cry::region_dump
@@ -0,0 +1,73 @@
+#ifndef SHUGOCONSOLE_CRY_REGION_DUMP_HPP
+#define SHUGOCONSOLE_CRY_REGION_DUMP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+#include "shugoconsole/cry/region_source.hpp"
+
+namespace shugoconsole::cry
+{
+
+// Dump of the candidate regions of a source, replayed offline to test and
+// benchmark the scanner against real client heaps
+//
+// Format, all integers are little-endian:
+//   header:  magic "SHUGODMP", u32 version, u32 page size, u32 pointer size,
+//            u32 reserved
+//   regions, one after the other until the end of the file:
+//     u64 base, u64 size, u64 allocation base, u64 page count
+//     bitmap of the stored pages, one u64 word per 64 pages
+//     padding up to a multiple of the page size
+//     stored pages, the pages that are all zeros are elided
+// Page data is aligned on the page size so that it can be memory-mapped
+namespace region_dump
+{
+
+constexpr char magic[8] = {'S', 'H', 'U', 'G', 'O', 'D', 'M', 'P'};
+constexpr std::uint32_t version = 1;
+constexpr std::uint32_t page_size = 4096;
+
+struct header
+{
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t page_size;
+	std::uint32_t pointer_size;
+	std::uint32_t reserved;
+};
+
+struct region_header
+{
+	std::uint64_t base;
+	std::uint64_t size;
+	std::uint64_t allocation_base;
+	std::uint64_t page_count;
+};
+
+static_assert(sizeof(header) == 24);
+static_assert(sizeof(region_header) == 32);
+
+// Number of bitmap words of a region
+constexpr std::uint64_t bitmap_words(std::uint64_t pageCount)
+{
+	return (pageCount + 63) / 64;
+}
+
+// Offset of the page data from the start of a region header
+constexpr std::uint64_t data_offset(std::uint64_t pageCount)
+{
+	const auto size = sizeof(region_header) + bitmap_words(pageCount) * 8;
+	return (size + page_size - 1) / page_size * page_size;
+}
+
+// Writes every region of source to a dump file
+// Returns false if the file could not be written
+bool write(region_source& source, const std::filesystem::path& path);
+
+} // namespace region_dump
+
+} // namespace shugoconsole::cry
+
+#endif // SHUGOCONSOLE_CRY_REGION_DUMP_HPP
@@ -0,0 +1,227 @@
+#include "shugoconsole/cry/region_policy.hpp"
+#include "shugoconsole/log.hpp"
+
+#include <algorithm>
+#include <charconv>
+
+namespace shugoconsole::cry
+{
+
+namespace
+{
+
+unsigned log2_floor(size_t v)
+{
+	unsigned result = 0;
+	while (v >>= 1)
+		++result;
+	return result;
+}
+
+const char* protection_name(region_protection p)
+{
+	return p == region_protection::execute_read_write ? "rwx" : "rw";
+}
+
+} // namespace
+
+std::string to_string(const region_class& c)
+{
+	return fmt::format(
+		"{:d}-{:d}-{}",
+		c.size_class,
+		c.allocation_class,
+		protection_name(c.protection));
+}
+
+std::optional<region_class> parse_region_class(std::string_view s)
+{
+	region_class c{};
+
+	const auto end = s.data() + s.size();
+	auto parsed = std::from_chars(s.data(), end, c.size_class);
+	if (parsed.ec != std::errc{} || parsed.ptr == end || *parsed.ptr != '-')
+		return std::nullopt;
+
+	parsed = std::from_chars(parsed.ptr + 1, end, c.allocation_class);
+	if (parsed.ec != std::errc{} || parsed.ptr == end || *parsed.ptr != '-')
+		return std::nullopt;
+
+	const std::string_view protection{
+		parsed.ptr + 1, static_cast<size_t>(end - parsed.ptr - 1)};
+	if (protection == "rw")
+		c.protection = region_protection::read_write;
+	else if (protection == "rwx")
+		c.protection = region_protection::execute_read_write;
+	else
+		return std::nullopt;
+
+	return c;
+}
+
+std::vector<classified_region> region_policy::classify(region_source& source)
+{
+	std::vector<classified_region> regions;
+	std::map<std::byte*, size_t> allocationSizes;
+
+	region r;
+	source.reset();
+	while (source.next(r))
+	{
+		regions.push_back(classified_region{r, {}});
+		allocationSizes[r.allocation_base] += r.size;
+	}
+
+	for (auto& region : regions)
+	{
+		region.c = region_class{
+			log2_floor(region.r.size),
+			log2_floor(allocationSizes[region.r.allocation_base]),
+			region.r.protection};
+	}
+
+	return regions;
+}
+
+double region_policy::likelihood(const region_class& c) const
+{
+	const auto it = statistics_.find(c);
+	if (it == statistics_.end())
+		return 0.5;
+
+	// Several CVars can be found in the same region
+	return std::min(
+		1.0,
+		static_cast<double>(it->second.hits + 1) /
+			static_cast<double>(it->second.regions + 2));
+}
+
+double region_policy::density(const classified_region& r) const
+{
+	return likelihood(r.c) / static_cast<double>(std::max<size_t>(r.r.size, 1));
+}
+
+bool region_policy::excluded(const classified_region& r) const
+{
+	return excluded(r.c, r.r.size);
+}
+
+bool region_policy::excluded(const region_class& c, size_t size) const
+{
+	if (settings_.large_region_size == 0 || size < settings_.large_region_size)
+		return false;
+
+	const auto it = statistics_.find(c);
+	return it != statistics_.end() && it->second.hits == 0 &&
+		   it->second.regions >= settings_.exclusion_min_regions;
+}
+
+void region_policy::record(
+	region_source& source, const std::vector<cvar*>& found)
+{
+	auto regions = classify(source);
+
+	for (const auto& region : regions)
+		++statistics_[region.c].regions;
+
+	std::sort(
+		regions.begin(),
+		regions.end(),
+		[](const classified_region& a, const classified_region& b) {
+			return a.r.base < b.r.base;
+		});
+
+	for (const auto var : found)
+	{
+		if (var == nullptr)
+			continue;
+
+		// Last region starting at or before the CVar
+		const auto address = static_cast<std::byte*>(static_cast<void*>(var));
+		auto it = std::upper_bound(
+			regions.begin(),
+			regions.end(),
+			address,
+			[](const std::byte* a, const classified_region& region) {
+				return a < region.r.base;
+			});
+
+		if (it != regions.begin() && address < (--it)->r.base + it->r.size)
+			++statistics_[it->c].hits;
+	}
+}
+
+void region_policy::log_statistics() const
+{
+	log::info(
+		"Region policy: {:d} classes, large regions from {:d} bytes are "
+		"skipped after {:d} regions without a CVar",
+		statistics_.size(),
+		settings_.large_region_size,
+		settings_.exclusion_min_regions);
+
+	for (const auto& [c, stats] : statistics_)
+	{
+		// Regions of a class are at least 2^size_class bytes large
+		const bool skipped = excluded(c, size_t{1} << c.size_class);
+
+		log::info(
+			"  {}: {:d} regions, {:d} hits, likelihood {:.3f}{}",
+			to_string(c),
+			stats.regions,
+			stats.hits,
+			likelihood(c),
+			skipped ? ", skipped" : "");
+	}
+}
+
+void prioritized_region_source::reset()
+{
+	regions_.clear();
+	next_ = 0;
+	loaded_ = true;
+	excludedBytes_ = 0;
+
+	auto regions = region_policy::classify(inner_);
+
+	std::vector<std::pair<double, const classified_region*>> order;
+	std::vector<const classified_region*> excluded;
+	for (const auto& region : regions)
+	{
+		if (policy_.excluded(region))
+			excluded.push_back(&region);
+		else
+			order.emplace_back(policy_.density(region), &region);
+	}
+
+	// Regions of the same density keep their address order
+	std::stable_sort(
+		order.begin(), order.end(), [](const auto& a, const auto& b) {
+			return a.first > b.first;
+		});
+
+	for (const auto& [density, region] : order)
+		regions_.push_back(region->r);
+
+	for (const auto region : excluded)
+	{
+		if (exclusion_)
+			excludedBytes_ += region->r.size;
+		else
+			regions_.push_back(region->r);
+	}
+}
+
+bool prioritized_region_source::next(region& r)
+{
+	if (!loaded_)
+		reset();
+
+	if (next_ == regions_.size())
+		return false;
+
+	r = regions_[next_++];
+	return true;
+}
+
+} // namespace shugoconsole::cry
@@ -0,0 +1,159 @@
+#ifndef SHUGOCONSOLE_CRY_REGION_POLICY_HPP
+#define SHUGOCONSOLE_CRY_REGION_POLICY_HPP
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "shugoconsole/cry/cvar.hpp"
+#include "shugoconsole/cry/region_source.hpp"
+
+namespace shugoconsole::cry
+{
+
+// Regions that share hit statistics
+struct region_class
+{
+	// log2 of the size of the region, rounded down
+	unsigned size_class;
+	// log2 of the size of all the regions of its allocation, rounded down
+	unsigned allocation_class;
+	region_protection protection;
+
+	bool operator<(const region_class& other) const noexcept
+	{
+		return std::tie(size_class, allocation_class, protection) <
+			   std::tie(
+				   other.size_class, other.allocation_class, other.protection);
+	}
+};
+
+// Formats c as "<size_class>-<allocation_class>-<rw|rwx>"
+std::string to_string(const region_class& c);
+
+// Parses the output of to_string, returns nullopt if s is invalid
+std::optional<region_class> parse_region_class(std::string_view s);
+
+// Regions of a class seen by previous runs, and CVars found in them
+struct region_class_stats
+{
+	std::uint64_t regions = 0;
+	std::uint64_t hits = 0;
+};
+
+// Region and its class
+struct classified_region
+{
+	region r;
+	region_class c;
+};
+
+struct region_policy_settings
+{
+	// Regions at least this large are skipped once their class was seen in
+	// exclusion_min_regions regions without any hit, 0 to never skip
+	size_t large_region_size = 64 * 1024 * 1024;
+	std::uint64_t exclusion_min_regions = 16;
+};
+
+// Decides which regions are scanned and in which order from the statistics
+// of the regions that held CVars on previous runs
+class region_policy final
+{
+public:
+	explicit region_policy(
+		region_policy_settings s = {},
+		std::map<region_class, region_class_stats> statistics = {}) :
+		settings_{s},
+		statistics_{std::move(statistics)}
+	{
+	}
+
+	// Enumerates the regions of source with their classes
+	static std::vector<classified_region> classify(region_source& source);
+
+	// Probability that a region of class c holds a CVar, estimated with a
+	// prior of one hit in two regions so that unseen classes come first
+	double likelihood(const region_class& c) const;
+
+	// Expected CVars per byte of r, regions are scanned by descending
+	// density, which minimizes the expected bytes scanned before a hit
+	double density(const classified_region& r) const;
+
+	// true if r is a large region of a class that never held a CVar
+	bool excluded(const classified_region& r) const;
+
+	// Counts the regions of source and the CVars found in them, nullptr
+	// entries of found are ignored
+	void record(region_source& source, const std::vector<cvar*>& found);
+
+	const std::map<region_class, region_class_stats>& statistics() const
+	{
+		return statistics_;
+	}
+
+	// Logs the statistics and the decisions they lead to
+	void log_statistics() const;
+
+private:
+	bool excluded(const region_class& c, size_t size) const;
+
+	region_policy_settings settings_;
+	std::map<region_class, region_class_stats> statistics_;
+};
+
+// Region source that returns the regions of another source by descending
+// density according to a policy, without the excluded ones
+class prioritized_region_source final : public region_source
+{
+public:
+	prioritized_region_source(
+		region_source& inner, const region_policy& policy) :
+		inner_{inner},
+		policy_{policy}
+	{
+	}
+
+	// Enumerates and sorts the regions of the inner source
+	void reset() override;
+	bool next(region& r) override;
+
+	size_t read(const std::byte* address, std::byte* buffer, size_t size)
+		override
+	{
+		return inner_.read(address, buffer, size);
+	}
+
+	bool read_in_place(
+		const std::byte* address,
+		size_t size,
+		void (*f)(void* context, const std::byte* view),
+		void* context) override
+	{
+		return inner_.read_in_place(address, size, f, context);
+	}
+
+	// When disabled, excluded regions are returned last
+	void set_exclusion(bool enabled) noexcept { exclusion_ = enabled; }
+
+	// Bytes of the regions excluded from the current pass
+	size_t excluded_bytes() const noexcept { return excludedBytes_; }
+
+private:
+	region_source& inner_;
+	const region_policy& policy_;
+	std::vector<region> regions_;
+	size_t next_ = 0;
+	bool exclusion_ = true;
+	bool loaded_ = false;
+	size_t excludedBytes_ = 0;
+};
+
+} // namespace shugoconsole::cry
+
+#endif // SHUGOCONSOLE_CRY_REGION_POLICY_HPP
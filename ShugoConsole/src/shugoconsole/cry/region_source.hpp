@@ -0,0 +1,73 @@
+#ifndef SHUGOCONSOLE_CRY_REGION_SOURCE_HPP
+#define SHUGOCONSOLE_CRY_REGION_SOURCE_HPP
+
+#include <cstddef>
+#include <memory>
+
+namespace shugoconsole::cry
+{
+
+// Page protection of a region
+enum class region_protection
+{
+	read_write,
+	execute_read_write
+};
+
+// Readable, writable and private memory region that may hold CVars
+struct region
+{
+	std::byte* base;
+	size_t size;
+	// Base address of the allocation the region is part of
+	std::byte* allocation_base;
+	region_protection protection = region_protection::read_write;
+};
+
+// true if the sources of the current process can read in place with this
+// compiler: reads are guarded by structured exceptions on Windows, which
+// only MSVC supports, and by signal handlers elsewhere
+#if defined _WIN32 && !defined _MSC_VER
+constexpr bool has_in_place_reads = false;
+#else
+constexpr bool has_in_place_reads = true;
+#endif
+
+// Source of the memory regions scanned for CVars
+// Regions are enumerated by a single thread, but read() and read_in_place()
+// may be called concurrently
+class region_source
+{
+public:
+	virtual ~region_source() = default;
+
+	// Restarts the enumeration from the lowest address
+	virtual void reset() = 0;
+
+	// Gets the next candidate region, in ascending address order unless the
+	// source documents another order
+	// r may be empty if the source documents it, to bound the work of a call
+	// Returns false once all regions have been enumerated
+	virtual bool next(region& r) = 0;
+
+	// Copies up to size bytes at address into buffer
+	// Returns the number of bytes copied, 0 if the memory can't be read
+	virtual size_t read(const std::byte* address, std::byte* buffer, size_t size) = 0;
+
+	// Calls f(context, view) where view is a readable mirror of the size
+	// bytes at address, without copying them
+	// Returns false if the memory became unreadable while f was running or if
+	// the source can't be read in place, in which case read() must be used
+	virtual bool read_in_place(
+		const std::byte* address,
+		size_t size,
+		void (*f)(void* context, const std::byte* view),
+		void* context) = 0;
+};
+
+// Source of the candidate regions of the current process
+std::unique_ptr<region_source> make_process_region_source();
+
+} // namespace shugoconsole::cry
+
+#endif // SHUGOCONSOLE_CRY_REGION_SOURCE_HPP
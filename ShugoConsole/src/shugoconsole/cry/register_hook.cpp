@@ -0,0 +1,45 @@
+#include "shugoconsole/cry/register_hook.hpp"
+#include "shugoconsole/cry/method_address.hpp"
+
+#include <atomic>
+
+namespace shugoconsole::cry::register_hook
+{
+
+namespace
+{
+
+std::atomic<registered_cvars*> active{nullptr};
+void* trampoline = nullptr;
+
+// this is the console of the engine, the method has the calling convention
+// of the original one
+class replacement final
+{
+public:
+	void register_var(cvar* var, void* on_change)
+	{
+		const auto table = active.load(std::memory_order_acquire);
+		if (table && var)
+			table->record(var);
+
+		using original = void (replacement::*)(cvar*, void*);
+		(this->*method_at<original>(trampoline))(var, on_change);
+	}
+};
+
+} // namespace
+
+target reserve(void* function) noexcept
+{
+	trampoline = function;
+	return target{
+		function, code_of(&replacement::register_var), &trampoline};
+}
+
+void use(registered_cvars* table) noexcept
+{
+	active.store(table, std::memory_order_release);
+}
+
+} // namespace shugoconsole::cry::register_hook
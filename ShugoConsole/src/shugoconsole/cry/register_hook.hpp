@@ -0,0 +1,38 @@
+#ifndef SHUGOCONSOLE_CRY_REGISTER_HOOK_HPP
+#define SHUGOCONSOLE_CRY_REGISTER_HOOK_HPP
+
+#include "shugoconsole/cry/registered_cvars.hpp"
+
+namespace shugoconsole::cry
+{
+
+// Replacement of CXConsole::RegisterVar(ICVar*, ConsoleVarFunc), through which
+// the console registers every CVar once it is constructed: the CVar is
+// recorded, then the original code runs through a trampoline provided by the
+// code installing the hook
+// The replacement has no other way to find its state, so it is process-wide
+namespace register_hook
+{
+
+struct target
+{
+	// Original function, to redirect to replacement
+	void* function;
+	void* replacement;
+	// Holds function until the installer stores there the address that runs
+	// the original code, like the pointer given to DetourAttach
+	void** trampoline;
+};
+
+// Target redirecting function to the replacement
+target reserve(void* function) noexcept;
+
+// Table recording the CVars from now on, nullptr to stop recording. It must
+// outlive the hook
+void use(registered_cvars* table) noexcept;
+
+} // namespace register_hook
+
+} // namespace shugoconsole::cry
+
+#endif // SHUGOCONSOLE_CRY_REGISTER_HOOK_HPP
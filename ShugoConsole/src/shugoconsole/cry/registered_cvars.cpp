@@ -0,0 +1,97 @@
+#include "shugoconsole/cry/registered_cvars.hpp"
+
+#include <cstring>
+
+namespace shugoconsole::cry
+{
+
+std::uint64_t registered_cvars::key_of(std::string_view name) noexcept
+{
+	std::uint64_t hash = 14695981039346656037ull;
+	for (const char c : name)
+	{
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 1099511628211ull;
+	}
+	return hash | 1;
+}
+
+bool registered_cvars::record(cvar* var) noexcept
+{
+	const auto size = ::strnlen(var->name.data(), var->name.size());
+	const auto key = key_of({var->name.data(), size});
+
+	// Linear probing, a slot is claimed by setting its key and then belongs
+	// to the name for good
+	for (size_t n = 0; n < capacity; ++n)
+	{
+		auto& s = slots_[(key + n) & (capacity - 1)];
+		std::uint64_t expected = 0;
+		if (s.key.compare_exchange_strong(
+				expected, key, std::memory_order_relaxed))
+		{
+			size_.fetch_add(1, std::memory_order_relaxed);
+		}
+		else if (expected != key)
+		{
+			continue;
+		}
+
+		// Another registration of the name is written first
+		auto version = s.version.load(std::memory_order_relaxed) & ~1u;
+		while (!s.version.compare_exchange_weak(
+			version, version + 1, std::memory_order_relaxed))
+		{
+			version &= ~1u;
+		}
+		std::atomic_thread_fence(std::memory_order_release);
+
+		s.vtable.store(
+			reinterpret_cast<std::uintptr_t>(var->dummy0),
+			std::memory_order_relaxed);
+		s.var.store(var, std::memory_order_relaxed);
+		s.version.store(version + 2, std::memory_order_release);
+		return true;
+	}
+
+	return false;
+}
+
+std::optional<registered_cvars::registration> registered_cvars::lookup(
+	std::string_view name) const noexcept
+{
+	const auto key = key_of(name);
+
+	for (size_t n = 0; n < capacity; ++n)
+	{
+		const auto& s = slots_[(key + n) & (capacity - 1)];
+		const auto k = s.key.load(std::memory_order_acquire);
+		if (k == 0)
+			break;
+		if (k != key)
+			continue;
+
+		// var and vtable are read again until no registration wrote them
+		// meanwhile
+		for (;;)
+		{
+			const auto version = s.version.load(std::memory_order_acquire);
+			const auto var = s.var.load(std::memory_order_relaxed);
+			const auto vtable = s.vtable.load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (version % 2 != 0 ||
+				s.version.load(std::memory_order_relaxed) != version)
+			{
+				continue;
+			}
+
+			if (!var)
+				return std::nullopt;
+			return registration{var, vtable};
+		}
+	}
+
+	return std::nullopt;
+}
+
+} // namespace shugoconsole::cry
@@ -0,0 +1,74 @@
+#ifndef SHUGOCONSOLE_CRY_REGISTERED_CVARS_HPP
+#define SHUGOCONSOLE_CRY_REGISTERED_CVARS_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "shugoconsole/cry/cvar.hpp"
+
+namespace shugoconsole::cry
+{
+
+// CVars recorded by name as the engine registers them
+// Registrations come from the game threads and lookups from the enforcement
+// thread: nothing allocates, only registrations of one name wait for each
+// other. Each name has one entry, overwritten
+// by the last CVar registered under it, so the table holds at most one
+// entry per CVar name of the engine
+// Names are keyed by a 64-bit hash: a collision returns a CVar of another
+// name, which the liveness check of the caller rejects
+class registered_cvars final
+{
+public:
+	// Power of two, a few times the number of CVars of the engine
+	static constexpr size_t capacity = 8192;
+
+	struct registration
+	{
+		cvar* var;
+		// Vtable pointer of var when it was registered
+		std::uintptr_t vtable;
+	};
+
+	// Records var under the name it holds, in place of the CVar previously
+	// registered under it
+	// Returns false if the name is new and the table is full
+	// Called once var is constructed
+	bool record(cvar* var) noexcept;
+
+	// Last CVar registered under name, nullopt if there is none
+	// The CVar may have been destroyed since, check it before using it
+	std::optional<registration> lookup(std::string_view name) const noexcept;
+
+	// Number of names recorded
+	size_t size() const noexcept
+	{
+		return size_.load(std::memory_order_relaxed);
+	}
+
+private:
+	// FNV-1a hash of name, never 0 which marks free slots
+	static std::uint64_t key_of(std::string_view name) noexcept;
+
+	// var and vtable are a seqlock: version is odd while a registration
+	// writes them, lookups read them again if version changed meanwhile
+	struct slot
+	{
+		std::atomic<std::uint64_t> key{0};
+		std::atomic<std::uint32_t> version{0};
+		std::atomic<std::uintptr_t> vtable{0};
+		// nullptr until the first registration of the name is written
+		std::atomic<cvar*> var{nullptr};
+	};
+
+	std::array<slot, capacity> slots_;
+	std::atomic<size_t> size_{0};
+};
+
+} // namespace shugoconsole::cry
+
+#endif // SHUGOCONSOLE_CRY_REGISTERED_CVARS_HPP
@@ -0,0 +1,172 @@
+#include "shugoconsole/cry/set_hooks.hpp"
+#include "shugoconsole/cry/method_address.hpp"
+
+#include <array>
+#include <atomic>
+#include <utility>
+
+namespace shugoconsole::cry::set_hooks
+{
+
+namespace
+{
+
+std::atomic<set_interceptor*> active{nullptr};
+
+// Reserved functions and their trampolines, written before the hooks are
+// installed and only read by the replacements
+std::array<std::array<void*, max_targets>, method_count> functions{};
+std::array<std::array<void*, max_targets>, method_count> trampolines{};
+
+template<typename T>
+constexpr size_t index(T m)
+{
+	return static_cast<size_t>(m);
+}
+
+// Interceptor in use, whose values stay allocated while this exists: until
+// the original Set returns, for the string given to it
+class active_interceptor final
+{
+public:
+	active_interceptor() noexcept :
+		interceptor_{active.load(std::memory_order_acquire)}
+	{
+		if (interceptor_)
+			interceptor_->begin_read();
+	}
+
+	~active_interceptor()
+	{
+		if (interceptor_)
+			interceptor_->end_read();
+	}
+
+	active_interceptor(const active_interceptor&) = delete;
+	active_interceptor& operator=(const active_interceptor&) = delete;
+
+	set_interceptor* get() const noexcept { return interceptor_; }
+
+private:
+	set_interceptor* interceptor_;
+};
+
+// Returns false if the Set of var must not run, v is otherwise the value to
+// give to the original code
+template<typename T, typename Get>
+bool intercept(
+	const active_interceptor& reading, const void* var, T& v, Get get)
+{
+	const auto interceptor = reading.get();
+	if (!interceptor)
+		return true;
+
+	const auto value = interceptor->find(static_cast<const cvar*>(var));
+	if (!value)
+		return true;
+
+	interceptor->count_intercepted();
+	if (interceptor->action() == set_interceptor::mode::reject)
+		return false;
+
+	v = get(*value);
+	return true;
+}
+
+// Replacement number I of each method, this is the CVar of the engine
+// Methods have the calling convention of the original ones
+template<size_t I>
+class replacement final
+{
+public:
+	void set_string(const char* s)
+	{
+		using original = void (replacement::*)(const char*);
+		const active_interceptor interceptor;
+		if (intercept(interceptor, this, s, [](const cvar_assignment& a) {
+				return a.string_value();
+			}))
+		{
+			(this->*method_at<original>(
+						trampolines[index(method::string)][I]))(s);
+		}
+	}
+
+	void set_float(float f)
+	{
+		using original = void (replacement::*)(float);
+		const active_interceptor interceptor;
+		if (intercept(interceptor, this, f, [](const cvar_assignment& a) {
+				return a.float_value();
+			}))
+		{
+			(this->*method_at<original>(
+						trampolines[index(method::floating)][I]))(f);
+		}
+	}
+
+	void set_int(int i)
+	{
+		using original = void (replacement::*)(int);
+		const active_interceptor interceptor;
+		if (intercept(interceptor, this, i, [](const cvar_assignment& a) {
+				return a.int_value();
+			}))
+		{
+			(this->*method_at<original>(
+						trampolines[index(method::integer)][I]))(i);
+		}
+	}
+};
+
+template<size_t... I>
+std::array<std::array<void*, max_targets>, method_count> make_replacements(
+	std::index_sequence<I...>)
+{
+	return {{
+		{code_of(&replacement<I>::set_string)...},
+		{code_of(&replacement<I>::set_float)...},
+		{code_of(&replacement<I>::set_int)...},
+	}};
+}
+
+const auto replacements =
+	make_replacements(std::make_index_sequence<max_targets>{});
+
+} // namespace
+
+std::optional<target> reserve(method m, void* function) noexcept
+{
+	auto& f = functions[index(m)];
+	for (size_t i = 0; i < max_targets; ++i)
+	{
+		if (f[i] == nullptr)
+		{
+			f[i] = function;
+			trampolines[index(m)][i] = function;
+		}
+
+		if (f[i] == function)
+		{
+			return target{
+				function,
+				replacements[index(m)][i],
+				&trampolines[index(m)][i]};
+		}
+	}
+
+	return std::nullopt;
+}
+
+void release_all() noexcept
+{
+	// Trampolines are kept for a replacement that is still running
+	functions = {};
+}
+
+void use(set_interceptor* interceptor) noexcept
+{
+	active.store(interceptor, std::memory_order_release);
+}
+
+} // namespace shugoconsole::cry::set_hooks
@@ -0,0 +1,59 @@
+#ifndef SHUGOCONSOLE_CRY_SET_HOOKS_HPP
+#define SHUGOCONSOLE_CRY_SET_HOOKS_HPP
+
+#include <cstddef>
+#include <optional>
+
+#include "shugoconsole/cry/set_interceptor.hpp"
+
+namespace shugoconsole::cry
+{
+
+// Replacements of the Set methods of the CVar classes of the engine, through
+// which a set_interceptor rewrites or rejects the writes to managed CVars
+// Each hooked function gets a replacement of its own, that runs the original
+// code through a trampoline provided by the code installing the hooks.
+// Replacements have no other way to find their state, so it is process-wide
+namespace set_hooks
+{
+
+// Hooked methods: Set(const char*), Set(float) and Set(int)
+enum class method
+{
+	string,
+	floating,
+	integer
+};
+
+constexpr size_t method_count = 3;
+
+// Functions hooked per method at most
+constexpr size_t max_targets = 8;
+
+struct target
+{
+	// Original function, to redirect to replacement
+	void* function;
+	void* replacement;
+	// Holds function until the installer stores there the address that runs
+	// the original code, like the pointer given to DetourAttach
+	void** trampoline;
+};
+
+// Reserves a replacement for function, which implements m for a CVar class
+// Returns the previous target if function was already reserved, nullopt if
+// every replacement of m is used
+std::optional<target> reserve(method m, void* function) noexcept;
+
+// Forgets every target, once the hooks are removed
+void release_all() noexcept;
+
+// Interceptor used by the replacements from now on, nullptr to let every Set
+// through. It must outlive the hooks
+void use(set_interceptor* interceptor) noexcept;
+
+} // namespace set_hooks
+
+} // namespace shugoconsole::cry
+
+#endif // SHUGOCONSOLE_CRY_SET_HOOKS_HPP
@@ -0,0 +1,77 @@
+#include "shugoconsole/cry/set_interceptor.hpp"
+
+namespace shugoconsole::cry
+{
+
+size_t set_interceptor::index_of(const cvar* var) const noexcept
+{
+	const auto count = size_.load(std::memory_order_acquire);
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (entries_[i].var.load(std::memory_order_relaxed) == var)
+			return i;
+	}
+	return capacity;
+}
+
+bool set_interceptor::manage(
+	const cvar* var, const std::optional<cvar_assignment>& value)
+{
+	auto published =
+		value ? std::make_unique<const cvar_assignment>(*value) : nullptr;
+
+	auto i = index_of(var);
+	if (i == capacity)
+	{
+		if (!published)
+			return true;
+
+		// Only the enforcement thread changes the entries: an entry without
+		// value is reused, otherwise one is added
+		const auto count = size_.load(std::memory_order_relaxed);
+		i = 0;
+		while (i < count && values_[i])
+			++i;
+		if (i == capacity)
+			return false;
+
+		// A hook that matched the previous CVar of the entry finds out that
+		// the entry changed once it reads the new value
+		entries_[i].var.store(var, std::memory_order_relaxed);
+		entries_[i].value.store(published.get(), std::memory_order_seq_cst);
+		values_[i] = std::move(published);
+		if (i == count)
+			size_.store(i + 1, std::memory_order_release);
+		reclaim();
+		return true;
+	}
+
+	entries_[i].value.store(published.get(), std::memory_order_seq_cst);
+	if (values_[i])
+		retired_.push_back(std::move(values_[i]));
+	values_[i] = std::move(published);
+	reclaim();
+	return true;
+}
+
+const cvar_assignment* set_interceptor::find(const cvar* var) const noexcept
+{
+	const auto i = index_of(var);
+	if (i == capacity)
+		return nullptr;
+
+	// Ordered after begin_read(), see reclaim()
+	const auto value = entries_[i].value.load(std::memory_order_seq_cst);
+	if (entries_[i].var.load(std::memory_order_relaxed) != var)
+		return nullptr;
+	return value;
+}
+
+void set_interceptor::reclaim() noexcept
+{
+	// Hooks that start reading from now on only see the published values
+	if (readers_.load(std::memory_order_seq_cst) == 0)
+		retired_.clear();
+}
+
+} // namespace shugoconsole::cry
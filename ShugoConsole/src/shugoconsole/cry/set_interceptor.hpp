@@ -0,0 +1,100 @@
+#ifndef SHUGOCONSOLE_CRY_SET_INTERCEPTOR_HPP
+#define SHUGOCONSOLE_CRY_SET_INTERCEPTOR_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "shugoconsole/cry/cvar.hpp"
+#include "shugoconsole/cry/cvar_layout.hpp"
+
+namespace shugoconsole::cry
+{
+
+// Values that the hooks of the ICVar::Set family give to the managed CVars
+// instead of the values set by the engine
+// Hooks run on the game threads: lookups neither allocate nor lock, and the
+// table is only changed by the enforcement thread. A value replaced while
+// hooks are reading is freed by a later change, once no hook is reading
+class set_interceptor final
+{
+public:
+	static constexpr size_t capacity = 64;
+
+	enum class mode
+	{
+		// The original Set is called with the configured value
+		rewrite,
+		// The original Set is not called
+		reject
+	};
+
+	explicit set_interceptor(mode m) noexcept : mode_{m} {}
+
+	set_interceptor(const set_interceptor&) = delete;
+	set_interceptor& operator=(const set_interceptor&) = delete;
+
+	// Sets of var get value from now on, or go through if value is nullopt
+	// The entry of a CVar that is not managed anymore is reused
+	// Returns false if the table is full
+	bool manage(const cvar* var, const std::optional<cvar_assignment>& value);
+
+	// Hooks call find() between begin_read() and end_read(), and use the
+	// value until end_read()
+	void begin_read() const noexcept
+	{
+		readers_.fetch_add(1, std::memory_order_seq_cst);
+	}
+	void end_read() const noexcept
+	{
+		readers_.fetch_sub(1, std::memory_order_release);
+	}
+
+	// Value of var if it is managed, nullptr otherwise
+	const cvar_assignment* find(const cvar* var) const noexcept;
+
+	mode action() const noexcept { return mode_; }
+
+	// Called by the hooks for every Set of a managed CVar
+	void count_intercepted() noexcept
+	{
+		intercepted_.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Number of Sets intercepted since the previous call
+	size_t take_intercepted() noexcept
+	{
+		return intercepted_.exchange(0, std::memory_order_relaxed);
+	}
+
+private:
+	struct entry
+	{
+		std::atomic<const cvar*> var{nullptr};
+		std::atomic<const cvar_assignment*> value{nullptr};
+	};
+
+	// Index of var in entries_, capacity if it is not there
+	size_t index_of(const cvar* var) const noexcept;
+
+	// Frees the replaced values if no hook is reading
+	void reclaim() noexcept;
+
+	mode mode_;
+	std::array<entry, capacity> entries_;
+	std::atomic<size_t> size_{0};
+	std::atomic<size_t> intercepted_{0};
+	mutable std::atomic<size_t> readers_{0};
+
+	// Value published by each entry, and the values replaced while a hook
+	// may still read them
+	std::array<std::unique_ptr<const cvar_assignment>, capacity> values_;
+	std::vector<std::unique_ptr<const cvar_assignment>> retired_;
+};
+
+} // namespace shugoconsole::cry
+
+#endif // SHUGOCONSOLE_CRY_SET_INTERCEPTOR_HPP
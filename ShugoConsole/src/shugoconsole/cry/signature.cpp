@@ -0,0 +1,90 @@
+#include "shugoconsole/cry/signature.hpp"
+
+#include <charconv>
+#include <cstring>
+
+namespace shugoconsole::cry
+{
+
+std::optional<signature> signature::parse(std::string_view text)
+{
+	signature s;
+
+	size_t i = 0;
+	while (i < text.size())
+	{
+		if (text[i] == ' ')
+		{
+			++i;
+			continue;
+		}
+
+		const auto token = text.substr(i, 2);
+		if (token.size() != 2 || (i + 2 < text.size() && text[i + 2] != ' '))
+			return std::nullopt;
+
+		if (token == "??")
+		{
+			s.bytes_.push_back(0);
+			s.mask_.push_back(0);
+		}
+		else
+		{
+			std::uint8_t byte;
+			const auto [end, error] = std::from_chars(
+				token.data(), token.data() + token.size(), byte, 16);
+			if (error != std::errc{} || end != token.data() + token.size())
+				return std::nullopt;
+
+			s.bytes_.push_back(byte);
+			s.mask_.push_back(0xff);
+		}
+
+		i += 2;
+	}
+
+	if (s.bytes_.empty())
+		return std::nullopt;
+	return s;
+}
+
+const std::byte* signature::find(
+	const std::byte* first, const std::byte* last) const noexcept
+{
+	if (last - first < static_cast<std::ptrdiff_t>(bytes_.size()))
+		return nullptr;
+
+	// Candidates are found with memchr on the first byte that must match
+	size_t anchor = 0;
+	while (mask_[anchor] == 0 && anchor + 1 < mask_.size())
+		++anchor;
+
+	const auto end = last - bytes_.size() + 1;
+	for (auto p = first + anchor; p < end + anchor;)
+	{
+		if (mask_[anchor] != 0)
+		{
+			p = static_cast<const std::byte*>(std::memchr(
+				p, bytes_[anchor], static_cast<size_t>(end + anchor - p)));
+			if (!p)
+				return nullptr;
+		}
+
+		const auto candidate = p - anchor;
+		size_t i = 0;
+		while (i < bytes_.size() &&
+			   (static_cast<std::uint8_t>(candidate[i]) & mask_[i]) ==
+				   bytes_[i])
+		{
+			++i;
+		}
+		if (i == bytes_.size())
+			return candidate;
+
+		++p;
+	}
+
+	return nullptr;
+}
+
+} // namespace shugoconsole::cry
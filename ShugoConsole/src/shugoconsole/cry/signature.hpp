@@ -0,0 +1,37 @@
+#ifndef SHUGOCONSOLE_CRY_SIGNATURE_HPP
+#define SHUGOCONSOLE_CRY_SIGNATURE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace shugoconsole::cry
+{
+
+// Bytes of code with wildcards, written as "48 89 5C 24 ?? 57"
+class signature final
+{
+public:
+	// Returns nullopt if text is empty or not made of hexadecimal bytes and
+	// ?? separated by spaces
+	static std::optional<signature> parse(std::string_view text);
+
+	// First match in [first, last), nullptr if there is none
+	const std::byte* find(
+		const std::byte* first, const std::byte* last) const noexcept;
+
+	size_t size() const noexcept { return bytes_.size(); }
+
+private:
+	signature() = default;
+
+	std::vector<std::uint8_t> bytes_;
+	// 0xff for the bytes that must match, 0 for the wildcards
+	std::vector<std::uint8_t> mask_;
+};
+
+} // namespace shugoconsole::cry
+
+#endif // SHUGOCONSOLE_CRY_SIGNATURE_HPP
@@ -0,0 +1,402 @@
+#include "shugoconsole/cry/slot_filter.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string>
+
+#if defined _M_X64 || defined _M_IX86 || defined __x86_64__ || defined __i386__
+#	define SHUGOCONSOLE_X86 1
+#	include <immintrin.h>
+#	if defined _MSC_VER
+#		define SHUGOCONSOLE_TARGET_SSE2
+#		define SHUGOCONSOLE_TARGET_AVX2
+#	else
+#		define SHUGOCONSOLE_TARGET_SSE2 __attribute__((target("sse2")))
+#		define SHUGOCONSOLE_TARGET_AVX2 __attribute__((target("avx2")))
+#	endif
+#endif
+
+namespace shugoconsole::cry
+{
+
+namespace
+{
+
+// Offset of the 8-byte word holding the cat byte inside a slot
+constexpr size_t word_offset = offsetof(cvar, cat) / 8 * 8;
+
+// Bytes of the name that are inside the same word as the cat byte
+constexpr size_t name_bytes_in_word = word_offset + 8 - offsetof(cvar, name);
+
+static_assert(offsetof(cvar, name) < word_offset + 8);
+
+// Probe matching a cat of 0 or 1 followed by the first prefix_size bytes of
+// name
+slot_filter::probe make_probe(const std::string& name, size_t prefix_size)
+{
+	std::array<std::uint8_t, 8> mask{};
+	std::array<std::uint8_t, 8> value{};
+
+	mask[offsetof(cvar, cat) - word_offset] = 0xfe;
+
+	for (size_t i = 0; i < prefix_size; ++i)
+	{
+		mask[offsetof(cvar, name) - word_offset + i] = 0xff;
+		value[offsetof(cvar, name) - word_offset + i] =
+			static_cast<std::uint8_t>(name.c_str()[i]);
+	}
+
+	slot_filter::probe p;
+	std::memcpy(&p.mask, mask.data(), sizeof(p.mask));
+	std::memcpy(&p.value, value.data(), sizeof(p.value));
+	return p;
+}
+
+// Number of bytes shared at the start of a and b, including null characters
+size_t common_prefix_size(const std::string& a, const std::string& b)
+{
+	const auto bound = std::min(a.size(), b.size()) + 1;
+	size_t i = 0;
+	while (i < bound && a.c_str()[i] == b.c_str()[i])
+		++i;
+	return i;
+}
+
+// Vtable pointer of the slot
+inline std::uintptr_t slot_vtable(const std::byte* slot)
+{
+	std::uintptr_t vtable;
+	std::memcpy(&vtable, slot + offsetof(cvar, dummy0), sizeof(vtable));
+	return vtable;
+}
+
+// Clears the bits of mask of the slots whose vtable is not in vtables
+std::uint32_t filter_vtables(
+	const cvar::vtable_range& vtables,
+	const std::byte* slots,
+	std::uint32_t mask)
+{
+	for (auto bits = mask; bits; bits &= bits - 1)
+	{
+		const auto i = lowest_bit(bits);
+		const auto vtable = slot_vtable(slots + i * slot_filter::slot_size);
+		if (!vtables.contains(vtable))
+			mask &= ~(std::uint32_t{1} << i);
+	}
+	return mask;
+}
+
+std::uint32_t scalar_kernel(
+	const slot_filter::probe* probes,
+	size_t probe_count,
+	const cvar::vtable_range* vtables,
+	const std::byte* slots,
+	size_t count)
+{
+	std::uint32_t result = 0;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		// The vtable test is the cheapest one
+		if (vtables &&
+			!vtables->contains(slot_vtable(slots + i * slot_filter::slot_size)))
+		{
+			continue;
+		}
+
+		std::uint64_t word;
+		std::memcpy(
+			&word,
+			slots + i * slot_filter::slot_size + word_offset,
+			sizeof(word));
+
+		for (size_t p = 0; p < probe_count; ++p)
+		{
+			if ((word & probes[p].mask) == probes[p].value)
+			{
+				result |= std::uint32_t{1} << i;
+				break;
+			}
+		}
+	}
+
+	return result;
+}
+
+#if defined SHUGOCONSOLE_X86
+
+// Packs the words holding the cat byte of two consecutive slots
+SHUGOCONSOLE_TARGET_SSE2 inline __m128i sse2_load_words(const std::byte* slots)
+{
+	const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(slots));
+	const __m128i b = _mm_loadu_si128(
+		reinterpret_cast<const __m128i*>(slots + slot_filter::slot_size));
+	return word_offset == 0 ? _mm_unpacklo_epi64(a, b) :
+							  _mm_unpackhi_epi64(a, b);
+}
+
+SHUGOCONSOLE_TARGET_SSE2 std::uint32_t sse2_kernel(
+	const slot_filter::probe* probes,
+	size_t probe_count,
+	const cvar::vtable_range* vtables,
+	const std::byte* slots,
+	size_t count)
+{
+	__m128i masks[slot_filter::max_probes];
+	__m128i values[slot_filter::max_probes];
+	for (size_t p = 0; p < probe_count; ++p)
+	{
+		masks[p] = _mm_set1_epi64x(static_cast<long long>(probes[p].mask));
+		values[p] = _mm_set1_epi64x(static_cast<long long>(probes[p].value));
+	}
+
+	std::uint32_t result = 0;
+	size_t i = 0;
+
+	// SSE2 has no 64-bit compare, a word matches when both of its 32-bit
+	// halves are equal
+	for (; i + 2 <= count; i += 2)
+	{
+		const __m128i words =
+			sse2_load_words(slots + i * slot_filter::slot_size);
+
+		int matched = 0;
+		for (size_t p = 0; p < probe_count; ++p)
+		{
+			const int bits = _mm_movemask_ps(_mm_castsi128_ps(
+				_mm_cmpeq_epi32(_mm_and_si128(words, masks[p]), values[p])));
+			matched |= bits & (bits >> 1);
+		}
+
+		result |= static_cast<std::uint32_t>(
+					  (matched & 1) | ((matched >> 1) & 2))
+				  << i;
+	}
+
+	// SSE2 has no 64-bit compare either, vtables of the few slots left are
+	// tested one by one
+	if (vtables)
+		result = filter_vtables(*vtables, slots, result);
+
+	if (i < count)
+	{
+		result |= scalar_kernel(
+					  probes,
+					  probe_count,
+					  vtables,
+					  slots + i * slot_filter::slot_size,
+					  count - i)
+				  << i;
+	}
+
+	return result;
+}
+
+SHUGOCONSOLE_TARGET_AVX2 std::uint32_t avx2_kernel(
+	const slot_filter::probe* probes,
+	size_t probe_count,
+	const cvar::vtable_range* vtables,
+	const std::byte* slots,
+	size_t count)
+{
+	__m256i masks[slot_filter::max_probes];
+	__m256i values[slot_filter::max_probes];
+	for (size_t p = 0; p < probe_count; ++p)
+	{
+		masks[p] = _mm256_set1_epi64x(static_cast<long long>(probes[p].mask));
+		values[p] = _mm256_set1_epi64x(static_cast<long long>(probes[p].value));
+	}
+
+	// User-mode addresses are below 2^63, signed compares work on them
+	const __m256i pointerMask = _mm256_set1_epi64x(
+		sizeof(void*) == 8 ? -1ll : static_cast<long long>(0xffffffffull));
+	const __m256i vtableFirst = _mm256_set1_epi64x(
+		vtables ? static_cast<long long>(vtables->first) : 0);
+	const __m256i vtableLast = _mm256_set1_epi64x(
+		vtables ? static_cast<long long>(vtables->last) : 0);
+
+	std::uint32_t result = 0;
+	size_t i = 0;
+
+	// Four slots are compared per instruction
+	for (; i + 4 <= count; i += 4)
+	{
+		const std::byte* first = slots + i * slot_filter::slot_size;
+		const __m256i a =
+			_mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+		const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+			first + 2 * slot_filter::slot_size));
+
+		// Unpacking works per 128-bit lane and yields slots 0, 2, 1, 3
+		const __m256i words = _mm256_permute4x64_epi64(
+			word_offset == 0 ? _mm256_unpacklo_epi64(a, b) :
+							   _mm256_unpackhi_epi64(a, b),
+			0xd8);
+
+		int matched = 0;
+		for (size_t p = 0; p < probe_count; ++p)
+		{
+			matched |= _mm256_movemask_pd(
+				_mm256_castsi256_pd(_mm256_cmpeq_epi64(
+					_mm256_and_si256(words, masks[p]), values[p])));
+		}
+
+		if (vtables && matched)
+		{
+			// Words at offset 0 of the slots, in order
+			const __m256i pointers = _mm256_and_si256(
+				word_offset == 0 ?
+					words :
+					_mm256_permute4x64_epi64(_mm256_unpacklo_epi64(a, b), 0xd8),
+				pointerMask);
+			const __m256i outside = _mm256_or_si256(
+				_mm256_cmpgt_epi64(vtableFirst, pointers),
+				_mm256_cmpgt_epi64(pointers, vtableLast));
+			matched &= ~_mm256_movemask_pd(_mm256_castsi256_pd(outside));
+		}
+
+		result |= static_cast<std::uint32_t>(matched) << i;
+	}
+
+	if (i < count)
+	{
+		result |= sse2_kernel(
+					  probes,
+					  probe_count,
+					  vtables,
+					  slots + i * slot_filter::slot_size,
+					  count - i)
+				  << i;
+	}
+
+	return result;
+}
+
+#endif // SHUGOCONSOLE_X86
+
+} // namespace
+
+slot_filter::isa slot_filter::best_isa()
+{
+#if defined SHUGOCONSOLE_X86
+#	if defined _MSC_VER
+	int regs[4];
+	__cpuid(regs, 0);
+	const int max_leaf = regs[0];
+
+	__cpuid(regs, 1);
+	const bool sse2 = (regs[3] & (1 << 26)) != 0;
+	const bool osxsave = (regs[2] & (1 << 27)) != 0;
+	const bool avx = (regs[2] & (1 << 28)) != 0;
+
+	bool avx2 = false;
+	// AVX registers must also be enabled by the OS
+	if (max_leaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6)
+	{
+		__cpuidex(regs, 7, 0);
+		avx2 = (regs[1] & (1 << 5)) != 0;
+	}
+#	else
+	const bool sse2 = __builtin_cpu_supports("sse2");
+	const bool avx2 = __builtin_cpu_supports("avx2");
+#	endif
+
+	if (avx2)
+		return isa::avx2;
+	if (sse2)
+		return isa::sse2;
+#endif
+
+	return isa::scalar;
+}
+
+const char* slot_filter::isa_name(isa i)
+{
+	switch (i)
+	{
+	case isa::scalar:
+		return "scalar";
+	case isa::sse2:
+		return "sse2";
+	case isa::avx2:
+		return "avx2";
+	default:
+		return "unknown";
+	}
+}
+
+slot_filter::slot_filter(
+	const cvar::pattern_set& patterns,
+	std::optional<cvar::vtable_range> vtables,
+	isa i) :
+	vtables_{vtables},
+	isa_{i}
+{
+	if (patterns.size() <= max_probes)
+	{
+		// One probe per pattern with as many name bytes as the word holds
+		for (size_t p = 0; p < patterns.size(); ++p)
+		{
+			const auto name = patterns[p].name();
+			probes_.push_back(make_probe(
+				name, std::min(name.size() + 1, name_bytes_in_word)));
+		}
+	}
+	else
+	{
+		// Group patterns by first name byte and keep the prefix shared by
+		// every pattern of a group
+		std::map<char, std::pair<std::string, size_t>> groups;
+		for (size_t p = 0; p < patterns.size(); ++p)
+		{
+			const auto name = patterns[p].name();
+			const auto it = groups.find(name.c_str()[0]);
+			if (it == groups.end())
+			{
+				groups.emplace(
+					name.c_str()[0],
+					std::make_pair(
+						name, std::min(name.size() + 1, name_bytes_in_word)));
+			}
+			else
+			{
+				it->second.second = std::min(
+					it->second.second,
+					common_prefix_size(it->second.first, name));
+			}
+		}
+
+		if (groups.size() <= max_probes)
+		{
+			for (const auto& group : groups)
+				probes_.push_back(
+					make_probe(group.second.first, group.second.second));
+		}
+		else
+		{
+			// Too many different names, only test the cat byte
+			probes_.push_back(make_probe({}, 0));
+		}
+	}
+
+	switch (isa_)
+	{
+#if defined SHUGOCONSOLE_X86
+	case isa::avx2:
+		kernel_ = &avx2_kernel;
+		break;
+
+	case isa::sse2:
+		kernel_ = &sse2_kernel;
+		break;
+#endif
+
+	default:
+		isa_ = isa::scalar;
+		kernel_ = &scalar_kernel;
+		break;
+	}
+}
+
+} // namespace shugoconsole::cry
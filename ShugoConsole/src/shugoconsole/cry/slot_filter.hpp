@@ -0,0 +1,106 @@
+#ifndef SHUGOCONSOLE_CRY_SLOT_FILTER_HPP
+#define SHUGOCONSOLE_CRY_SLOT_FILTER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "shugoconsole/cry/cvar.hpp"
+
+#if defined _MSC_VER
+#	include <intrin.h>
+#endif
+
+namespace shugoconsole::cry
+{
+
+// Vectorized prefilter of the 16-byte slots that may hold a CVar of a
+// pattern set
+// The 8-byte words holding the cat byte of several slots are packed in a
+// single register and compared with a few masked probes built from the cat
+// byte and the first name bytes of the patterns. When a vtable range is
+// known, the first pointer of the slots must also be inside it. Only the
+// slots passing both tests need to go through cvar::pattern_set::match
+class slot_filter final
+{
+public:
+	// CryCVar structs are aligned on multiples of 16 bytes inside pages
+	static constexpr size_t slot_size = 16;
+
+	// Maximum number of slots tested by a single call to candidates()
+	static constexpr size_t max_slots = 32;
+
+	// Above this number of probes, patterns are grouped by first name byte
+	static constexpr size_t max_probes = 4;
+
+	// Instruction sets the filter can run on
+	enum class isa
+	{
+		scalar,
+		sse2,
+		avx2
+	};
+
+	// Best instruction set supported by the CPU
+	static isa best_isa();
+
+	static const char* isa_name(isa i);
+
+	explicit slot_filter(
+		const cvar::pattern_set& patterns,
+		std::optional<cvar::vtable_range> vtables = std::nullopt,
+		isa i = best_isa());
+
+	// Bitmask of the slots that may hold a CVar among count consecutive
+	// slots starting at slots, with count <= max_slots
+	inline std::uint32_t candidates(const std::byte* slots, size_t count) const
+	{
+		return kernel_(
+			probes_.data(),
+			probes_.size(),
+			vtables_ ? &*vtables_ : nullptr,
+			slots,
+			count);
+	}
+
+	inline isa instruction_set() const noexcept { return isa_; }
+
+	// Masked comparison of the 8-byte word of a slot holding the cat byte:
+	// (word & mask) == value
+	struct probe
+	{
+		std::uint64_t mask;
+		std::uint64_t value;
+	};
+
+private:
+	using kernel = std::uint32_t (*)(
+		const probe* probes,
+		size_t probe_count,
+		const cvar::vtable_range* vtables,
+		const std::byte* slots,
+		size_t count);
+
+	std::vector<probe> probes_;
+	std::optional<cvar::vtable_range> vtables_;
+	isa isa_;
+	kernel kernel_;
+};
+
+// Index of the lowest bit set in a non-zero mask
+inline unsigned lowest_bit(std::uint32_t mask)
+{
+#if defined _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return static_cast<unsigned>(index);
+#else
+	return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+} // namespace shugoconsole::cry
+
+#endif // SHUGOCONSOLE_CRY_SLOT_FILTER_HPP
@@ -0,0 +1,71 @@
+#include "shugoconsole/cry/watched_pages.hpp"
+
+namespace shugoconsole::cry
+{
+
+size_t watched_pages::find(std::uintptr_t page) const noexcept
+{
+	const auto count = size_.load(std::memory_order_acquire);
+	for (size_t i = 0; i < count; ++i)
+	{
+		if ((entries_[i].load(std::memory_order_relaxed) & ~armed_bit) == page)
+			return i;
+	}
+	return capacity;
+}
+
+bool watched_pages::arm(std::uintptr_t page) noexcept
+{
+	// Only the protecting thread adds and removes pages
+	auto i = find(page);
+	if (i == capacity)
+		i = find(0);
+	if (i == capacity)
+	{
+		i = size_.load(std::memory_order_relaxed);
+		if (i == capacity)
+			return false;
+		size_.store(i + 1, std::memory_order_release);
+	}
+
+	entries_[i].store(page | armed_bit, std::memory_order_release);
+	return true;
+}
+
+bool watched_pages::armed(std::uintptr_t page) const noexcept
+{
+	const auto i = find(page);
+	return i != capacity &&
+		   (entries_[i].load(std::memory_order_acquire) & armed_bit) != 0;
+}
+
+bool watched_pages::release(std::uintptr_t page) noexcept
+{
+	const auto i = find(page);
+	if (i == capacity)
+		return false;
+
+	const auto entry = entries_[i].exchange(0, std::memory_order_acq_rel);
+	releases_.fetch_add(1, std::memory_order_release);
+	return entry == (page | armed_bit);
+}
+
+bool watched_pages::on_write(std::uintptr_t page) noexcept
+{
+	const auto i = find(page);
+	if (i == capacity)
+		return false;
+
+	// Fails if the entry was released or reused in the meantime
+	auto expected = page | armed_bit;
+	if (!entries_[i].compare_exchange_strong(
+			expected, page, std::memory_order_acq_rel))
+	{
+		return false;
+	}
+
+	writes_.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+} // namespace shugoconsole::cry
@@ -0,0 +1,83 @@
+#ifndef SHUGOCONSOLE_CRY_WATCHED_PAGES_HPP
+#define SHUGOCONSOLE_CRY_WATCHED_PAGES_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace shugoconsole::cry
+{
+
+// Pages write-protected until something writes to them, shared between the
+// thread that protects them and the fault handler that catches the writes
+// Every member can be called from the handler: nothing allocates or locks.
+// A page is forgotten once released: a write that faulted just before its
+// page was released is not recognised, the handler retries it if the page
+// is writable by then
+class watched_pages final
+{
+public:
+	static constexpr size_t capacity = 64;
+
+	// Adds page and marks it armed, returns false if the set is full
+	// Called by the protecting thread, before page is protected
+	bool arm(std::uintptr_t page) noexcept;
+
+	// true if page is armed, it is then already protected
+	bool armed(std::uintptr_t page) const noexcept;
+
+	// Forgets page, returns false if page was not armed anymore: the handler
+	// caught a write to it and makes it writable
+	// Called by the protecting thread, before page is made writable
+	bool release(std::uintptr_t page) noexcept;
+
+	// Disarms page, returns true if it was armed: the handler then makes it
+	// writable and resumes the write
+	bool on_write(std::uintptr_t page) noexcept;
+
+	// Number of releases so far, for the handlers that can't check if a page
+	// not armed anymore is writable
+	std::uint64_t releases() const noexcept
+	{
+		return releases_.load(std::memory_order_acquire);
+	}
+
+	// Calls f(page) for every page added and not released, armed or not
+	template<typename F>
+	void for_each_page(F&& f) const
+	{
+		const auto count = size_.load(std::memory_order_acquire);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const auto entry = entries_[i].load(std::memory_order_acquire);
+			if (entry != 0)
+				f(entry & ~armed_bit);
+		}
+	}
+
+	// Number of writes caught since the previous call
+	size_t take_writes() noexcept
+	{
+		return writes_.exchange(0, std::memory_order_acq_rel);
+	}
+
+private:
+	// Entries are a page address with armed_bit set while it is armed, so
+	// that the handler disarms the page it found with a single exchange
+	// 0 marks free entries
+	static constexpr std::uintptr_t armed_bit = 1;
+
+	// Index of page in entries_, capacity if it is not there
+	size_t find(std::uintptr_t page) const noexcept;
+
+	std::array<std::atomic<std::uintptr_t>, capacity> entries_{};
+	// Entries used so far, free entries below are reused first
+	std::atomic<size_t> size_{0};
+	std::atomic<size_t> writes_{0};
+	std::atomic<std::uint64_t> releases_{0};
+};
+
+} // namespace shugoconsole::cry
+
+#endif // SHUGOCONSOLE_CRY_WATCHED_PAGES_HPP
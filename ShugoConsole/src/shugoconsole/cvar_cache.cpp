@@ -0,0 +1,45 @@
+#include "shugoconsole/cvar_cache.hpp"
+#include "shugoconsole/toml_file.hpp"
+
+#include <string>
+
+#include <fmt/format.h>
+
+namespace shugoconsole
+{
+
+cvar_cache cvar_cache::from_file(const std::filesystem::path& cachePath)
+{
+	const auto read = [](const toml::value& root) {
+		cvar_cache cache;
+		cache.fingerprint = std::stoull(
+			toml::find<std::string>(root, "fingerprint"),
+			nullptr,
+			16);
+
+		for (const auto& [name, value] :
+			 toml::find<toml::table>(root, "hints"))
+		{
+			cache.hints.emplace(
+				name,
+				cry::address_hint{
+					static_cast<std::uintptr_t>(value.as_integer())});
+		}
+
+		return cache;
+	};
+
+	return read_toml_file(cachePath, "CVar cache", read).value_or(cvar_cache{});
+}
+
+void cvar_cache::save(const std::filesystem::path& cachePath) const
+{
+	auto text =
+		fmt::format("fingerprint = \"{:016x}\"\n[hints]\n", fingerprint);
+	for (const auto& [name, hint] : hints)
+		text += fmt::format("\"{}\" = {}\n", name, hint.allocation_offset);
+
+	write_toml_file(cachePath, "CVar cache", text);
+}
+
+} // namespace shugoconsole
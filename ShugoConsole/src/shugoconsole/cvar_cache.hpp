@@ -0,0 +1,35 @@
+#ifndef SHUGOCONSOLE_CVAR_CACHE_HPP
+#define SHUGOCONSOLE_CVAR_CACHE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+
+#include "shugoconsole/cry/address_hint.hpp"
+
+namespace shugoconsole
+{
+
+// Where each CVar was found by a previous run, valid for the client build
+// identified by fingerprint
+// Stored as a TOML file next to config.toml:
+// ```
+// fingerprint = "0123456789abcdef"
+// [hints]
+// g_minFov = 1234
+// ```
+struct cvar_cache final
+{
+	std::uint64_t fingerprint = 0;
+	std::map<std::string, cry::address_hint> hints;
+
+	// Returns an empty cache if the file does not exist or is invalid
+	static cvar_cache from_file(const std::filesystem::path& cachePath);
+
+	void save(const std::filesystem::path& cachePath) const;
+};
+
+} // namespace shugoconsole
+
+#endif // SHUGOCONSOLE_CVAR_CACHE_HPP
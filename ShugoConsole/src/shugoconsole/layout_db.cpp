@@ -0,0 +1,65 @@
+#include "shugoconsole/layout_db.hpp"
+#include "shugoconsole/log.hpp"
+#include "shugoconsole/toml_file.hpp"
+
+#include <string>
+
+#include <fmt/format.h>
+
+namespace shugoconsole
+{
+
+layout_db layout_db::from_file(const std::filesystem::path& dbPath)
+{
+	const auto read = [](const toml::value& root) {
+		layout_db db;
+		for (const auto& [key, value] :
+			 toml::find<toml::table>(root, "layouts"))
+		{
+			const auto& offsets = value.as_array();
+			if (offsets.size() != 4)
+			{
+				log::warn("Ignoring invalid CVar layout of '{}'", key);
+				continue;
+			}
+
+			const auto offset = [&](size_t i) {
+				return static_cast<size_t>(offsets[i].as_integer());
+			};
+			db.layouts.emplace(
+				std::stoull(key, nullptr, 16),
+				cry::cvar_layout{offset(0), offset(1), offset(2), offset(3)});
+		}
+
+		return db;
+	};
+
+	return read_toml_file(dbPath, "CVar layout", read).value_or(layout_db{});
+}
+
+void layout_db::save(const std::filesystem::path& dbPath) const
+{
+	std::string text = "[layouts]\n";
+	for (const auto& [fingerprint, layout] : layouts)
+	{
+		text += fmt::format(
+			"\"{:016x}\" = [{}, {}, {}, {}]\n",
+			fingerprint,
+			layout.int_offset,
+			layout.float_offset,
+			layout.string_offset,
+			layout.string_size);
+	}
+
+	write_toml_file(dbPath, "CVar layout", text);
+}
+
+std::optional<cry::cvar_layout> layout_db::find(std::uint64_t fingerprint) const
+{
+	const auto it = layouts.find(fingerprint);
+	if (it == layouts.end())
+		return std::nullopt;
+	return it->second;
+}
+
+} // namespace shugoconsole
@@ -0,0 +1,37 @@
+#ifndef SHUGOCONSOLE_LAYOUT_DB_HPP
+#define SHUGOCONSOLE_LAYOUT_DB_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+
+#include "shugoconsole/cry/cvar_layout.hpp"
+
+namespace shugoconsole
+{
+
+// CVar value layout of each client build seen, identified by fingerprint
+// Stored as a TOML file next to config.toml, each fingerprint maps to the
+// int, float and string offsets and the string size:
+// ```
+// [layouts]
+// "0123456789abcdef" = [184, 188, 192, 256]
+// ```
+struct layout_db final
+{
+	std::map<std::uint64_t, cry::cvar_layout> layouts;
+
+	// Returns an empty database if the file does not exist or is invalid
+	static layout_db from_file(const std::filesystem::path& dbPath);
+
+	void save(const std::filesystem::path& dbPath) const;
+
+	// Layout of the client build identified by fingerprint, nullopt if the
+	// build was never seen
+	std::optional<cry::cvar_layout> find(std::uint64_t fingerprint) const;
+};
+
+} // namespace shugoconsole
+
+#endif // SHUGOCONSOLE_LAYOUT_DB_HPP
@@ -0,0 +1,220 @@
+#include "shugoconsole/posix/dump_region_source.hpp"
+#include "shugoconsole/cry/region_dump.hpp"
+#include "shugoconsole/log.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace shugoconsole::posix
+{
+
+namespace dump = cry::region_dump;
+
+dump_region_source::~dump_region_source()
+{
+	for (const auto& region : regions_)
+		::munmap(region.r.base, region.mapped_size);
+}
+
+std::unique_ptr<dump_region_source> dump_region_source::open(
+	const std::filesystem::path& path)
+{
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		log::error("Could not open dump file '{}'.", path.u8string());
+		return nullptr;
+	}
+
+	struct stat st{};
+	::fstat(fd, &st);
+	const auto fileSize = static_cast<std::uint64_t>(st.st_size);
+
+	std::unique_ptr<dump_region_source> source{new dump_region_source};
+
+	const auto fail = [&](const char* reason) {
+		log::error("Invalid dump file '{}': {}", path.u8string(), reason);
+		::close(fd);
+		return nullptr;
+	};
+
+	dump::header h{};
+	if (::pread(fd, &h, sizeof(h), 0) != sizeof(h) ||
+		std::memcmp(h.magic, dump::magic, sizeof(dump::magic)) != 0)
+	{
+		return fail("bad header");
+	}
+
+	if (h.version != dump::version || h.page_size != dump::page_size ||
+		static_cast<long>(h.page_size) % ::sysconf(_SC_PAGESIZE) != 0)
+	{
+		return fail("unsupported version or page size");
+	}
+
+	if (h.pointer_size != sizeof(void*))
+		return fail("dumped by a process with another pointer size");
+
+	std::vector<std::uint64_t> bitmap;
+	for (std::uint64_t position = dump::page_size; position < fileSize;)
+	{
+		dump::region_header rh{};
+		if (::pread(fd, &rh, sizeof(rh), static_cast<off_t>(position)) !=
+			sizeof(rh))
+		{
+			return fail("truncated region header");
+		}
+
+		bitmap.resize(dump::bitmap_words(rh.page_count));
+		const auto bitmapSize = bitmap.size() * sizeof(std::uint64_t);
+		if (::pread(
+				fd,
+				bitmap.data(),
+				bitmapSize,
+				static_cast<off_t>(position + sizeof(rh))) !=
+			static_cast<ssize_t>(bitmapSize))
+		{
+			return fail("truncated page bitmap");
+		}
+
+		// Zero pages come from an anonymous mapping, stored pages are mapped
+		// over it
+		const size_t mappedSize = rh.page_count * dump::page_size;
+		void* base = ::mmap(
+			nullptr,
+			mappedSize,
+			PROT_READ,
+			MAP_PRIVATE | MAP_ANONYMOUS,
+			-1,
+			0);
+		if (base == MAP_FAILED)
+			return fail("could not reserve memory");
+
+		auto* bytes = static_cast<std::byte*>(base);
+		source->regions_.push_back(mapped_region{
+			cry::region{
+				bytes,
+				static_cast<size_t>(rh.size),
+				bytes - static_cast<std::ptrdiff_t>(rh.base - rh.allocation_base)},
+			static_cast<std::uintptr_t>(rh.base),
+			mappedSize});
+
+		std::uint64_t data = position + dump::data_offset(rh.page_count);
+		for (std::uint64_t page = 0; page < rh.page_count;)
+		{
+			if (!(bitmap[page / 64] & (std::uint64_t{1} << (page % 64))))
+			{
+				++page;
+				continue;
+			}
+
+			// Map runs of consecutive stored pages at once
+			auto end = page + 1;
+			while (end < rh.page_count &&
+				   (bitmap[end / 64] & (std::uint64_t{1} << (end % 64))))
+			{
+				++end;
+			}
+
+			const auto runSize = (end - page) * dump::page_size;
+			if (data + runSize > fileSize ||
+				::mmap(
+					bytes + page * dump::page_size,
+					runSize,
+					PROT_READ,
+					MAP_PRIVATE | MAP_FIXED,
+					fd,
+					static_cast<off_t>(data)) == MAP_FAILED)
+			{
+				return fail("could not map page data");
+			}
+
+			data += runSize;
+			page = end;
+		}
+
+		position = (data + dump::page_size - 1) / dump::page_size *
+				   dump::page_size;
+	}
+
+	// Mappings stay valid once the file is closed
+	::close(fd);
+
+	log::info(
+		"Mapped {:d} regions ({:d} bytes) from dump file '{}'",
+		source->regions_.size(),
+		source->size(),
+		path.u8string());
+
+	return source;
+}
+
+bool dump_region_source::next(cry::region& r)
+{
+	if (next_ >= regions_.size())
+		return false;
+
+	r = regions_[next_++].r;
+	return true;
+}
+
+size_t dump_region_source::read(
+	const std::byte* address, std::byte* buffer, size_t size)
+{
+	const auto region = find(address);
+	if (!region)
+		return 0;
+
+	const auto available =
+		static_cast<size_t>(region->r.base + region->r.size - address);
+	const auto copied = std::min(size, available);
+	std::memcpy(buffer, address, copied);
+	return copied;
+}
+
+bool dump_region_source::read_in_place(
+	const std::byte* address,
+	size_t,
+	void (*f)(void* context, const std::byte* view),
+	void* context)
+{
+	// Mapped regions can't disappear during the call
+	f(context, address);
+	return true;
+}
+
+std::uintptr_t dump_region_source::original_address(
+	const std::byte* address) const
+{
+	const auto region = find(address);
+	return region ? region->original_base +
+						static_cast<std::uintptr_t>(address - region->r.base) :
+					0;
+}
+
+size_t dump_region_source::size() const noexcept
+{
+	size_t size = 0;
+	for (const auto& region : regions_)
+		size += region.r.size;
+	return size;
+}
+
+const dump_region_source::mapped_region* dump_region_source::find(
+	const std::byte* address) const
+{
+	// Regions are not sorted by mapped address, dumps hold a few hundred
+	// regions at most
+	for (const auto& region : regions_)
+	{
+		if (address >= region.r.base && address < region.r.base + region.r.size)
+			return &region;
+	}
+	return nullptr;
+}
+
+} // namespace shugoconsole::posix
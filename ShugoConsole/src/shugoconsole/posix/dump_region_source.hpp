@@ -0,0 +1,63 @@
+#ifndef SHUGOCONSOLE_POSIX_DUMP_REGION_SOURCE_HPP
+#define SHUGOCONSOLE_POSIX_DUMP_REGION_SOURCE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "shugoconsole/cry/region_source.hpp"
+
+namespace shugoconsole::posix
+{
+
+// Replays the regions of a dump written by cry::region_dump::write
+// Each region is memory-mapped from the dump, elided pages read as zeros
+class dump_region_source final : public cry::region_source
+{
+public:
+	~dump_region_source() override;
+
+	dump_region_source(const dump_region_source&) = delete;
+	dump_region_source& operator=(const dump_region_source&) = delete;
+
+	// Maps the regions of a dump, returns nullptr if the file can't be read
+	// or was written by a process with another pointer size
+	static std::unique_ptr<dump_region_source> open(
+		const std::filesystem::path& path);
+
+	void reset() override { next_ = 0; }
+	bool next(cry::region& r) override;
+	size_t read(const std::byte* address, std::byte* buffer, size_t size)
+		override;
+	bool read_in_place(
+		const std::byte* address,
+		size_t size,
+		void (*f)(void* context, const std::byte* view),
+		void* context) override;
+
+	// Address in the dumped process of an address of a mapped region
+	std::uintptr_t original_address(const std::byte* address) const;
+
+	// Bytes of all regions
+	size_t size() const noexcept;
+
+private:
+	struct mapped_region
+	{
+		cry::region r;
+		std::uintptr_t original_base;
+		size_t mapped_size;
+	};
+
+	dump_region_source() = default;
+
+	const mapped_region* find(const std::byte* address) const;
+
+	std::vector<mapped_region> regions_;
+	size_t next_ = 0;
+};
+
+} // namespace shugoconsole::posix
+
+#endif // SHUGOCONSOLE_POSIX_DUMP_REGION_SOURCE_HPP
@@ -0,0 +1,73 @@
+#include "shugoconsole/posix/guarded_call.hpp"
+
+#include <mutex>
+
+#include <csetjmp>
+#include <csignal>
+
+namespace shugoconsole::posix
+{
+
+namespace
+{
+
+thread_local sigjmp_buf* current_jump = nullptr;
+
+struct sigaction previous_segv;
+struct sigaction previous_bus;
+
+void on_fault(int sig, siginfo_t* info, void* ucontext)
+{
+	if (current_jump)
+		siglongjmp(*current_jump, 1);
+
+	const struct sigaction& previous =
+		sig == SIGSEGV ? previous_segv : previous_bus;
+
+	if (previous.sa_flags & SA_SIGINFO)
+	{
+		previous.sa_sigaction(sig, info, ucontext);
+	}
+	else if (previous.sa_handler != SIG_DFL && previous.sa_handler != SIG_IGN)
+	{
+		previous.sa_handler(sig);
+	}
+	else
+	{
+		// The faulting instruction runs again with the default action
+		::signal(sig, SIG_DFL);
+	}
+}
+
+void install_handlers()
+{
+	struct sigaction action{};
+	action.sa_sigaction = &on_fault;
+	action.sa_flags = SA_SIGINFO | SA_NODEFER;
+	::sigemptyset(&action.sa_mask);
+
+	::sigaction(SIGSEGV, &action, &previous_segv);
+	::sigaction(SIGBUS, &action, &previous_bus);
+}
+
+} // namespace
+
+bool guarded_call(void (*f)(void*), void* context) noexcept
+{
+	static std::once_flag handlers_installed;
+	std::call_once(handlers_installed, &install_handlers);
+
+	sigjmp_buf jump;
+	if (sigsetjmp(jump, 1) != 0)
+	{
+		current_jump = nullptr;
+		return false;
+	}
+
+	current_jump = &jump;
+	f(context);
+	current_jump = nullptr;
+	return true;
+}
+
+} // namespace shugoconsole::posix
@@ -0,0 +1,17 @@
+#ifndef SHUGOCONSOLE_POSIX_GUARDED_CALL_HPP
+#define SHUGOCONSOLE_POSIX_GUARDED_CALL_HPP
+
+namespace shugoconsole::posix
+{
+
+// Calls f(context) and returns true, or returns false as soon as f raises
+// SIGSEGV or SIGBUS, for instance because a page was unmapped while it was
+// being read
+// f is left with siglongjmp: it must not own objects that need to be
+// destroyed. Faults outside of a guarded call are forwarded to the handlers
+// that were installed before
+bool guarded_call(void (*f)(void*), void* context) noexcept;
+
+} // namespace shugoconsole::posix
+
+#endif // SHUGOCONSOLE_POSIX_GUARDED_CALL_HPP
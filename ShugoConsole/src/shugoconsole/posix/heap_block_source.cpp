@@ -0,0 +1,180 @@
+#include "shugoconsole/posix/heap_block_source.hpp"
+#include "shugoconsole/log.hpp"
+#include "shugoconsole/posix/guarded_call.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+namespace shugoconsole::posix
+{
+
+namespace
+{
+
+// Boundary tags of a glibc chunk: the size of the previous chunk, then the
+// size of the chunk whose 3 low bits are flags
+constexpr size_t chunk_header_size = 2 * sizeof(size_t);
+constexpr size_t chunk_alignment = 2 * sizeof(size_t);
+constexpr size_t prev_inuse = 1;
+constexpr size_t flag_bits = 7;
+
+struct arena_walk
+{
+	std::byte* begin;
+	std::byte* end;
+	const cry::heap_block_filter* filter;
+	std::vector<cry::region>* runs;
+	// Points to the chunk that could not be parsed, if any
+	std::byte* corrupted;
+	// true if the walk stopped because runs was full
+	bool full;
+};
+
+inline size_t read_size(const std::byte* p)
+{
+	size_t size;
+	std::memcpy(&size, p + sizeof(size_t), sizeof(size));
+	return size;
+}
+
+// Does not log nor allocate so that it can run under guarded_call without
+// changing the arena it walks: the walk stops when runs is full
+void walk_arena(void* context)
+{
+	auto& walk = *static_cast<arena_walk*>(context);
+
+	const auto offset =
+		reinterpret_cast<std::uintptr_t>(walk.begin) % chunk_alignment;
+	auto chunk = walk.begin + (offset ? chunk_alignment - offset : 0);
+
+	while (chunk + chunk_header_size <= walk.end)
+	{
+		const size_t size = read_size(chunk) & ~flag_bits;
+		if (size < chunk_header_size || size % chunk_alignment != 0 ||
+			size > static_cast<size_t>(walk.end - chunk))
+		{
+			walk.corrupted = chunk;
+			return;
+		}
+
+		// The top chunk ends the arena, it is never in use
+		const auto next = chunk + size;
+		if (next + chunk_header_size > walk.end)
+			return;
+
+		// A chunk in use may also store data in the prev_size field of the
+		// next chunk
+		const bool inUse = (read_size(next) & prev_inuse) != 0;
+		const size_t usableSize = size - sizeof(size_t);
+		if (inUse && walk.filter->accepts(usableSize))
+		{
+			if (walk.runs->size() == walk.runs->capacity())
+			{
+				walk.full = true;
+				return;
+			}
+
+			cry::append_heap_block(
+				*walk.runs,
+				cry::region{chunk + chunk_header_size, usableSize, walk.begin},
+				walk.filter->max_gap);
+		}
+
+		chunk = next;
+	}
+}
+
+} // namespace
+
+void heap_block_source::reset()
+{
+	runs_.clear();
+	next_ = 0;
+	loaded_ = true;
+
+	std::ifstream maps{"/proc/self/maps"};
+	if (!maps.is_open())
+	{
+		log::debug("Could not open /proc/self/maps");
+		return;
+	}
+
+	std::string line;
+	while (std::getline(maps, line))
+	{
+		std::uintmax_t start = 0, end = 0;
+		if (line.find("[heap]") == std::string::npos ||
+			std::sscanf(line.c_str(), "%jx-%jx", &start, &end) != 2)
+		{
+			continue;
+		}
+
+		arena_walk walk{
+			reinterpret_cast<std::byte*>(static_cast<std::uintptr_t>(start)),
+			reinterpret_cast<std::byte*>(static_cast<std::uintptr_t>(end)),
+			&filter_,
+			&runs_,
+			nullptr,
+			true};
+
+		// Walks again with more room for runs until they all fit
+		bool readable = true;
+		for (size_t capacity = 1024; readable && walk.full; capacity *= 2)
+		{
+			runs_.clear();
+			runs_.reserve(capacity);
+			walk.corrupted = nullptr;
+			walk.full = false;
+			readable = posix::guarded_call(&walk_arena, &walk);
+		}
+
+		if (!readable)
+			log::debug("The arena became unreadable while it was walked");
+		else if (walk.corrupted)
+		{
+			log::debug(
+				"Unrecognized chunk at {}, the rest of the arena is ignored",
+				static_cast<const void*>(walk.corrupted));
+		}
+
+		size_t bytes = 0;
+		for (const auto& run : runs_)
+			bytes += run.size;
+
+		log::debug(
+			"Arena at {:#x} - {:d} bytes: {:d} runs of blocks, {:d} bytes",
+			start,
+			end - start,
+			runs_.size(),
+			bytes);
+		break;
+	}
+}
+
+bool heap_block_source::next(cry::region& r)
+{
+	if (!loaded_)
+		reset();
+
+	if (next_ == runs_.size())
+		return false;
+
+	r = runs_[next_++];
+	return true;
+}
+
+} // namespace shugoconsole::posix
+
+namespace shugoconsole::cry
+{
+
+std::unique_ptr<region_source> make_heap_block_source(
+	const heap_block_filter& filter)
+{
+	return std::make_unique<posix::heap_block_source>(filter);
+}
+
+} // namespace shugoconsole::cry
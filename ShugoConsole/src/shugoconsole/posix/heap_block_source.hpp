@@ -0,0 +1,53 @@
+#ifndef SHUGOCONSOLE_POSIX_HEAP_BLOCK_SOURCE_HPP
+#define SHUGOCONSOLE_POSIX_HEAP_BLOCK_SOURCE_HPP
+
+#include <vector>
+
+#include "shugoconsole/cry/heap_blocks.hpp"
+#include "shugoconsole/posix/process_region_source.hpp"
+
+namespace shugoconsole::posix
+{
+
+// Enumerates the chunks in use of the main glibc malloc arena, the [heap]
+// mapping of /proc/self/maps
+// Stand-in for the heaps of the game to profile heap-block-aware scans:
+// chunks of other arenas and mmapped chunks are not enumerated
+class heap_block_source final : public cry::region_source
+{
+public:
+	explicit heap_block_source(const cry::heap_block_filter& filter) :
+		filter_{filter}
+	{
+	}
+
+	// Walks the chunks of the arena
+	void reset() override;
+	bool next(cry::region& r) override;
+
+	size_t read(const std::byte* address, std::byte* buffer, size_t size)
+		override
+	{
+		return memory_.read(address, buffer, size);
+	}
+
+	bool read_in_place(
+		const std::byte* address,
+		size_t size,
+		void (*f)(void* context, const std::byte* view),
+		void* context) override
+	{
+		return memory_.read_in_place(address, size, f, context);
+	}
+
+private:
+	cry::heap_block_filter filter_;
+	process_region_source memory_;
+	std::vector<cry::region> runs_;
+	size_t next_ = 0;
+	bool loaded_ = false;
+};
+
+} // namespace shugoconsole::posix
+
+#endif // SHUGOCONSOLE_POSIX_HEAP_BLOCK_SOURCE_HPP
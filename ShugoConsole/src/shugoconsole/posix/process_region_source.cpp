@@ -0,0 +1,151 @@
+#include "shugoconsole/posix/process_region_source.hpp"
+#include "shugoconsole/log.hpp"
+#include "shugoconsole/posix/guarded_call.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace shugoconsole::posix
+{
+
+namespace
+{
+
+struct in_place_call
+{
+	void (*f)(void* context, const std::byte* view);
+	void* context;
+	const std::byte* address;
+};
+
+void call_in_place(void* context)
+{
+	const auto& call = *static_cast<in_place_call*>(context);
+	call.f(call.context, call.address);
+}
+
+} // namespace
+
+void process_region_source::reset()
+{
+	regions_.clear();
+	next_ = 0;
+	loaded_ = true;
+
+	std::ifstream maps{"/proc/self/maps"};
+	if (!maps.is_open())
+	{
+		log::debug("Could not open /proc/self/maps");
+		return;
+	}
+
+	// Line format: start-end perms offset major:minor inode [path]
+	std::string line;
+	while (std::getline(maps, line))
+	{
+		std::uintmax_t start = 0, end = 0, offset = 0, inode = 0;
+		unsigned major = 0, minor = 0;
+		char perms[5] = {};
+
+		if (std::sscanf(
+				line.c_str(),
+				"%jx-%jx %4s %jx %x:%x %ju",
+				&start,
+				&end,
+				perms,
+				&offset,
+				&major,
+				&minor,
+				&inode) != 7)
+		{
+			log::debug("Unrecognized /proc/self/maps line: {}", line);
+			continue;
+		}
+
+		// Anonymous private mappings are the closest to MEM_PRIVATE regions
+		if (perms[0] == 'r' && perms[1] == 'w' && perms[3] == 'p' &&
+			inode == 0)
+		{
+			log::trace(
+				"Candidate region at: {:#x} - {:d} bytes",
+				start,
+				end - start);
+
+			const auto base =
+				reinterpret_cast<std::byte*>(static_cast<std::uintptr_t>(start));
+			regions_.push_back(cry::region{
+				base,
+				static_cast<size_t>(end - start),
+				base,
+				perms[2] == 'x' ? cry::region_protection::execute_read_write :
+								  cry::region_protection::read_write});
+		}
+		else
+		{
+			log::trace(
+				"Non-candidate region at: {:#x} - {:d} bytes - Ignoring",
+				start,
+				end - start);
+		}
+	}
+}
+
+bool process_region_source::next(cry::region& r)
+{
+	if (!loaded_)
+		reset();
+
+	if (next_ == regions_.size())
+		return false;
+
+	r = regions_[next_++];
+	return true;
+}
+
+size_t process_region_source::read(
+	const std::byte* address, std::byte* buffer, size_t size)
+{
+	// process_vm_readv fails with EFAULT instead of crashing on unmapped
+	// pages, like ReadProcessMemory
+	const iovec local{buffer, size};
+	const iovec remote{const_cast<std::byte*>(address), size};
+
+	const auto bytesRead = ::process_vm_readv(::getpid(), &local, 1, &remote, 1, 0);
+	if (bytesRead < 0)
+	{
+		log::debug(
+			"Could not read {:d} bytes at address {}",
+			size,
+			static_cast<const void*>(address));
+		return 0;
+	}
+
+	return static_cast<size_t>(bytesRead);
+}
+
+bool process_region_source::read_in_place(
+	const std::byte* address,
+	size_t,
+	void (*f)(void* context, const std::byte* view),
+	void* context)
+{
+	in_place_call call{f, context, address};
+	return posix::guarded_call(&call_in_place, &call);
+}
+
+} // namespace shugoconsole::posix
+
+namespace shugoconsole::cry
+{
+
+std::unique_ptr<region_source> make_process_region_source()
+{
+	return std::make_unique<posix::process_region_source>();
+}
+
+} // namespace shugoconsole::cry
@@ -0,0 +1,38 @@
+#ifndef SHUGOCONSOLE_POSIX_PROCESS_REGION_SOURCE_HPP
+#define SHUGOCONSOLE_POSIX_PROCESS_REGION_SOURCE_HPP
+
+#include <vector>
+
+#include "shugoconsole/cry/region_source.hpp"
+
+namespace shugoconsole::posix
+{
+
+// Enumerates the anonymous, private, read-write mappings of the current
+// process listed in /proc/self/maps
+// Used to run the scanner against a real heap outside of the game
+class process_region_source final : public cry::region_source
+{
+public:
+	process_region_source() = default;
+
+	// Takes a snapshot of /proc/self/maps
+	void reset() override;
+	bool next(cry::region& r) override;
+	size_t read(const std::byte* address, std::byte* buffer, size_t size)
+		override;
+	bool read_in_place(
+		const std::byte* address,
+		size_t size,
+		void (*f)(void* context, const std::byte* view),
+		void* context) override;
+
+private:
+	std::vector<cry::region> regions_;
+	size_t next_ = 0;
+	bool loaded_ = false;
+};
+
+} // namespace shugoconsole::posix
+
+#endif // SHUGOCONSOLE_POSIX_PROCESS_REGION_SOURCE_HPP
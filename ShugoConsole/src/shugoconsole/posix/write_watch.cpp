@@ -0,0 +1,201 @@
+#include "shugoconsole/posix/write_watch.hpp"
+#include "shugoconsole/cry/watched_pages.hpp"
+#include "shugoconsole/log.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace shugoconsole::posix
+{
+
+namespace
+{
+
+// Shared with the handler, which can run on any thread
+// The pages outlive the instance, a write that faulted while the instance was
+// destroyed still finds its page
+cry::watched_pages pages;
+std::atomic<int> active_fd{-1};
+std::atomic<bool> exists{false};
+struct sigaction previous_segv;
+
+// Last fault retried by the thread because a page may have been released
+// after it faulted, with the number of releases then
+thread_local std::uintptr_t retried_page = 0;
+thread_local std::uint64_t retried_releases = 0;
+
+std::uintptr_t page_size()
+{
+	static const auto size = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+	return size;
+}
+
+void* page_address(std::uintptr_t page)
+{
+	return reinterpret_cast<void*>(page);
+}
+
+void on_fault(int sig, siginfo_t* info, void* ucontext)
+{
+	const auto page =
+		reinterpret_cast<std::uintptr_t>(info->si_addr) & ~(page_size() - 1);
+
+	// A page that was unmapped since it was watched faults for another reason
+	if (info->si_code == SEGV_ACCERR && pages.on_write(page) &&
+		::mprotect(page_address(page), page_size(), PROT_READ | PROT_WRITE) ==
+			0)
+	{
+		const int fd = active_fd.load(std::memory_order_acquire);
+		if (fd >= 0)
+		{
+			const char byte = 0;
+			[[maybe_unused]] const auto written = ::write(fd, &byte, 1);
+		}
+
+		// The write runs again on the writable page
+		return;
+	}
+
+	// The write may have faulted before its page was released. The page
+	// can't be checked from here: the write runs again once, and again only
+	// after another release
+	if (info->si_code == SEGV_ACCERR)
+	{
+		const auto releases = pages.releases();
+		if (page != retried_page || releases != retried_releases)
+		{
+			retried_page = page;
+			retried_releases = releases;
+			return;
+		}
+	}
+
+	if (previous_segv.sa_flags & SA_SIGINFO)
+	{
+		previous_segv.sa_sigaction(sig, info, ucontext);
+	}
+	else if (
+		previous_segv.sa_handler != SIG_DFL &&
+		previous_segv.sa_handler != SIG_IGN)
+	{
+		previous_segv.sa_handler(sig);
+	}
+	else
+	{
+		// The faulting instruction runs again with the default action
+		::signal(sig, SIG_DFL);
+	}
+}
+
+} // namespace
+
+std::unique_ptr<write_watch> write_watch::create()
+{
+	if (exists.exchange(true))
+	{
+		log::error("Only one write watch can exist");
+		return nullptr;
+	}
+
+	int fds[2];
+	if (::pipe(fds) != 0)
+	{
+		log::error("pipe failed: {}", std::strerror(errno));
+		exists = false;
+		return nullptr;
+	}
+	::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+	::fcntl(fds[1], F_SETFL, O_NONBLOCK);
+
+	struct sigaction action{};
+	action.sa_sigaction = &on_fault;
+	action.sa_flags = SA_SIGINFO | SA_NODEFER;
+	::sigemptyset(&action.sa_mask);
+	if (::sigaction(SIGSEGV, &action, &previous_segv) != 0)
+	{
+		log::error("sigaction failed: {}", std::strerror(errno));
+		::close(fds[0]);
+		::close(fds[1]);
+		exists = false;
+		return nullptr;
+	}
+
+	active_fd = fds[1];
+	return std::unique_ptr<write_watch>{new write_watch{fds[0], fds[1]}};
+}
+
+write_watch::~write_watch()
+{
+	release_all();
+	active_fd = -1;
+	::sigaction(SIGSEGV, &previous_segv, nullptr);
+	::close(read_fd_);
+	::close(write_fd_);
+	exists = false;
+}
+
+bool write_watch::watch(const void* address, size_t size)
+{
+	const auto first =
+		reinterpret_cast<std::uintptr_t>(address) & ~(page_size() - 1);
+	const auto last =
+		(reinterpret_cast<std::uintptr_t>(address) + size - 1) &
+		~(page_size() - 1);
+
+	for (auto page = first; page <= last; page += page_size())
+	{
+		// Page of another CVar
+		if (pages.armed(page))
+			continue;
+
+		if (!pages.arm(page))
+			return false;
+
+		if (::mprotect(page_address(page), page_size(), PROT_READ) != 0)
+		{
+			pages.release(page);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void write_watch::release_all()
+{
+	// Drains the wakeups of the writes already handled
+	char bytes[64];
+	while (::read(read_fd_, bytes, sizeof(bytes)) > 0)
+	{
+	}
+
+	pages.for_each_page([](std::uintptr_t page) {
+		// The handler may have caught a write in the meantime and made the
+		// page writable itself
+		if (pages.release(page))
+		{
+			::mprotect(page_address(page), page_size(), PROT_READ | PROT_WRITE);
+		}
+	});
+}
+
+size_t write_watch::take_writes()
+{
+	return pages.take_writes();
+}
+
+bool write_watch::wait(std::chrono::milliseconds timeout)
+{
+	pollfd fd{read_fd_, POLLIN, 0};
+	return ::poll(&fd, 1, static_cast<int>(timeout.count())) > 0;
+}
+
+} // namespace shugoconsole::posix
@@ -0,0 +1,55 @@
+#ifndef SHUGOCONSOLE_POSIX_WRITE_WATCH_HPP
+#define SHUGOCONSOLE_POSIX_WRITE_WATCH_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+
+namespace shugoconsole::posix
+{
+
+// Catches writes to watched pages with mprotect and a SIGSEGV handler, which
+// makes a page writable again on the first write to it and wakes wait()
+// Stand-in for win::write_watch to profile write-driven enforcement
+// Only one instance can exist at a time
+class write_watch final
+{
+public:
+	// Returns nullptr if another instance exists or if the handler can't be
+	// installed
+	static std::unique_ptr<write_watch> create();
+
+	// Makes every watched page writable and restores the previous handler
+	~write_watch();
+
+	write_watch(const write_watch&) = delete;
+	write_watch& operator=(const write_watch&) = delete;
+
+	// Makes the pages holding the size bytes at address read-only until they
+	// are written to or released
+	// Returns false if the pages can't be protected or if too many pages are
+	// watched
+	bool watch(const void* address, size_t size);
+
+	// Makes every watched page writable again, before the CVars are written
+	void release_all();
+
+	// Number of writes caught since the previous call
+	size_t take_writes();
+
+	// Waits until a write is caught or timeout expires, returns true if a
+	// write was caught
+	bool wait(std::chrono::milliseconds timeout);
+
+private:
+	write_watch(int readFd, int writeFd) : read_fd_{readFd}, write_fd_{writeFd}
+	{
+	}
+
+	int read_fd_;
+	int write_fd_;
+};
+
+} // namespace shugoconsole::posix
+
+#endif // SHUGOCONSOLE_POSIX_WRITE_WATCH_HPP
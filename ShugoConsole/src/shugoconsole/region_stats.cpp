@@ -0,0 +1,56 @@
+#include "shugoconsole/region_stats.hpp"
+#include "shugoconsole/log.hpp"
+#include "shugoconsole/toml_file.hpp"
+
+#include <string>
+
+#include <fmt/format.h>
+
+namespace shugoconsole
+{
+
+region_stats region_stats::from_file(const std::filesystem::path& statsPath)
+{
+	const auto read = [](const toml::value& root) {
+		region_stats stats;
+		for (const auto& [key, value] :
+			 toml::find<toml::table>(root, "classes"))
+		{
+			const auto c = cry::parse_region_class(key);
+			const auto& counts = value.as_array();
+			if (!c || counts.size() != 2)
+			{
+				log::warn("Ignoring invalid region class '{}'", key);
+				continue;
+			}
+
+			stats.classes.emplace(
+				*c,
+				cry::region_class_stats{
+					static_cast<std::uint64_t>(counts[0].as_integer()),
+					static_cast<std::uint64_t>(counts[1].as_integer())});
+		}
+
+		return stats;
+	};
+
+	return read_toml_file(statsPath, "region statistics", read)
+		.value_or(region_stats{});
+}
+
+void region_stats::save(const std::filesystem::path& statsPath) const
+{
+	std::string text = "[classes]\n";
+	for (const auto& [c, counts] : classes)
+	{
+		text += fmt::format(
+			"\"{}\" = [{}, {}]\n",
+			cry::to_string(c),
+			counts.regions,
+			counts.hits);
+	}
+
+	write_toml_file(statsPath, "region statistics", text);
+}
+
+} // namespace shugoconsole
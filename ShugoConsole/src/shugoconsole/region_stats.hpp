@@ -0,0 +1,31 @@
+#ifndef SHUGOCONSOLE_REGION_STATS_HPP
+#define SHUGOCONSOLE_REGION_STATS_HPP
+
+#include <filesystem>
+#include <map>
+
+#include "shugoconsole/cry/region_policy.hpp"
+
+namespace shugoconsole
+{
+
+// Hit statistics of the region classes, accumulated over the runs
+// Stored as a TOML file next to config.toml, each class maps to its region
+// and hit counts:
+// ```
+// [classes]
+// "20-24-rw" = [120, 3]
+// ```
+struct region_stats final
+{
+	std::map<cry::region_class, cry::region_class_stats> classes;
+
+	// Returns empty statistics if the file does not exist or is invalid
+	static region_stats from_file(const std::filesystem::path& statsPath);
+
+	void save(const std::filesystem::path& statsPath) const;
+};
+
+} // namespace shugoconsole
+
+#endif // SHUGOCONSOLE_REGION_STATS_HPP
@@ -1,16 +1,39 @@
 // Standard library includes
 #include <algorithm>
 #include <chrono>
+#include <cstdint>
 #include <filesystem>
+#include <optional>
 #include <vector>
 
 #include "shugoconsole/config.hpp"
+#include "shugoconsole/cry/address_hint.hpp"
+#include "shugoconsole/cry/check_interval.hpp"
+#include "shugoconsole/cry/cvar_layout.hpp"
+#include "shugoconsole/cry/cvar_liveness.hpp"
+#include "shugoconsole/cry/cvar_registry.hpp"
+#include "shugoconsole/cry/heap_blocks.hpp"
+#include "shugoconsole/cry/incremental_region_source.hpp"
+#include "shugoconsole/cry/match_filters.hpp"
 #include "shugoconsole/cry/memory.hpp"
+#include "shugoconsole/cry/override_stats.hpp"
+#include "shugoconsole/cry/region_dump.hpp"
+#include "shugoconsole/cry/region_policy.hpp"
+#include "shugoconsole/cry/registered_cvars.hpp"
+#include "shugoconsole/cry/set_interceptor.hpp"
+#include "shugoconsole/cry/signature.hpp"
+#include "shugoconsole/cvar_cache.hpp"
+#include "shugoconsole/layout_db.hpp"
 #include "shugoconsole/log.hpp"
+#include "shugoconsole/region_stats.hpp"
 #include "shugoconsole/shugoconsole.hpp"
+#include "shugoconsole/win/cvar_set_hooks.hpp"
 #include "shugoconsole/win/dllmain_thread.hpp"
 #include "shugoconsole/win/file_monitor.hpp"
+#include "shugoconsole/win/module_fingerprint.hpp"
+#include "shugoconsole/win/registration_hook.hpp"
 #include "shugoconsole/win/utils.hpp"
+#include "shugoconsole/win/write_watch.hpp"
 
 // Windows includes
 #define NOMINMAX
@@ -24,7 +47,17 @@ using namespace std::literals::chrono_literals;
 
 const auto WAIT_TIME_AFTER_FILE_CHANGE = 1s;
 const auto WAIT_TIME_AFTER_FAILED_SCAN = 2s;
-const auto WAIT_TIME_AFTER_VAR_CHECK = 100ms;
+
+// Overrides of the CVars by the game are logged at most this often
+const auto OVERRIDE_STATS_LOG_INTERVAL = 10min;
+
+// A CVar whose policy doesn't write it again is only checked to still exist
+// this often
+const auto IDLE_LIVENESS_CHECK_INTERVAL = 10s;
+
+// Retries only scan the memory that changed since the previous scan, except
+// every FULL_SCAN_INTERVAL scans
+const unsigned FULL_SCAN_INTERVAL = 8;
 
 const auto CONSOLE_VARS = config::configuration::variable_definition_set{
 	{"g_minFov", config::types::floating::with_min_max(60.0, 170.0)},
@@ -45,6 +78,16 @@ class instance_impl final : public instance
 	}
 
 private:
+	// CVars recorded by the registration hook, which can run until the
+	// instance is destroyed
+	cry::registered_cvars registered_;
+	// Watches the modules mapped from the construction, while the client
+	// is still loading them: the thread can only start once the loader is
+	// done
+	std::unique_ptr<win::registration_hook> registration_ =
+		win::registration_hook::watch();
+
+	// Declared last so that the thread stops first
 	win::dllmain_thread thread_;
 
 	void run();
@@ -54,9 +97,72 @@ class instance_impl final : public instance
 		config::configuration::variable cfg;
 		cry::cvar* cvar;
 
+		// Built once so that the enforcement loop doesn't allocate
+		cry::cvar::pattern pattern{cfg.def.name};
+		std::optional<cry::cvar_assignment> assignment =
+			to_assignment(cfg.opt_value);
+
+		// Vtable pointer of cvar when it was found
+		std::uintptr_t vtable = 0;
+		// Last address of cvar once it is not alive anymore, and when to
+		// look for it again
+		cry::cvar* lost = nullptr;
+		std::chrono::steady_clock::time_point retry{};
+		unsigned failures = 0;
+
+		// true once cvar held the configured value, a different value is then
+		// an override by the game
+		bool applied = false;
+		cry::override_stats overrides{};
+
+		// true while the value has to be written by the next check, for the
+		// policies that don't check continuously
+		bool pending = true;
+		// Earliest next check of a rate-limited policy, or of a CVar that is
+		// not pending for the other policies that don't check continuously
+		std::chrono::steady_clock::time_point next_check{};
+
 		auto type() const { return cfg.def.cvar_type(); }
 		auto name() const { return cfg.def.name; }
+
+		static std::optional<cry::cvar_assignment> to_assignment(
+			const std::optional<cry::cvar::value>& value)
+		{
+			if (!value)
+				return std::nullopt;
+			return cry::cvar_assignment{*value};
+		}
 	};
+
+	// Scans memory in steps separated by waits on the quit event
+	// Returns nullopt if the thread has to quit
+	std::optional<std::vector<cry::cvar*>> scan_time_sliced(
+		cry::region_source& source,
+		cry::cvar::pattern_set patterns,
+		std::vector<std::byte>& buffer,
+		const cry::scan_options& scanOptions,
+		const config::scanner_settings& settings);
+
+	// Finds the CVar of every task, returns false if the thread has to quit
+	// The cache is only used if it was saved for the build of fingerprint
+	bool find_console_vars(
+		std::vector<console_var_task>& console_var_tasks,
+		const config::configuration& cfg,
+		std::uint64_t fingerprint,
+		const std::filesystem::path& cachePath,
+		const std::filesystem::path& statsPath);
+
+	// Applies the configured values with the value offsets of layout, until
+	// the thread has to quit
+	template<typename Layout>
+	void enforce_console_vars(
+		std::vector<console_var_task>& console_var_tasks,
+		const config::enforcement_settings& settings,
+		const std::filesystem::path& configPath,
+		win::file_monitor& configFileMonitor,
+		cry::region_source& source,
+		std::vector<std::byte>& buffer,
+		const Layout& layout);
 };
 
 instance::~instance() = default;
@@ -66,86 +172,570 @@ instance::~instance() = default;
 	return std::make_unique<instance_impl>();
 }
 
-void instance_impl::run()
+static int to_win_priority(config::scanner_settings::thread_priority priority)
 {
-	const auto configPath =
-		win::get_appdata_path() / L"ShugoConsole" / "config.toml";
-	log::info("Config file path: {}", configPath.u8string());
+	switch (priority)
+	{
+	case config::scanner_settings::thread_priority::below_normal:
+		return THREAD_PRIORITY_BELOW_NORMAL;
+	case config::scanner_settings::thread_priority::lowest:
+		return THREAD_PRIORITY_LOWEST;
+	case config::scanner_settings::thread_priority::idle:
+		return THREAD_PRIORITY_IDLE;
+	default:
+		return THREAD_PRIORITY_NORMAL;
+	}
+}
 
-	// Monitor config file, wait 1 second before applying changes
-	win::file_monitor configFileMonitor{configPath,
-										WAIT_TIME_AFTER_FILE_CHANGE};
+std::optional<std::vector<cry::cvar*>> instance_impl::scan_time_sliced(
+	cry::region_source& source,
+	cry::cvar::pattern_set patterns,
+	std::vector<std::byte>& buffer,
+	const cry::scan_options& scanOptions,
+	const config::scanner_settings& settings)
+{
+	cry::scanner scanner{source, std::move(patterns), buffer, scanOptions};
 
-	auto cfg = config::configuration::from_file(CONSOLE_VARS, configPath);
+	cry::scan_budget budget;
+	budget.bytes = settings.step_bytes;
+	budget.time = std::chrono::microseconds{settings.step_time_us};
 
-	std::vector<console_var_task> console_var_tasks;
+	size_t steps = 1;
+	while (!scanner.step(budget))
+	{
+		// Let the game run between two steps, and quit as soon as asked
+		switch (win::wait_on_objects(
+			std::chrono::milliseconds{settings.step_pause_ms},
+			thread_.quit_event()))
+		{
+		case WAIT_OBJECT_0:
+			log::debug("Quit event signaled!");
+			return std::nullopt;
 
-	std::transform(
-		cfg.vars.begin(),
-		cfg.vars.end(),
-		std::back_inserter(console_var_tasks),
-		[](const auto& cfg) {
-			return console_var_task{cfg, nullptr};
-		});
+		case WAIT_TIMEOUT:
+			break;
 
-	// Find all configurable CVars in memory
+		default:
+			log::error("Unhandled WaitForMultipleObjects result !");
+			return std::nullopt;
+		}
+
+		++steps;
+	}
+
+	log::debug(
+		"Time-sliced scan of {:d} bytes done in {:d} steps",
+		scanner.scanned_bytes(),
+		steps);
+
+	return scanner.results();
+}
+
+bool instance_impl::find_console_vars(
+	std::vector<console_var_task>& console_var_tasks,
+	const config::configuration& cfg,
+	std::uint64_t fingerprint,
+	const std::filesystem::path& cachePath,
+	const std::filesystem::path& statsPath)
+{
+	const win::scoped_thread_priority priority{
+		to_win_priority(cfg.scanner.priority)};
+
+	const auto source = cry::make_process_region_source();
+
+	// Regions are scanned from the most to the least likely to hold CVars
+	// according to the previous runs
+	cry::region_policy_settings policySettings;
+	policySettings.large_region_size =
+		size_t{cfg.scanner.large_region_mb} * 1024 * 1024;
+	cry::region_policy policy{
+		policySettings, region_stats::from_file(statsPath).classes};
+	policy.log_statistics();
+
+	cry::prioritized_region_source orderedSource{*source, policy};
+	cry::incremental_region_source scanSource{
+		orderedSource, FULL_SCAN_INTERVAL};
+	const auto heapSource = cfg.scanner.heap_blocks ?
+		cry::make_heap_block_source() :
+		nullptr;
+	std::vector<std::byte> buffer(64 * 1024);
+
+	if (!cfg.scanner.dump_path.empty())
 	{
-		std::vector<std::byte> buffer(64 * 1024);
-		for (;;)
+		cry::region_dump::write(
+			*source, std::filesystem::u8path(cfg.scanner.dump_path));
+	}
+
+	cry::scan_options scanOptions;
+	scanOptions.threads = cfg.scanner.threads;
+	scanOptions.cancelled = [this]() {
+		return ::WaitForSingleObject(thread_.quit_event(), 0) == WAIT_OBJECT_0;
+	};
+
+	const auto missingTasks = [&console_var_tasks]() {
+		std::vector<console_var_task*> tasks;
+		for (auto& task : console_var_tasks)
 		{
-			// Assuming that config_entries_ is not empty and that we test
-			// all config variables after scanning memory, there is at least
-			// one matching element in the vector
-			auto& task = *std::find_if(
-				console_var_tasks.begin(),
-				console_var_tasks.end(),
-				[](const console_var_task& e) { return e.cvar == nullptr; });
+			if (task.cvar == nullptr)
+				tasks.push_back(&task);
+		}
+		return tasks;
+	};
 
-			task.cvar = cry::find_cvar_ptr({task.name()}, buffer);
+	const auto patternsOf = [](const std::vector<console_var_task*>& tasks) {
+		std::vector<cry::cvar::pattern> patterns;
+		for (const auto task : tasks)
+			patterns.emplace_back(task->name());
+		return cry::cvar::pattern_set{std::move(patterns)};
+	};
+
+	const auto assign = [](const std::vector<console_var_task*>& tasks,
+						   const std::vector<cry::cvar*>& cvars,
+						   const char* origin) {
+		for (size_t i = 0; i < tasks.size(); ++i)
+		{
+			auto& task = *tasks[i];
+			task.cvar = cvars[i];
 
 			if (task.cvar)
 			{
+				task.vtable =
+					reinterpret_cast<std::uintptr_t>(task.cvar->dummy0);
+
 				log::info(
-					"Found {} current={}",
+					"Found {} ({}) current={}",
 					task.name(),
+					origin,
 					cry::to_string(task.cvar->to_value(task.type())));
 			}
+		}
+	};
+
+	// Every match of the scan is checked, the first one that looks live wins
+	// over the stale copies left in freed memory
+	const auto scanAllMatches =
+		[&](cry::region_source& regions,
+			const std::vector<console_var_task*>& tasks) {
+		std::vector<cry::match_filter> valueFilters;
+		for (const auto task : tasks)
+		{
+			valueFilters.push_back(
+				cry::match_filters::plausible_value(task->type()));
+		}
+
+		const auto filter = cry::match_filters::all_of(
+			{cry::match_filters::layout(),
+			 [&valueFilters](const cry::cvar_match& match) {
+				 return valueFilters[match.pattern](match);
+			 }});
+
+		std::vector<cry::cvar*> cvars(tasks.size());
+		std::vector<size_t> counts(tasks.size());
+		for (const auto& match : cry::cvar_matches{
+				 regions, patternsOf(tasks), buffer, filter, scanOptions})
+		{
+			if (counts[match.pattern]++ == 0)
+				cvars[match.pattern] = match.var;
+		}
+
+		for (size_t i = 0; i < tasks.size(); ++i)
+		{
+			if (counts[i] > 1)
+			{
+				log::warn(
+					"{:d} live-looking copies of {}, using the first one",
+					counts[i],
+					tasks[i]->name());
+			}
+		}
+
+		return cvars;
+	};
+
+	// Addresses found by a previous run of the same client build are tested
+	// before scanning memory
+	const auto cache = cvar_cache::from_file(cachePath);
+	// true once a CVar was found elsewhere than in the cache
+	bool cacheStale = false;
+
+	// Once found, the registry of the console tells where every registered
+	// CVar is, memory is not scanned anymore
+	std::optional<cry::cvar_registry> registry;
+	const auto lookup = [&](const std::vector<console_var_task*>& tasks) {
+		std::vector<cry::cvar*> cvars;
+		for (const auto task : tasks)
+			cvars.push_back(registry->lookup(task->name()));
+		assign(tasks, cvars, "registry");
+		cacheStale = true;
+	};
+
+	// CVars recorded by the registration hook as the engine created them
+	const auto lookupRegistered =
+		[&](const std::vector<console_var_task*>& tasks) {
+		std::vector<cry::cvar*> cvars;
+		for (const auto task : tasks)
+		{
+			const auto registration = registered_.lookup(task->name());
+			const bool alive = registration &&
+				cry::check_liveness(
+					*source,
+					task->pattern,
+					registration->var,
+					registration->vtable) == cry::liveness::alive;
+			cvars.push_back(alive ? registration->var : nullptr);
+		}
+		assign(tasks, cvars, "registration");
+		cacheStale = true;
+	};
+
+	// Scans started, every FULL_SCAN_INTERVAL scans the vtable filter is
+	// dropped and all regions are scanned, in case a missing CVar has a
+	// vtable far from the others or is outside of the heaps
+	unsigned scans = 0;
+
+	// Memory is not scanned before the module registering the CVars is
+	// hooked: it records them as the engine creates them
+	if (registration_ && !registration_->installed())
+	{
+		log::info(
+			"Waiting for {} to be loaded before looking for CVars",
+			cfg.registration.module);
+	}
+	while (registration_ && !registration_->installed())
+	{
+		if (!registration_->install_loaded())
+		{
+			registration_.reset();
+			break;
+		}
+
+		switch (win::wait_on_objects(
+			WAIT_TIME_AFTER_FAILED_SCAN,
+			thread_.quit_event(),
+			registration_->loaded_event()))
+		{
+		case WAIT_OBJECT_0:
+			log::debug("Quit event signaled!");
+			return false;
+
+		case WAIT_OBJECT_0 + 1:
+		case WAIT_TIMEOUT:
+			break;
+
+		default:
+			log::error("Unhandled WaitForMultipleObjects result !");
+			return false;
+		}
+	}
+
+	for (;;)
+	{
+		// CVars the hook didn't record are still looked for in memory, the
+		// engine may have registered them before it was installed
+		if (registration_ && !registration_->install_loaded())
+			registration_.reset();
+
+		if (const auto tasks = missingTasks();
+			registration_ && registration_->installed() && !tasks.empty())
+		{
+			lookupRegistered(tasks);
+		}
+
+		if (fingerprint != 0 && fingerprint == cache.fingerprint)
+		{
+			const auto tasks = missingTasks();
+
+			std::vector<std::optional<cry::address_hint>> hints;
+			for (const auto task : tasks)
+			{
+				const auto it = cache.hints.find(task->name());
+				hints.push_back(
+					it != cache.hints.end() ?
+						std::make_optional(it->second) :
+						std::nullopt);
+			}
+
+			assign(
+				tasks,
+				cry::resolve_address_hints(*source, patternsOf(tasks), hints),
+				"cache");
+		}
 
-			if (std::all_of(
-					console_var_tasks.begin(),
-					console_var_tasks.end(),
-					[](const console_var_task& e) {
-						return e.cvar != nullptr;
-					}))
+		if (registry && !registry->refresh(*source))
+			registry.reset();
+
+		if (const auto tasks = missingTasks(); registry && !tasks.empty())
+			lookup(tasks);
+
+		// Scan memory once for every variable that has not been found yet
+		if (const auto tasks = missingTasks(); !registry && !tasks.empty())
+		{
+			// Slots are only tested when their vtable is near the vtables of
+			// the CVars already found
+			scanOptions.vtables.reset();
+			const bool fullScan = ++scans % FULL_SCAN_INTERVAL == 0;
+			if (!fullScan)
 			{
-				log::info("Found all configurable CVars !");
-				break;
+				std::vector<cry::cvar*> cvars;
+				for (const auto& task : console_var_tasks)
+					cvars.push_back(task.cvar);
+				scanOptions.vtables = cry::cvar::vtable_range::around(cvars);
 			}
 
-			// Test if we have to quit the thread
-			// In case we have not found the variable, wait before
-			// continuing
-			std::chrono::duration<DWORD, std::milli> waitTime =
-				task.cvar ? 0ms : WAIT_TIME_AFTER_FAILED_SCAN;
+			// Heap blocks are walked again by every scan
+			orderedSource.set_exclusion(!fullScan);
+			const bool heapScan = heapSource && !fullScan;
+			cry::region_source& regions =
+				heapScan ? *heapSource : scanSource;
 
-			switch (win::wait_on_objects(waitTime, thread_.quit_event()))
+			if (cfg.scanner.time_sliced())
+			{
+				const auto cvars = scan_time_sliced(
+					regions,
+					patternsOf(tasks),
+					buffer,
+					scanOptions,
+					cfg.scanner);
+				if (!cvars)
+					return false;
+
+				assign(tasks, *cvars, "scan");
+			}
+			else if (cfg.scanner.all_matches)
+			{
+				assign(tasks, scanAllMatches(regions, tasks), "scan");
+			}
+			else
+			{
+				assign(
+					tasks,
+					cry::find_cvar_ptrs(
+						regions, patternsOf(tasks), buffer, scanOptions),
+					"scan");
+			}
+			cacheStale = true;
+
+			if (!heapScan)
+			{
+				log::debug(
+					"Scanned {:d} bytes, skipped {:d} unchanged bytes and "
+					"{:d} excluded bytes",
+					scanSource.returned_bytes(),
+					scanSource.skipped_bytes(),
+					orderedSource.excluded_bytes());
+			}
+		}
+
+		// Look for the registry from any CVar found, if some are missing
+		const auto anchor = std::find_if(
+			console_var_tasks.begin(),
+			console_var_tasks.end(),
+			[](const console_var_task& task) { return task.cvar != nullptr; });
+
+		if (const auto tasks = missingTasks();
+			!registry && !tasks.empty() && anchor != console_var_tasks.end())
+		{
+			registry = cry::cvar_registry::find(*source, anchor->cvar);
+			if (registry)
+				lookup(tasks);
+		}
+
+		if (missingTasks().empty())
+		{
+			log::info("Found all configurable CVars !");
+			break;
+		}
+
+		// Test if we have to quit the thread
+		// Some variables have not been found, wait before scanning again
+		// The module registering the CVars is hooked as soon as it is loaded
+		const auto scanTime =
+			std::chrono::steady_clock::now() + WAIT_TIME_AFTER_FAILED_SCAN;
+		for (auto now = std::chrono::steady_clock::now(); now < scanTime;
+			 now = std::chrono::steady_clock::now())
+		{
+			const auto waitTime =
+				std::chrono::ceil<std::chrono::milliseconds>(scanTime - now);
+			const bool hooking = registration_ && !registration_->installed();
+			switch (
+				hooking ? win::wait_on_objects(
+							  waitTime,
+							  thread_.quit_event(),
+							  registration_->loaded_event()) :
+						  win::wait_on_objects(waitTime, thread_.quit_event()))
 			{
 			case WAIT_OBJECT_0:
 				log::debug("Quit event signaled!");
-				return;
+				return false;
+
+			case WAIT_OBJECT_0 + 1:
+				if (!registration_->install_loaded())
+					registration_.reset();
+				break;
 
 			case WAIT_TIMEOUT:
 				break;
 
 			default:
 				log::error("Unhandled WaitForMultipleObjects result !");
-				return;
+				return false;
 			}
 		}
 	}
 
+	std::vector<cry::cvar*> cvars;
+	for (const auto& task : console_var_tasks)
+		cvars.push_back(task.cvar);
+
+	// Remember which regions held the CVars to order the next scans
+	policy.record(*source, cvars);
+	region_stats{policy.statistics()}.save(statsPath);
+
+	// Remember where the CVars are for the next run of this client build
+	if (fingerprint != 0 && (cacheStale || fingerprint != cache.fingerprint))
+	{
+		const auto hints = cry::make_address_hints(*source, cvars);
+
+		cvar_cache newCache;
+		newCache.fingerprint = fingerprint;
+		for (size_t i = 0; i < hints.size(); ++i)
+		{
+			if (hints[i])
+				newCache.hints.emplace(console_var_tasks[i].name(), *hints[i]);
+		}
+
+		newCache.save(cachePath);
+	}
+
+	return true;
+}
+
+template<typename Layout>
+void instance_impl::enforce_console_vars(
+	std::vector<console_var_task>& console_var_tasks,
+	const config::enforcement_settings& settings,
+	const std::filesystem::path& configPath,
+	win::file_monitor& configFileMonitor,
+	cry::region_source& source,
+	std::vector<std::byte>& buffer,
+	const Layout& layout)
+{
+	// Pages of the CVars are read-only between checks, a write to one of them
+	// ends the wait
+	std::unique_ptr<win::write_watch> watch;
+	if (settings.write_watch)
+	{
+		watch = win::write_watch::create();
+		if (!watch)
+			log::warn("No write watch, CVars are checked periodically");
+	}
+
+	// Sets of the engine to the continuously checked CVars are rewritten or
+	// rejected by hooks, checks still catch the writes that bypass Set
+	cry::set_interceptor interceptor{
+		settings.set_hooks_reject ? cry::set_interceptor::mode::reject :
+									cry::set_interceptor::mode::rewrite};
+	std::unique_ptr<win::cvar_set_hooks> hooks;
+	if (settings.set_hooks)
+	{
+		std::vector<cry::cvar*> vars;
+		for (const auto& task : console_var_tasks)
+			vars.push_back(task.cvar);
+
+		hooks = win::cvar_set_hooks::install(
+			vars,
+			{settings.set_string_slot,
+			 settings.set_float_slot,
+			 settings.set_int_slot},
+			interceptor);
+	}
+
+	const auto intercept = [&](const console_var_task& task) {
+		if (!hooks || !task.cvar)
+			return;
+
+		const auto& value = task.cfg.policy.checked_continuously() ?
+			task.assignment :
+			std::nullopt;
+		if (!interceptor.manage(task.cvar, value))
+			log::warn("Sets of {} can't be intercepted", task.name());
+	};
+
+	for (const auto& task : console_var_tasks)
+		intercept(task);
+
+	// Checks are spaced while the game leaves the values alone
+	cry::check_interval interval{
+		std::chrono::milliseconds{settings.check_min_ms},
+		std::chrono::milliseconds{settings.check_max_ms}};
+
+	// Overrides found by a check happened after this time: the end of the
+	// previous check, or the write that ended the wait
+	auto overriddenAfter = std::chrono::steady_clock::now();
+
+	// true if a write to the pages of the CVars ended the wait
+	bool writeCaught = false;
+
+	auto statsLogged = overriddenAfter;
+	bool statsChanged = false;
+	const auto logOverrideStats = [&] {
+		for (const auto& task : console_var_tasks)
+		{
+			const auto& stats = task.overrides;
+			if (stats.overrides == 0)
+				continue;
+
+			log::info(
+				"{} overridden {:d} times, restored in {:.1f} ms on average, "
+				"{:.1f} ms at most ({})",
+				task.name(),
+				stats.overrides,
+				stats.mean_latency().count() / 1000.0,
+				stats.max_latency.count() / 1000.0,
+				cry::format_latency_histogram(stats));
+		}
+
+		if (hooks)
+		{
+			log::info(
+				"{:d} Sets of the engine intercepted",
+				interceptor.take_intercepted());
+		}
+		statsChanged = false;
+	};
+
+	// Watches the pages of every CVar with a value, then checks the values
+	// again: a write made before its page was protected is not caught
+	// Returns false if a CVar still has to be checked by polling
+	const auto watchConsoleVars = [&] {
+		const auto watched = [](const console_var_task& task) {
+			return task.assignment && task.cfg.policy.checked_continuously();
+		};
+
+		for (const auto& task : console_var_tasks)
+		{
+			if (watched(task) &&
+				(!task.cvar || !watch->watch(task.cvar, sizeof(cry::cvar))))
+			{
+				return false;
+			}
+		}
+
+		for (const auto& task : console_var_tasks)
+		{
+			if (watched(task) && !task.assignment->matches(task.cvar, layout))
+				return false;
+		}
+
+		return true;
+	};
+
 	for (;;)
 	{
+		// CVars are checked and written with their pages writable
+		if (watch)
+			watch->release_all();
+
 		if (configFileMonitor.changed())
 		{
 			configFileMonitor.reset();
@@ -159,34 +749,199 @@ void instance_impl::run()
 
 			for (size_t i = 0; i < console_var_tasks.size(); ++i)
 			{
-				console_var_tasks[i].cfg.opt_value =
-					newConfig.vars[i].opt_value;
+				auto& task = console_var_tasks[i];
+				const auto& var = newConfig.vars[i];
+
+				// A value applied once is only written again if it changed
+				if (var.policy.when !=
+						config::enforcement_policy::mode::once ||
+					var.opt_value != task.cfg.opt_value)
+				{
+					task.pending = true;
+				}
+
+				task.cfg.opt_value = var.opt_value;
+				task.cfg.policy = var.policy;
+				task.assignment =
+					console_var_task::to_assignment(task.cfg.opt_value);
+				task.applied = false;
+				intercept(task);
 			}
+
+			interval.reset();
 		}
 
-		// Apply all variables with a configured value that have changed in
-		// memory
-		for (const auto& task : console_var_tasks)
+		// Apply the variables whose policy asks for a check that have changed
+		// in memory, once checked that they are still where they were found
+		// A CVar applied once is checked less often, and gets its value again
+		// when it is found at a new address
+		bool overridden = false;
+		for (auto& task : console_var_tasks)
 		{
-			if (task.cfg.opt_value && *task.cvar != task.cfg.opt_value.value())
+			if (!task.assignment)
+				continue;
+
+			const auto& policy = task.cfg.policy;
+			if (policy.when == config::enforcement_policy::mode::rate_limited)
+			{
+				const auto now = std::chrono::steady_clock::now();
+				if (now < task.next_check)
+					continue;
+				task.next_check =
+					now + std::chrono::milliseconds{policy.interval_ms};
+			}
+			else if (
+				!policy.checked_continuously() && !task.pending && task.cvar)
 			{
-				*task.cvar = task.cfg.opt_value.value();
+				const auto now = std::chrono::steady_clock::now();
+				if (now < task.next_check)
+					continue;
+				task.next_check = now + IDLE_LIVENESS_CHECK_INTERVAL;
 			}
+
+			if (task.cvar)
+			{
+				const auto state = cry::check_liveness(
+					source, task.pattern, task.cvar, task.vtable);
+				if (state != cry::liveness::alive)
+				{
+					log::warn(
+						"{} at {} is {}, looking for it again",
+						task.name(),
+						static_cast<void*>(task.cvar),
+						cry::to_string(state));
+					if (hooks)
+						interceptor.manage(task.cvar, std::nullopt);
+					task.lost = task.cvar;
+					task.cvar = nullptr;
+					task.applied = false;
+					task.retry = std::chrono::steady_clock::now();
+					task.failures = 0;
+				}
+			}
+
+			// A CVar registered again is recorded by the registration hook
+			if (!task.cvar && registration_ && registration_->installed())
+			{
+				const auto registration = registered_.lookup(task.name());
+				if (registration && registration->var != task.lost &&
+					cry::check_liveness(
+						source,
+						task.pattern,
+						registration->var,
+						registration->vtable) == cry::liveness::alive)
+				{
+					task.cvar = registration->var;
+					task.vtable = registration->vtable;
+					task.pending = true;
+					log::info("{} registered again", task.name());
+					intercept(task);
+				}
+			}
+
+			// Around the old address first, every region if that fails
+			if (!task.cvar && std::chrono::steady_clock::now() >= task.retry)
+			{
+				task.cvar = cry::resolve_moved_cvar(
+					source, task.pattern, task.lost, task.vtable, buffer);
+				intercept(task);
+				if (task.cvar)
+				{
+					task.pending = true;
+				}
+				else
+				{
+					// Retries are spaced more and more, up to about a minute
+					task.failures = std::min(task.failures + 1, 5u);
+					task.retry = std::chrono::steady_clock::now() +
+								 WAIT_TIME_AFTER_FAILED_SCAN *
+									 (1 << task.failures);
+				}
+			}
+
+			if (!task.cvar)
+				continue;
+
+			if (!policy.checked_continuously() && !task.pending)
+				continue;
+
+			if (!task.assignment->matches(task.cvar, layout))
+			{
+				task.assignment->write(task.cvar, layout);
+				if (!task.assignment->holds(task.cvar, layout))
+				{
+					log::debug("{} was written during the update", task.name());
+					overridden = true;
+				}
+
+				if (task.applied)
+				{
+					const auto latency =
+						std::chrono::duration_cast<std::chrono::microseconds>(
+							std::chrono::steady_clock::now() -
+							overriddenAfter);
+					task.overrides.record(latency);
+					log::debug(
+						"{} was overridden, restored within {:.1f} ms",
+						task.name(),
+						latency.count() / 1000.0);
+					overridden = true;
+					statsChanged = true;
+				}
+			}
+
+			task.applied = true;
+			task.pending = false;
 		}
 
-		switch (win::wait_on_objects(
-			WAIT_TIME_AFTER_VAR_CHECK,
-			thread_.quit_event(),
-			configFileMonitor.event_handle()))
+		const auto now = std::chrono::steady_clock::now();
+		overriddenAfter = now;
+		if (statsChanged && now - statsLogged >= OVERRIDE_STATS_LOG_INTERVAL)
+		{
+			logOverrideStats();
+			statsLogged = now;
+		}
+
+		// A write that changed no CVar hit other data on their pages: they
+		// stay writable until the next check instead of faulting on every
+		// write to that data
+		const bool unrelatedWrite = writeCaught && !overridden;
+		writeCaught = false;
+
+		std::chrono::milliseconds waitTime = interval.next(overridden);
+		if (watch && !unrelatedWrite && watchConsoleVars())
+			waitTime = std::chrono::milliseconds{settings.write_watch_check_ms};
+
+		const auto waitResult =
+			watch ? win::wait_on_objects(
+						waitTime,
+						thread_.quit_event(),
+						configFileMonitor.event_handle(),
+						watch->event_handle()) :
+					win::wait_on_objects(
+						waitTime,
+						thread_.quit_event(),
+						configFileMonitor.event_handle());
+
+		switch (waitResult)
 		{
 		case WAIT_OBJECT_0:
 			log::info("Quit event signaled!");
+			logOverrideStats();
 			return;
 
 		case WAIT_OBJECT_0 + 1:
 			configFileMonitor.on_event_signaled();
 			break;
 
+		case WAIT_OBJECT_0 + 2:
+			// The write that ended the wait is the override
+			overriddenAfter = std::chrono::steady_clock::now();
+			writeCaught = true;
+			log::debug(
+				"{} write(s) to CVar pages caught", watch->take_writes());
+			break;
+
 		case WAIT_TIMEOUT:
 			break;
 
@@ -197,4 +952,104 @@ void instance_impl::run()
 	}
 }
 
+void instance_impl::run()
+{
+	const auto configPath =
+		win::get_appdata_path() / L"ShugoConsole" / "config.toml";
+	log::info("Config file path: {}", configPath.u8string());
+
+	// Monitor config file, wait 1 second before applying changes
+	win::file_monitor configFileMonitor{configPath,
+										WAIT_TIME_AFTER_FILE_CHANGE};
+
+	auto cfg = config::configuration::from_file(CONSOLE_VARS, configPath);
+
+	std::vector<console_var_task> console_var_tasks;
+
+	std::transform(
+		cfg.vars.begin(),
+		cfg.vars.end(),
+		std::back_inserter(console_var_tasks),
+		[](const auto& cfg) {
+			return console_var_task{cfg, nullptr};
+		});
+
+	// CVars are recorded as the engine registers them, from the start if the
+	// hook is installed before the engine creates its console
+	// The module registering them is hooked here, or as soon as it is loaded
+	const auto signature = cfg.registration.hook ?
+		cry::signature::parse(cfg.registration.signature) :
+		std::nullopt;
+	if (cfg.registration.hook && !signature)
+	{
+		log::error(
+			"'registration.signature': '{}' is not a valid signature",
+			cfg.registration.signature);
+	}
+	if (registration_ &&
+		(!signature ||
+		 !registration_->install(
+			 std::filesystem::u8path(cfg.registration.module).wstring(),
+			 *signature,
+			 registered_)))
+	{
+		registration_.reset();
+	}
+
+	// The client build keys the CVar cache and the layout database
+	const auto fingerprint = win::client_modules_fingerprint();
+
+	// Find all configurable CVars in memory
+	const auto source = cry::make_process_region_source();
+	std::vector<std::byte> buffer(64 * 1024);
+	if (!find_console_vars(
+			console_var_tasks,
+			cfg,
+			fingerprint,
+			configPath.parent_path() / "cvar_cache.toml",
+			configPath.parent_path() / "region_stats.toml"))
+	{
+		return;
+	}
+
+	// Value layout of the client build, probed on the CVars found the first
+	// time the build is seen
+	const auto layoutPath = configPath.parent_path() / "cvar_layouts.toml";
+	auto layouts = layout_db::from_file(layoutPath);
+	auto probed = layouts.find(fingerprint);
+	if (!probed)
+	{
+		std::vector<cry::layout_sample> samples;
+		for (const auto& task : console_var_tasks)
+			samples.push_back({task.cvar, task.type()});
+		probed = cry::probe_layout(*source, samples);
+
+		if (probed && fingerprint != 0)
+		{
+			layouts.layouts[fingerprint] = *probed;
+			layouts.save(layoutPath);
+		}
+	}
+
+	const auto layout = probed.value_or(cry::cvar_layout::native());
+	log::info(
+		"CVar values at int {}, float {}, string {}",
+		layout.int_offset,
+		layout.float_offset,
+		layout.string_offset);
+
+	// Known layouts are picked once here, their offsets are then compile time
+	// constants
+	cry::dispatch_layout(layout, [&](const auto& l) {
+		enforce_console_vars(
+			console_var_tasks,
+			cfg.enforcement,
+			configPath,
+			configFileMonitor,
+			*source,
+			buffer,
+			l);
+	});
+}
+
 } // namespace shugoconsole
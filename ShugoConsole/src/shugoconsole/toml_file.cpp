@@ -0,0 +1,26 @@
+#include "shugoconsole/toml_file.hpp"
+
+namespace shugoconsole
+{
+
+bool write_toml_file(
+	const std::filesystem::path& path,
+	std::string_view description,
+	std::string_view text)
+{
+	std::ofstream stream{path, std::ios::trunc};
+
+	if (!stream.is_open())
+	{
+		log::warn(
+			"Could not open {} file '{}' for writing.",
+			description,
+			path.u8string());
+		return false;
+	}
+
+	stream << text;
+	return true;
+}
+
+} // namespace shugoconsole
@@ -0,0 +1,64 @@
+#ifndef SHUGOCONSOLE_TOML_FILE_HPP
+#define SHUGOCONSOLE_TOML_FILE_HPP
+
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+#include <toml.hpp>
+
+#include "shugoconsole/log.hpp"
+
+namespace shugoconsole
+{
+
+// Parses the TOML file at path and converts its root with read, which throws
+// if the content is invalid
+// Returns nullopt if there is no file at path or if it is invalid.
+// description names the file in the logs
+template<typename Read>
+auto read_toml_file(
+	const std::filesystem::path& path,
+	std::string_view description,
+	Read&& read)
+	-> std::optional<std::decay_t<decltype(read(toml::value{}))>>
+{
+	// Use ifstream to open file because toml11 does not
+	// support wchar_t filenames
+	std::ifstream stream{path};
+
+	if (!stream.is_open())
+	{
+		log::debug("No {} file at '{}'", description, path.u8string());
+		return std::nullopt;
+	}
+
+	try
+	{
+		return read(toml::parse(stream));
+	}
+	catch (std::exception& e)
+	{
+		log::warn(
+			"Ignoring invalid {} file '{}': {}",
+			description,
+			path.u8string(),
+			e.what());
+		return std::nullopt;
+	}
+}
+
+// Replaces the file at path with text
+// Returns false if the file can't be opened, description names the file in
+// the logs
+bool write_toml_file(
+	const std::filesystem::path& path,
+	std::string_view description,
+	std::string_view text);
+
+} // namespace shugoconsole
+
+#endif // SHUGOCONSOLE_TOML_FILE_HPP
@@ -0,0 +1,163 @@
+#include "shugoconsole/win/cvar_set_hooks.hpp"
+#include "shugoconsole/log.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include <detours.h>
+
+namespace shugoconsole::win
+{
+
+namespace
+{
+
+std::atomic<bool> exists{false};
+
+// true if the size bytes at address are committed and readable
+bool readable(const void* address, size_t size)
+{
+	MEMORY_BASIC_INFORMATION info;
+	if (::VirtualQuery(address, &info, sizeof(info)) != sizeof(info))
+		return false;
+
+	const auto end = static_cast<const char*>(info.BaseAddress) +
+					 info.RegionSize;
+	return info.State == MEM_COMMIT &&
+		   (info.Protect & (PAGE_NOACCESS | PAGE_GUARD)) == 0 &&
+		   static_cast<const char*>(address) + size <= end;
+}
+
+// true if address is in the executable code of a loaded module
+bool module_code(const void* address)
+{
+	MEMORY_BASIC_INFORMATION info;
+	if (::VirtualQuery(address, &info, sizeof(info)) != sizeof(info))
+		return false;
+
+	const DWORD executable = PAGE_EXECUTE | PAGE_EXECUTE_READ |
+							 PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY;
+	return info.State == MEM_COMMIT && info.Type == MEM_IMAGE &&
+		   (info.Protect & executable) != 0;
+}
+
+// Function at slot of the vtable of var, nullptr if it doesn't look like code
+void* method_of(const cry::cvar* var, unsigned slot)
+{
+	const auto vtable = static_cast<void* const*>(var->dummy0);
+	if (!readable(vtable + slot, sizeof(void*)))
+		return nullptr;
+
+	const auto function = vtable[slot];
+	return module_code(function) ? function : nullptr;
+}
+
+} // namespace
+
+std::unique_ptr<cvar_set_hooks> cvar_set_hooks::install(
+	const std::vector<cry::cvar*>& vars,
+	const slots& s,
+	cry::set_interceptor& interceptor)
+{
+	if (exists.exchange(true))
+	{
+		log::error("Only one set of CVar hooks can exist");
+		return nullptr;
+	}
+
+	const std::pair<cry::set_hooks::method, unsigned> methods[] = {
+		{cry::set_hooks::method::string, s.string},
+		{cry::set_hooks::method::floating, s.floating},
+		{cry::set_hooks::method::integer, s.integer}};
+
+	// CVars of the same class share their methods, each is hooked once
+	std::vector<cry::set_hooks::target> targets;
+	for (const auto var : vars)
+	{
+		if (!var)
+			continue;
+
+		for (const auto& [m, slot] : methods)
+		{
+			const auto function = method_of(var, slot);
+			if (!function)
+			{
+				log::error(
+					"Slot {} of the vtable of {} is not a method, CVar "
+					"writes are not hooked",
+					slot,
+					var->name.data());
+				cry::set_hooks::release_all();
+				exists = false;
+				return nullptr;
+			}
+
+			const auto target = cry::set_hooks::reserve(m, function);
+			if (!target)
+			{
+				log::error("Too many CVar classes, CVar writes are not hooked");
+				cry::set_hooks::release_all();
+				exists = false;
+				return nullptr;
+			}
+
+			if (std::none_of(
+					targets.begin(), targets.end(), [&](const auto& t) {
+						return t.function == function;
+					}))
+			{
+				targets.push_back(*target);
+			}
+		}
+	}
+
+	cry::set_hooks::use(&interceptor);
+
+	::DetourTransactionBegin();
+	::DetourUpdateThread(::GetCurrentThread());
+	for (const auto& target : targets)
+		::DetourAttach(target.trampoline, target.replacement);
+
+	const auto error = ::DetourTransactionCommit();
+	if (error != NO_ERROR)
+	{
+		log::error("DetourTransactionCommit failed: {}", error);
+		cry::set_hooks::use(nullptr);
+		cry::set_hooks::release_all();
+		exists = false;
+		return nullptr;
+	}
+
+	log::info("{} CVar Set methods hooked", targets.size());
+	return std::unique_ptr<cvar_set_hooks>{
+		new cvar_set_hooks{std::move(targets)}};
+}
+
+cvar_set_hooks::~cvar_set_hooks()
+{
+	::DetourTransactionBegin();
+	::DetourUpdateThread(::GetCurrentThread());
+	for (const auto& target : targets_)
+		::DetourDetach(target.trampoline, target.replacement);
+
+	const auto error = ::DetourTransactionCommit();
+	if (error != NO_ERROR)
+	{
+		// The replacements stay in place and let every Set through, no other
+		// hooks can be installed
+		log::error("DetourTransactionCommit failed: {}", error);
+		cry::set_hooks::use(nullptr);
+		return;
+	}
+
+	cry::set_hooks::use(nullptr);
+	cry::set_hooks::release_all();
+	exists = false;
+}
+
+} // namespace shugoconsole::win
@@ -0,0 +1,53 @@
+#ifndef SHUGOCONSOLE_WIN_CVAR_SET_HOOKS_HPP
+#define SHUGOCONSOLE_WIN_CVAR_SET_HOOKS_HPP
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "shugoconsole/cry/cvar.hpp"
+#include "shugoconsole/cry/set_hooks.hpp"
+
+namespace shugoconsole::win
+{
+
+// Detours the Set methods of the classes of the CVars, so that the writes of
+// the engine go through a cry::set_interceptor
+// Only one instance can exist at a time
+class cvar_set_hooks final
+{
+public:
+	// Slots of Set(const char*), Set(float) and Set(int) in the vtables
+	struct slots
+	{
+		unsigned string;
+		unsigned floating;
+		unsigned integer;
+	};
+
+	// Hooks the Set methods found in the vtables of vars, nullptr entries are
+	// ignored. Returns nullptr if a method isn't code of a loaded module or
+	// if Detours fails
+	static std::unique_ptr<cvar_set_hooks> install(
+		const std::vector<cry::cvar*>& vars,
+		const slots& s,
+		cry::set_interceptor& interceptor);
+
+	// Removes the hooks
+	~cvar_set_hooks();
+
+	cvar_set_hooks(const cvar_set_hooks&) = delete;
+	cvar_set_hooks& operator=(const cvar_set_hooks&) = delete;
+
+private:
+	explicit cvar_set_hooks(std::vector<cry::set_hooks::target> targets) :
+		targets_{std::move(targets)}
+	{
+	}
+
+	std::vector<cry::set_hooks::target> targets_;
+};
+
+} // namespace shugoconsole::win
+
+#endif // SHUGOCONSOLE_WIN_CVAR_SET_HOOKS_HPP
@@ -0,0 +1,43 @@
+#include "shugoconsole/win/guarded_call.hpp"
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+namespace shugoconsole::win
+{
+
+#if defined _MSC_VER
+
+static int filter_access_violation(DWORD code)
+{
+	return code == EXCEPTION_ACCESS_VIOLATION ||
+				   code == EXCEPTION_GUARD_PAGE ||
+				   code == EXCEPTION_IN_PAGE_ERROR ?
+			   EXCEPTION_EXECUTE_HANDLER :
+			   EXCEPTION_CONTINUE_SEARCH;
+}
+
+bool guarded_call(void (*f)(void*), void* context) noexcept
+{
+	__try
+	{
+		f(context);
+		return true;
+	}
+	__except (filter_access_violation(::GetExceptionCode()))
+	{
+		return false;
+	}
+}
+
+#else
+
+bool guarded_call(void (*)(void*), void*) noexcept
+{
+	return false;
+}
+
+#endif
+
+} // namespace shugoconsole::win
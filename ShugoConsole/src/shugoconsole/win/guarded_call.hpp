@@ -0,0 +1,24 @@
+#ifndef SHUGOCONSOLE_WIN_GUARDED_CALL_HPP
+#define SHUGOCONSOLE_WIN_GUARDED_CALL_HPP
+
+namespace shugoconsole::win
+{
+
+// true if guarded_call can catch access violations with this compiler
+#if defined _MSC_VER
+constexpr bool has_guarded_call = true;
+#else
+constexpr bool has_guarded_call = false;
+#endif
+
+// Calls f(context) and returns true, or returns false as soon as f raises an
+// access violation, for instance because a page was decommitted while it was
+// being read
+// f is stopped by a structured exception: it must not own objects that need
+// to be destroyed. Without compiler support, f is not called and false is
+// returned
+bool guarded_call(void (*f)(void*), void* context) noexcept;
+
+} // namespace shugoconsole::win
+
+#endif // SHUGOCONSOLE_WIN_GUARDED_CALL_HPP
@@ -0,0 +1,263 @@
+#include "shugoconsole/win/heap_block_source.hpp"
+#include "shugoconsole/log.hpp"
+#include "shugoconsole/win/utils.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+namespace shugoconsole::win
+{
+
+namespace
+{
+
+using namespace std::literals::chrono_literals;
+
+// Longest time a heap stays locked: the threads allocating from it wait
+// meanwhile. The blocks after a longer walk are only scanned by the scans of
+// every region
+const auto MAX_LOCK_TIME = 20ms;
+
+// The clock is read once every CLOCK_INTERVAL heap entries
+const size_t CLOCK_INTERVAL = 1024;
+
+// Blocks stored by the first walk, the room doubles for every walk that
+// doesn't fit
+const size_t INITIAL_CAPACITY = 16 * 1024;
+
+// Blocks found by a walk, stored in memory that comes from no heap: the
+// walked heap must not change while it is locked
+class block_buffer final
+{
+public:
+	block_buffer() = default;
+	~block_buffer() { release(); }
+
+	block_buffer(const block_buffer&) = delete;
+	block_buffer& operator=(const block_buffer&) = delete;
+
+	// Replaces the buffer by an empty one with room for capacity blocks
+	// Returns false and keeps the buffer if it can't be allocated
+	bool reserve(size_t capacity)
+	{
+		const auto data = static_cast<cry::region*>(::VirtualAlloc(
+			nullptr,
+			capacity * sizeof(cry::region),
+			MEM_COMMIT | MEM_RESERVE,
+			PAGE_READWRITE));
+		if (!data)
+			return false;
+
+		release();
+		data_ = data;
+		capacity_ = capacity;
+		return true;
+	}
+
+	size_t capacity() const noexcept { return capacity_; }
+	bool full() const noexcept { return size_ == capacity_; }
+
+	void clear() noexcept { size_ = 0; }
+	void push_back(const cry::region& r) noexcept { data_[size_++] = r; }
+
+	const cry::region* begin() const noexcept { return data_; }
+	const cry::region* end() const noexcept { return data_ + size_; }
+
+private:
+	void release() noexcept
+	{
+		if (data_)
+			::VirtualFree(data_, 0, MEM_RELEASE);
+		data_ = nullptr;
+		capacity_ = 0;
+		size_ = 0;
+	}
+
+	cry::region* data_ = nullptr;
+	size_t capacity_ = 0;
+	size_t size_ = 0;
+};
+
+// Stores the accepted busy blocks of heap in blocks, nothing is allocated
+// nor logged while the heap is locked
+// Returns false if blocks got full, the walk has to be done again with more
+// room
+bool walk_heap(
+	HANDLE heap,
+	const cry::heap_block_filter& filter,
+	block_buffer& blocks)
+{
+	blocks.clear();
+
+	if (!::HeapLock(heap))
+	{
+		log::debug(
+			"Could not lock heap {}: {}",
+			static_cast<void*>(heap),
+			win::get_last_error_as_string());
+		return true;
+	}
+
+	const auto deadline = std::chrono::steady_clock::now() + MAX_LOCK_TIME;
+	PROCESS_HEAP_ENTRY entry{};
+	// Blocks follow the entry of the heap region they are part of
+	std::byte* regionBase = nullptr;
+	size_t entries = 0;
+	bool full = false;
+	bool timedOut = false;
+	bool walked = true;
+
+	while ((walked = ::HeapWalk(heap, &entry)) != FALSE)
+	{
+		if (entry.wFlags & PROCESS_HEAP_REGION)
+		{
+			regionBase = static_cast<std::byte*>(entry.lpData);
+		}
+		else if (
+			(entry.wFlags & PROCESS_HEAP_ENTRY_BUSY) &&
+			filter.accepts(entry.cbData))
+		{
+			if (blocks.full())
+			{
+				full = true;
+				break;
+			}
+
+			blocks.push_back(cry::region{
+				static_cast<std::byte*>(entry.lpData),
+				entry.cbData,
+				regionBase ? regionBase :
+							 static_cast<std::byte*>(entry.lpData)});
+		}
+
+		if (++entries % CLOCK_INTERVAL == 0 &&
+			std::chrono::steady_clock::now() > deadline)
+		{
+			timedOut = true;
+			break;
+		}
+	}
+
+	const auto error = walked ? ERROR_SUCCESS : ::GetLastError();
+	::HeapUnlock(heap);
+
+	if (!walked && error != ERROR_NO_MORE_ITEMS)
+	{
+		::SetLastError(error);
+		log::debug(
+			"HeapWalk of heap {} failed: {}",
+			static_cast<void*>(heap),
+			win::get_last_error_as_string());
+	}
+
+	if (timedOut)
+	{
+		log::debug(
+			"Walk of heap {} stopped after {:d} entries",
+			static_cast<void*>(heap),
+			entries);
+	}
+
+	return !full;
+}
+
+} // namespace
+
+void heap_block_source::reset()
+{
+	runs_.clear();
+	next_ = 0;
+	loaded_ = true;
+
+	std::vector<HANDLE> heaps(16);
+	for (;;)
+	{
+		const auto count = ::GetProcessHeaps(
+			static_cast<DWORD>(heaps.size()), heaps.data());
+		if (count == 0)
+		{
+			log::debug(
+				"GetProcessHeaps failed: {}",
+				win::get_last_error_as_string());
+			return;
+		}
+
+		const bool complete = count <= heaps.size();
+		heaps.resize(count);
+		if (complete)
+			break;
+	}
+
+	block_buffer walked;
+	if (!walked.reserve(INITIAL_CAPACITY))
+	{
+		log::debug(
+			"Could not allocate the blocks of a heap walk: {}",
+			win::get_last_error_as_string());
+		return;
+	}
+
+	std::vector<cry::region> blocks;
+	for (const auto heap : heaps)
+	{
+		// A walk that didn't fit is done again, unless more room can't be
+		// allocated: the blocks that fit are kept then
+		while (!walk_heap(heap, filter_, walked) &&
+			   walked.reserve(2 * walked.capacity()))
+		{
+		}
+
+		blocks.insert(blocks.end(), walked.begin(), walked.end());
+	}
+
+	// Heaps are interleaved in the address space
+	std::sort(
+		blocks.begin(),
+		blocks.end(),
+		[](const cry::region& a, const cry::region& b) {
+			return a.base < b.base;
+		});
+
+	size_t bytes = 0;
+	for (const auto& block : blocks)
+	{
+		cry::append_heap_block(runs_, block, filter_.max_gap);
+		bytes += block.size;
+	}
+
+	log::debug(
+		"{:d} heaps: {:d} blocks in {:d} runs, {:d} bytes",
+		heaps.size(),
+		blocks.size(),
+		runs_.size(),
+		bytes);
+}
+
+bool heap_block_source::next(cry::region& r)
+{
+	if (!loaded_)
+		reset();
+
+	if (next_ == runs_.size())
+		return false;
+
+	r = runs_[next_++];
+	return true;
+}
+
+} // namespace shugoconsole::win
+
+namespace shugoconsole::cry
+{
+
+std::unique_ptr<region_source> make_heap_block_source(
+	const heap_block_filter& filter)
+{
+	return std::make_unique<win::heap_block_source>(filter);
+}
+
+} // namespace shugoconsole::cry
@@ -0,0 +1,55 @@
+#ifndef SHUGOCONSOLE_WIN_HEAP_BLOCK_SOURCE_HPP
+#define SHUGOCONSOLE_WIN_HEAP_BLOCK_SOURCE_HPP
+
+#include <vector>
+
+#include "shugoconsole/cry/heap_blocks.hpp"
+#include "shugoconsole/win/process_region_source.hpp"
+
+namespace shugoconsole::win
+{
+
+// Enumerates the busy blocks of the heaps of the current process with
+// HeapWalk
+// Allocators that take their memory directly from VirtualAlloc, like the
+// CryEngine bucket allocator, are not walked: their blocks are only found
+// by a scan of process_region_source
+class heap_block_source final : public cry::region_source
+{
+public:
+	explicit heap_block_source(const cry::heap_block_filter& filter) :
+		filter_{filter}
+	{
+	}
+
+	// Walks the heaps, each one is locked while it is walked, at most for
+	// about 20 ms
+	void reset() override;
+	bool next(cry::region& r) override;
+
+	size_t read(const std::byte* address, std::byte* buffer, size_t size)
+		override
+	{
+		return memory_.read(address, buffer, size);
+	}
+
+	bool read_in_place(
+		const std::byte* address,
+		size_t size,
+		void (*f)(void* context, const std::byte* view),
+		void* context) override
+	{
+		return memory_.read_in_place(address, size, f, context);
+	}
+
+private:
+	cry::heap_block_filter filter_;
+	process_region_source memory_;
+	std::vector<cry::region> runs_;
+	size_t next_ = 0;
+	bool loaded_ = false;
+};
+
+} // namespace shugoconsole::win
+
+#endif // SHUGOCONSOLE_WIN_HEAP_BLOCK_SOURCE_HPP
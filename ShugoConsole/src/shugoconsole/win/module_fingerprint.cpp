@@ -0,0 +1,101 @@
+#include "shugoconsole/win/module_fingerprint.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cwctype>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+namespace shugoconsole::win
+{
+
+namespace
+{
+
+// Modules of the client directory that register CVars, in the order they are
+// hashed. Missing ones are hashed as such
+constexpr std::array<const wchar_t*, 4> CVAR_MODULES{
+	L"CrySystem.dll", L"Cry3DEngine.dll", L"CryRenderD3D9.dll", L"Game.dll"};
+
+struct module_identity
+{
+	DWORD image_size = 0;
+	DWORD timestamp = 0;
+};
+
+// Image size and link timestamp from the PE headers of the file at path,
+// zeros if it doesn't exist or is not an image
+module_identity read_identity(const std::filesystem::path& path)
+{
+	std::ifstream file{path, std::ios::binary};
+
+	IMAGE_DOS_HEADER dosHeader{};
+	if (!file.read(reinterpret_cast<char*>(&dosHeader), sizeof(dosHeader)) ||
+		dosHeader.e_magic != IMAGE_DOS_SIGNATURE)
+	{
+		return {};
+	}
+
+	IMAGE_NT_HEADERS ntHeaders{};
+	if (!file.seekg(dosHeader.e_lfanew) ||
+		!file.read(reinterpret_cast<char*>(&ntHeaders), sizeof(ntHeaders)) ||
+		ntHeaders.Signature != IMAGE_NT_SIGNATURE)
+	{
+		return {};
+	}
+
+	return {
+		ntHeaders.OptionalHeader.SizeOfImage,
+		ntHeaders.FileHeader.TimeDateStamp};
+}
+
+// FNV-1a
+void hash_bytes(std::uint64_t& hash, const void* data, size_t size)
+{
+	const auto bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+}
+
+void hash_module(std::uint64_t& hash, const std::filesystem::path& path)
+{
+	// Paths may differ in case from one run to another
+	auto name = path.filename().wstring();
+	std::transform(name.begin(), name.end(), name.begin(), [](wchar_t c) {
+		return static_cast<wchar_t>(std::towlower(c));
+	});
+
+	const auto identity = read_identity(path);
+	hash_bytes(hash, name.data(), name.size() * sizeof(wchar_t));
+	hash_bytes(hash, &identity.image_size, sizeof(identity.image_size));
+	hash_bytes(hash, &identity.timestamp, sizeof(identity.timestamp));
+}
+
+} // namespace
+
+std::uint64_t client_modules_fingerprint()
+{
+	wchar_t exePath[MAX_PATH];
+	if (!::GetModuleFileNameW(nullptr, exePath, MAX_PATH))
+		return 0;
+
+	const std::filesystem::path executable{exePath};
+	const auto clientDir = executable.parent_path();
+
+	std::uint64_t hash = 0xcbf29ce484222325ull;
+	hash_module(hash, executable);
+	for (const auto module : CVAR_MODULES)
+		hash_module(hash, clientDir / module);
+
+	return hash;
+}
+
+} // namespace shugoconsole::win
@@ -0,0 +1,17 @@
+#ifndef SHUGOCONSOLE_WIN_MODULE_FINGERPRINT_HPP
+#define SHUGOCONSOLE_WIN_MODULE_FINGERPRINT_HPP
+
+#include <cstdint>
+
+namespace shugoconsole::win
+{
+
+// Hash of the name, image size and link timestamp of the executable and of the
+// client modules hosting CVars, identifying the client build
+// Headers are read from the files so that the hash doesn't depend on which
+// modules are loaded yet. Returns 0 if the executable path is unknown
+std::uint64_t client_modules_fingerprint();
+
+} // namespace shugoconsole::win
+
+#endif // SHUGOCONSOLE_WIN_MODULE_FINGERPRINT_HPP
@@ -0,0 +1,160 @@
+#include "shugoconsole/win/process_region_source.hpp"
+#include "shugoconsole/log.hpp"
+#include "shugoconsole/win/guarded_call.hpp"
+#include "shugoconsole/win/utils.hpp"
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+namespace shugoconsole::win
+{
+
+namespace
+{
+
+struct in_place_call
+{
+	void (*f)(void* context, const std::byte* view);
+	void* context;
+	const std::byte* address;
+};
+
+void call_in_place(void* context)
+{
+	const auto& call = *static_cast<in_place_call*>(context);
+	call.f(call.context, call.address);
+}
+
+} // namespace
+
+void process_region_source::reset()
+{
+	readAddress_ = nullptr;
+	done_ = false;
+}
+
+bool process_region_source::next(cry::region& r)
+{
+	MEMORY_BASIC_INFORMATION memoryBasicInformation{};
+
+	while (!done_)
+	{
+		log::trace(
+			"Calling VirtualQueryEx with base address {}",
+			static_cast<const void*>(readAddress_));
+
+		if (!::VirtualQueryEx(
+				::GetCurrentProcess(),
+				readAddress_,
+				&memoryBasicInformation,
+				sizeof(MEMORY_BASIC_INFORMATION)))
+		{
+			log::debug(
+				"VirtualQueryEx failed: {}",
+				win::get_last_error_as_string());
+			done_ = true;
+			break;
+		}
+
+		const std::byte* nextAddress =
+			static_cast<const std::byte*>(memoryBasicInformation.BaseAddress) +
+			memoryBasicInformation.RegionSize;
+
+#if defined _M_X64
+		constexpr uintptr_t VirtualMemoryMax = 0x7fffffff0000ull;
+#elif defined _M_IX86
+		constexpr uintptr_t VirtualMemoryMax = 0x78000000ul;
+#else
+#	error "Unrecognized architecture"
+#endif
+
+		if (nextAddress >= reinterpret_cast<const std::byte*>(VirtualMemoryMax))
+		{
+			log::trace("Reached end of user-mode address space!");
+			done_ = true;
+		}
+		else if (nextAddress <= readAddress_)
+		{
+			log::trace("nextAddress <= readAddress - wtf!");
+			done_ = true;
+		}
+		else
+		{
+			readAddress_ = nextAddress;
+		}
+
+		if (memoryBasicInformation.Type == MEM_PRIVATE &&
+			memoryBasicInformation.State == MEM_COMMIT &&
+			(memoryBasicInformation.Protect == PAGE_READWRITE ||
+			 memoryBasicInformation.Protect == PAGE_EXECUTE_READWRITE))
+		{
+			log::trace(
+				"Candidate region at: {} - {:d} bytes - Scanning...",
+				static_cast<void*>(memoryBasicInformation.BaseAddress),
+				memoryBasicInformation.RegionSize);
+
+			r.base = static_cast<std::byte*>(memoryBasicInformation.BaseAddress);
+			r.size = memoryBasicInformation.RegionSize;
+			r.allocation_base =
+				static_cast<std::byte*>(memoryBasicInformation.AllocationBase);
+			r.protection =
+				memoryBasicInformation.Protect == PAGE_EXECUTE_READWRITE ?
+					cry::region_protection::execute_read_write :
+					cry::region_protection::read_write;
+			return true;
+		}
+
+		log::trace(
+			"Non-candidate region at: {} - {:d} bytes - Ignoring",
+			static_cast<void*>(memoryBasicInformation.BaseAddress),
+			memoryBasicInformation.RegionSize);
+	}
+
+	return false;
+}
+
+size_t process_region_source::read(
+	const std::byte* address, std::byte* buffer, size_t size)
+{
+	SIZE_T bytesRead = 0;
+
+	if (!::ReadProcessMemory(
+			::GetCurrentProcess(),
+			address,
+			buffer,
+			size,
+			&bytesRead))
+	{
+		log::debug(
+			"Could not read {:d} bytes at address {}: {}",
+			size,
+			static_cast<const void*>(address),
+			win::get_last_error_as_string());
+		return 0;
+	}
+
+	return bytesRead;
+}
+
+bool process_region_source::read_in_place(
+	const std::byte* address,
+	size_t,
+	void (*f)(void* context, const std::byte* view),
+	void* context)
+{
+	in_place_call call{f, context, address};
+	return win::guarded_call(&call_in_place, &call);
+}
+
+} // namespace shugoconsole::win
+
+namespace shugoconsole::cry
+{
+
+std::unique_ptr<region_source> make_process_region_source()
+{
+	return std::make_unique<win::process_region_source>();
+}
+
+} // namespace shugoconsole::cry
@@ -0,0 +1,33 @@
+#ifndef SHUGOCONSOLE_WIN_PROCESS_REGION_SOURCE_HPP
+#define SHUGOCONSOLE_WIN_PROCESS_REGION_SOURCE_HPP
+
+#include "shugoconsole/cry/region_source.hpp"
+
+namespace shugoconsole::win
+{
+
+// Enumerates the committed, private, read-write regions of the current
+// process with VirtualQueryEx
+class process_region_source final : public cry::region_source
+{
+public:
+	process_region_source() = default;
+
+	void reset() override;
+	bool next(cry::region& r) override;
+	size_t read(const std::byte* address, std::byte* buffer, size_t size)
+		override;
+	bool read_in_place(
+		const std::byte* address,
+		size_t size,
+		void (*f)(void* context, const std::byte* view),
+		void* context) override;
+
+private:
+	const std::byte* readAddress_ = nullptr;
+	bool done_ = false;
+};
+
+} // namespace shugoconsole::win
+
+#endif // SHUGOCONSOLE_WIN_PROCESS_REGION_SOURCE_HPP
@@ -0,0 +1,297 @@
+#include "shugoconsole/win/registration_hook.hpp"
+#include "shugoconsole/cry/register_hook.hpp"
+#include "shugoconsole/log.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cwchar>
+#include <filesystem>
+
+#include <detours.h>
+
+namespace shugoconsole::win
+{
+
+namespace
+{
+
+std::atomic<bool> exists{false};
+
+// Declarations of ntdll that are not in the SDK headers
+struct unicode_string
+{
+	USHORT Length;
+	USHORT MaximumLength;
+	PWSTR Buffer;
+};
+
+struct dll_loaded_data
+{
+	ULONG Flags;
+	const unicode_string* FullDllName;
+	const unicode_string* BaseDllName;
+	PVOID DllBase;
+	ULONG SizeOfImage;
+};
+
+constexpr ULONG dll_loaded = 1;
+
+using notification_function = VOID(CALLBACK*)(ULONG, const void*, PVOID);
+using register_notification_function =
+	LONG(NTAPI*)(ULONG, notification_function, PVOID, PVOID*);
+using unregister_notification_function = LONG(NTAPI*)(PVOID);
+
+template<typename F>
+F ntdll_function(const char* name)
+{
+	const auto ntdll = ::GetModuleHandleW(L"ntdll.dll");
+	return ntdll ? reinterpret_cast<F>(::GetProcAddress(ntdll, name)) :
+				   nullptr;
+}
+
+// Calls f(first, last) for every executable region of the module mapped at
+// base
+template<typename F>
+void for_each_code_region(const void* base, F&& f)
+{
+	const DWORD executable = PAGE_EXECUTE | PAGE_EXECUTE_READ |
+							 PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY;
+
+	MEMORY_BASIC_INFORMATION info;
+	auto address = static_cast<const std::byte*>(base);
+	while (::VirtualQuery(address, &info, sizeof(info)) == sizeof(info) &&
+		   info.AllocationBase == base)
+	{
+		const auto first = static_cast<const std::byte*>(info.BaseAddress);
+		const auto last = first + info.RegionSize;
+		if (info.State == MEM_COMMIT && (info.Protect & executable) != 0 &&
+			(info.Protect & PAGE_GUARD) == 0)
+		{
+			f(first, last);
+		}
+		address = last;
+	}
+}
+
+std::string to_utf8(const std::wstring& s)
+{
+	return std::filesystem::path{s}.u8string();
+}
+
+} // namespace
+
+std::unique_ptr<registration_hook> registration_hook::watch()
+{
+	if (exists.exchange(true))
+		return nullptr;
+
+	std::unique_ptr<registration_hook> hook{new registration_hook};
+
+	// Nothing is logged yet, this may run while the loader lock is held
+	hook->loaded_event_ = ::CreateEventW(nullptr, FALSE, FALSE, nullptr);
+	if (!hook->loaded_event_)
+		return nullptr;
+
+	const auto registerNotification =
+		ntdll_function<register_notification_function>(
+			"LdrRegisterDllNotification");
+	if (!registerNotification ||
+		registerNotification(
+			0, &on_dll_notification, hook.get(), &hook->cookie_) != 0)
+	{
+		hook->cookie_ = nullptr;
+	}
+
+	return hook;
+}
+
+registration_hook::~registration_hook()
+{
+	if (cookie_)
+	{
+		if (const auto unregisterNotification =
+				ntdll_function<unregister_notification_function>(
+					"LdrUnregisterDllNotification"))
+		{
+			unregisterNotification(cookie_);
+		}
+	}
+
+	if (loaded_event_)
+		::CloseHandle(loaded_event_);
+
+	if (installed_)
+	{
+		::DetourTransactionBegin();
+		::DetourUpdateThread(::GetCurrentThread());
+		::DetourDetach(trampoline_, replacement_);
+		const auto error = ::DetourTransactionCommit();
+		if (error != NO_ERROR)
+		{
+			// The replacement stays in place and records nothing, no other
+			// hook can be installed
+			log::error("DetourTransactionCommit failed: {}", error);
+			cry::register_hook::use(nullptr);
+			return;
+		}
+	}
+
+	cry::register_hook::use(nullptr);
+	exists = false;
+}
+
+bool registration_hook::install(
+	const std::wstring& module,
+	cry::signature signature,
+	cry::registered_cvars& table)
+{
+	if (!cookie_)
+		log::warn("LdrRegisterDllNotification failed");
+
+	module_ = module;
+	signature_ = std::move(signature);
+	table_ = &table;
+	// Sequentially consistent with the notification: a module mapped after
+	// notified_from_ is read sees configured_
+	configured_.store(true);
+	notified_from_ = mapped_count_.load();
+	return install_loaded();
+}
+
+bool registration_hook::install_loaded()
+{
+	if (!configured_.load(std::memory_order_acquire))
+		return true;
+
+	// Not taken by the notification, which holds the loader lock
+	const auto base = ::GetModuleHandleW(module_.c_str());
+	if (!base)
+		return true;
+
+	// The notification hooks the module, maybe right now
+	const auto index = mapped_index(base);
+	if (index != capacity && index >= notified_from_)
+		return true;
+
+	std::lock_guard lock{mutex_};
+	if (attempted_)
+		return installed();
+
+	// The module was mapped before install, its CVars may exist
+	if (index == capacity)
+	{
+		log::warn(
+			"{} was loaded before ShugoConsole, the CVars it registered are "
+			"not recorded",
+			to_utf8(module_));
+	}
+	else
+	{
+		log::warn(
+			"{} was loaded before the configuration was read, the CVars it "
+			"registered meanwhile are not recorded",
+			to_utf8(module_));
+	}
+
+	return install_at(base);
+}
+
+bool registration_hook::install_at(const void* base)
+{
+	if (attempted_)
+		return installed();
+	attempted_ = true;
+
+	const std::byte* function = nullptr;
+	size_t matches = 0;
+	const auto search = [&](const std::byte* first, const std::byte* last) {
+		for (auto p = signature_->find(first, last); p;
+			 p = signature_->find(p + 1, last))
+		{
+			if (matches++ == 0)
+				function = p;
+		}
+	};
+	for_each_code_region(base, search);
+
+	if (matches != 1)
+	{
+		log::error(
+			"The signature of the CVar registration matches {:d} times in {}, "
+			"it is not hooked",
+			matches,
+			to_utf8(module_));
+		return false;
+	}
+
+	const auto target =
+		cry::register_hook::reserve(const_cast<std::byte*>(function));
+	cry::register_hook::use(table_);
+
+	::DetourTransactionBegin();
+	::DetourUpdateThread(::GetCurrentThread());
+	::DetourAttach(target.trampoline, target.replacement);
+	const auto error = ::DetourTransactionCommit();
+	if (error != NO_ERROR)
+	{
+		log::error("DetourTransactionCommit failed: {}", error);
+		cry::register_hook::use(nullptr);
+		return false;
+	}
+
+	trampoline_ = target.trampoline;
+	replacement_ = target.replacement;
+	installed_ = true;
+
+	log::info(
+		"CVar registration hooked at {} in {}",
+		static_cast<const void*>(function),
+		to_utf8(module_));
+	return true;
+}
+
+size_t registration_hook::mapped_index(const void* base) const noexcept
+{
+	const auto count = std::min(mapped_count_.load(), capacity);
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (mapped_[i].load(std::memory_order_acquire) == base)
+			return i;
+	}
+
+	return capacity;
+}
+
+VOID CALLBACK registration_hook::on_dll_notification(
+	ULONG reason, const void* data, PVOID context)
+{
+	if (reason != dll_loaded)
+		return;
+
+	auto& hook = *static_cast<registration_hook*>(context);
+	const auto& loaded = *static_cast<const dll_loaded_data*>(data);
+	const auto index = hook.mapped_count_.fetch_add(1);
+	if (index < capacity)
+		hook.mapped_[index].store(loaded.DllBase, std::memory_order_release);
+
+	::SetEvent(hook.loaded_event_);
+
+	// Modules mapped before install are hooked by install_loaded
+	if (!hook.configured_.load())
+		return;
+
+	const auto& name = *loaded.BaseDllName;
+	const auto length = name.Length / sizeof(wchar_t);
+	if (length != hook.module_.size() ||
+		::_wcsnicmp(name.Buffer, hook.module_.c_str(), length) != 0)
+	{
+		return;
+	}
+
+	// The module is not initialized yet, none of its CVars exist: the hook
+	// has to be installed now, the code of the module is mapped
+	std::lock_guard lock{hook.mutex_};
+	hook.install_at(loaded.DllBase);
+}
+
+} // namespace shugoconsole::win
@@ -0,0 +1,111 @@
+#ifndef SHUGOCONSOLE_WIN_REGISTRATION_HOOK_HPP
+#define SHUGOCONSOLE_WIN_REGISTRATION_HOOK_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "shugoconsole/cry/registered_cvars.hpp"
+#include "shugoconsole/cry/signature.hpp"
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+namespace shugoconsole::win
+{
+
+// Detours the function registering the CVars of the engine, found by its
+// signature in the code of a client module, so that every CVar is recorded in
+// a cry::registered_cvars as it is created
+// The loader notifies the modules it maps from the creation of the instance:
+// once install was called, the module is hooked by the notification, before
+// it is initialized. A module mapped earlier is hooked by install or
+// install_loaded
+// Only one instance can exist at a time
+class registration_hook final
+{
+public:
+	// Starts recording the modules mapped from now on, as early as possible,
+	// e.g. while ShugoConsole is attached
+	// Returns nullptr if another instance exists
+	static std::unique_ptr<registration_hook> watch();
+
+	// Removes the hook, or stops waiting for the module
+	~registration_hook();
+
+	registration_hook(const registration_hook&) = delete;
+	registration_hook& operator=(const registration_hook&) = delete;
+
+	// Hooks the function of module matching signature, now if the module is
+	// loaded, or else as soon as it is mapped, recording in table
+	// Returns false if the module is loaded and the signature doesn't match
+	// exactly once
+	// Must not be called with the loader lock held
+	bool install(
+		const std::wstring& module,
+		cry::signature signature,
+		cry::registered_cvars& table);
+
+	// Hooks the module given to install if it was loaded since and not
+	// hooked by the notification, once
+	// Returns false if the signature doesn't match exactly once
+	bool install_loaded();
+
+	// Signaled when the loader maps a module
+	HANDLE loaded_event() const noexcept { return loaded_event_; }
+
+	// true once the hook is installed
+	bool installed() const noexcept
+	{
+		return installed_.load(std::memory_order_acquire);
+	}
+
+private:
+	registration_hook() = default;
+
+	// Finds the function in the module mapped at base and detours it, once,
+	// with mutex_ locked
+	// Returns false if the signature doesn't match exactly once
+	bool install_at(const void* base);
+
+	// Order in which the loader mapped base after the instance was created,
+	// capacity if it was not recorded
+	size_t mapped_index(const void* base) const noexcept;
+
+	// Called by the loader with its lock held
+	static VOID CALLBACK
+	on_dll_notification(ULONG reason, const void* data, PVOID context);
+
+	// Bases of the modules mapped since the instance was created, the
+	// modules loaded after the first capacity ones are not recorded
+	static constexpr size_t capacity = 256;
+	std::array<std::atomic<const void*>, capacity> mapped_{};
+	std::atomic<size_t> mapped_count_{0};
+
+	// Set by install before configured_
+	std::wstring module_;
+	std::optional<cry::signature> signature_;
+	cry::registered_cvars* table_ = nullptr;
+	std::atomic<bool> configured_{false};
+	// The notification sees configured_ for the modules mapped from this
+	// index on, it hooks them
+	size_t notified_from_ = capacity;
+
+	// Held by the installation, from the notification or from install
+	std::mutex mutex_;
+	PVOID cookie_ = nullptr;
+	HANDLE loaded_event_ = nullptr;
+	void** trampoline_ = nullptr;
+	void* replacement_ = nullptr;
+	bool attempted_ = false;
+	std::atomic<bool> installed_{false};
+};
+
+} // namespace shugoconsole::win
+
+#endif // SHUGOCONSOLE_WIN_REGISTRATION_HOOK_HPP
@@ -1,4 +1,5 @@
 #include "shugoconsole/win/utils.hpp"
+#include "shugoconsole/log.hpp"
 
 #include <algorithm>
 
@@ -50,4 +51,19 @@ std::string get_last_error_as_string()
 	return message;
 }
 
+scoped_thread_priority::scoped_thread_priority(int priority) :
+	previous_{::GetThreadPriority(::GetCurrentThread())}
+{
+	if (!::SetThreadPriority(::GetCurrentThread(), priority))
+	{
+		log::warn(
+			"SetThreadPriority failed: {}", get_last_error_as_string());
+	}
+}
+
+scoped_thread_priority::~scoped_thread_priority()
+{
+	::SetThreadPriority(::GetCurrentThread(), previous_);
+}
+
 } // namespace shugoconsole::win
@@ -43,6 +43,21 @@ DWORD wait_on_objects(
 		wait_duration.count());
 }
 
+// Sets the priority of the calling thread and restores the previous one on
+// destruction
+class scoped_thread_priority final
+{
+public:
+	explicit scoped_thread_priority(int priority);
+	~scoped_thread_priority();
+
+	scoped_thread_priority(const scoped_thread_priority&) = delete;
+	scoped_thread_priority& operator=(const scoped_thread_priority&) = delete;
+
+private:
+	int previous_;
+};
+
 } // namespace shugoconsole::win
 
 #endif // SHUGOCONSOLE_WIN_UTILS_HPP
@@ -0,0 +1,186 @@
+#include "shugoconsole/win/write_watch.hpp"
+#include "shugoconsole/cry/watched_pages.hpp"
+#include "shugoconsole/log.hpp"
+#include "shugoconsole/win/utils.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+namespace shugoconsole::win
+{
+
+namespace
+{
+
+// Shared with the handler, which can run on any thread of the game
+// The pages outlive the instance, a write that faulted while the instance was
+// destroyed still finds its page
+cry::watched_pages pages;
+std::atomic<HANDLE> active_event{nullptr};
+std::atomic<bool> exists{false};
+
+std::uintptr_t page_size()
+{
+	static const std::uintptr_t size = [] {
+		SYSTEM_INFO info;
+		::GetSystemInfo(&info);
+		return static_cast<std::uintptr_t>(info.dwPageSize);
+	}();
+	return size;
+}
+
+void* page_address(std::uintptr_t page)
+{
+	return reinterpret_cast<void*>(page);
+}
+
+// true if page can be written to now
+bool writable(std::uintptr_t page)
+{
+	const DWORD writableProtections = PAGE_READWRITE | PAGE_WRITECOPY |
+									  PAGE_EXECUTE_READWRITE |
+									  PAGE_EXECUTE_WRITECOPY;
+
+	MEMORY_BASIC_INFORMATION info;
+	return ::VirtualQuery(page_address(page), &info, sizeof(info)) ==
+			   sizeof(info) &&
+		   info.State == MEM_COMMIT &&
+		   (info.Protect & writableProtections) != 0 &&
+		   (info.Protect & PAGE_GUARD) == 0;
+}
+
+LONG CALLBACK on_exception(EXCEPTION_POINTERS* info)
+{
+	const auto& record = *info->ExceptionRecord;
+	if (record.ExceptionCode != EXCEPTION_ACCESS_VIOLATION ||
+		record.NumberParameters < 2 || record.ExceptionInformation[0] != 1)
+	{
+		return EXCEPTION_CONTINUE_SEARCH;
+	}
+
+	const auto page = static_cast<std::uintptr_t>(
+						  record.ExceptionInformation[1]) &
+					  ~(page_size() - 1);
+	if (!pages.on_write(page))
+	{
+		// The write faulted before the page was released, it runs again
+		// Other faults are left to the next handlers
+		return writable(page) ? EXCEPTION_CONTINUE_EXECUTION :
+								EXCEPTION_CONTINUE_SEARCH;
+	}
+
+	// A page that was freed since it was watched faults for another reason
+	DWORD previous;
+	if (!::VirtualProtect(
+			page_address(page), page_size(), PAGE_READWRITE, &previous))
+	{
+		return EXCEPTION_CONTINUE_SEARCH;
+	}
+
+	if (const auto event = active_event.load(std::memory_order_acquire))
+		::SetEvent(event);
+
+	// The write runs again on the writable page
+	return EXCEPTION_CONTINUE_EXECUTION;
+}
+
+} // namespace
+
+std::unique_ptr<write_watch> write_watch::create()
+{
+	if (exists.exchange(true))
+	{
+		log::error("Only one write watch can exist");
+		return nullptr;
+	}
+
+	const auto event = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+	if (event == nullptr)
+	{
+		log::error("CreateEvent failed: {}", get_last_error_as_string());
+		exists = false;
+		return nullptr;
+	}
+
+	// First in the chain, before the handlers of the game
+	const auto handler = ::AddVectoredExceptionHandler(1, &on_exception);
+	if (handler == nullptr)
+	{
+		log::error("AddVectoredExceptionHandler failed");
+		::CloseHandle(event);
+		exists = false;
+		return nullptr;
+	}
+
+	active_event = event;
+	return std::unique_ptr<write_watch>{new write_watch{event, handler}};
+}
+
+write_watch::~write_watch()
+{
+	release_all();
+	active_event = nullptr;
+	::RemoveVectoredExceptionHandler(handler_);
+	::CloseHandle(event_);
+	exists = false;
+}
+
+bool write_watch::watch(const void* address, size_t size)
+{
+	const auto first =
+		reinterpret_cast<std::uintptr_t>(address) & ~(page_size() - 1);
+	const auto last =
+		(reinterpret_cast<std::uintptr_t>(address) + size - 1) &
+		~(page_size() - 1);
+
+	for (auto page = first; page <= last; page += page_size())
+	{
+		// Page of another CVar
+		if (pages.armed(page))
+			continue;
+
+		if (!pages.arm(page))
+			return false;
+
+		DWORD previous;
+		if (!::VirtualProtect(
+				page_address(page), page_size(), PAGE_READONLY, &previous))
+		{
+			pages.release(page);
+			return false;
+		}
+
+		// Guard pages, executable pages... are left as they are
+		if (previous != PAGE_READWRITE)
+		{
+			::VirtualProtect(page_address(page), page_size(), previous, &previous);
+			pages.release(page);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void write_watch::release_all()
+{
+	::ResetEvent(event_);
+
+	pages.for_each_page([](std::uintptr_t page) {
+		// The handler may have caught a write in the meantime and made the
+		// page writable itself
+		if (pages.release(page))
+		{
+			DWORD previous;
+			::VirtualProtect(
+				page_address(page), page_size(), PAGE_READWRITE, &previous);
+		}
+	});
+}
+
+size_t write_watch::take_writes()
+{
+	return pages.take_writes();
+}
+
+} // namespace shugoconsole::win
@@ -0,0 +1,61 @@
+#ifndef SHUGOCONSOLE_WIN_WRITE_WATCH_HPP
+#define SHUGOCONSOLE_WIN_WRITE_WATCH_HPP
+
+#include <cstddef>
+#include <memory>
+
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+namespace shugoconsole::win
+{
+
+// Catches writes to the pages of the CVars: watched pages are made read-only
+// and a vectored exception handler makes a page writable again on the first
+// write to it, then signals event_handle() and lets the write go on
+// Writes by the kernel to a watched page, for instance a ReadFile into a
+// buffer on the same page, fail instead of faulting
+// GetWriteWatch would not fault, but it only tracks memory allocated with
+// MEM_WRITE_WATCH, which the heaps of the game are not
+// Only one instance can exist at a time
+class write_watch final
+{
+public:
+	// Returns nullptr if another instance exists or if the handler can't be
+	// installed
+	static std::unique_ptr<write_watch> create();
+
+	// Makes every watched page writable and removes the handler
+	~write_watch();
+
+	write_watch(const write_watch&) = delete;
+	write_watch& operator=(const write_watch&) = delete;
+
+	// Makes the pages holding the size bytes at address read-only until they
+	// are written to or released
+	// Returns false if one of the pages is not a read-write page or if too
+	// many pages are watched
+	bool watch(const void* address, size_t size);
+
+	// Makes every watched page writable again, before the CVars are written
+	void release_all();
+
+	// Number of writes caught since the previous call
+	size_t take_writes();
+
+	// Signalled when a write is caught, reset by release_all
+	HANDLE event_handle() const { return event_; }
+
+private:
+	write_watch(HANDLE event, PVOID handler) : event_{event}, handler_{handler}
+	{
+	}
+
+	HANDLE event_;
+	PVOID handler_;
+};
+
+} // namespace shugoconsole::win
+
+#endif // SHUGOCONSOLE_WIN_WRITE_WATCH_HPP
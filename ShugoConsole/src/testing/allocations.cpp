@@ -0,0 +1,45 @@
+#include "testing/allocations.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+std::atomic<size_t> allocations{0};
+
+} // namespace
+
+#if defined __GNUC__ && !defined __clang__
+// GCC sees the pointers of the replaced operator new as not coming from malloc
+#	pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+namespace shugoconsole::testing
+{
+
+size_t allocation_count() noexcept
+{
+	return allocations.load(std::memory_order_relaxed);
+}
+
+} // namespace shugoconsole::testing
@@ -0,0 +1,15 @@
+#ifndef SHUGOCONSOLE_TESTING_ALLOCATIONS_HPP
+#define SHUGOCONSOLE_TESTING_ALLOCATIONS_HPP
+
+#include <cstddef>
+
+namespace shugoconsole::testing
+{
+
+// Heap allocations made by the process so far, counted by a replacement of
+// the global operator new linked into every program that calls this
+size_t allocation_count() noexcept;
+
+} // namespace shugoconsole::testing
+
+#endif // SHUGOCONSOLE_TESTING_ALLOCATIONS_HPP
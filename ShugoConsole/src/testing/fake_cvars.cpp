@@ -0,0 +1,59 @@
+#include "testing/fake_cvars.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace shugoconsole::testing
+{
+
+const std::vector<std::string> TARGET_NAMES{
+	"g_minFov",
+	"g_chatlog",
+	"g_camMax",
+	"d3d9_TripleBuffering",
+	"g_maxfps",
+	"r_Texture_Anisotropic_Level"};
+
+const std::vector<std::string> MISSING_NAMES{
+	"a_missing",
+	"b_missing",
+	"c_missing",
+	"e_missing",
+	"f_missing",
+	"h_missing",
+	"i_missing",
+	"j_missing",
+	"k_missing",
+	"l_missing"};
+
+const std::vector<std::string> FAKE_PREFIXES{
+	"g_", "r_", "e_", "i_", "s_", "ca_", "cl_", "sys_", "d3d9_", "log_"};
+
+cry::cvar* write_record(std::byte* address, const std::string& name)
+{
+	std::memcpy(address, &record_vtable, sizeof(void*));
+	address[offsetof(cry::cvar, cat)] = std::byte{0};
+	std::memcpy(
+		address + offsetof(cry::cvar, name),
+		name.c_str(),
+		std::min(name.size() + 1, sizeof(cry::cvar::name)));
+	return static_cast<cry::cvar*>(static_cast<void*>(address));
+}
+
+void fill_noise(std::byte* data, size_t size, std::mt19937& random)
+{
+	for (size_t i = 0; i + 8 <= size; i += 8)
+	{
+		const std::uint64_t word =
+			(static_cast<std::uint64_t>(random()) << 32) | random();
+		if (word % 8 < 3)
+			std::memcpy(data + i, &word, sizeof(word));
+	}
+}
+
+std::vector<cry::cvar::pattern> target_patterns()
+{
+	return {TARGET_NAMES.begin(), TARGET_NAMES.end()};
+}
+
+} // namespace shugoconsole::testing
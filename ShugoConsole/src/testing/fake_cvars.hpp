@@ -0,0 +1,42 @@
+#ifndef SHUGOCONSOLE_TESTING_FAKE_CVARS_HPP
+#define SHUGOCONSOLE_TESTING_FAKE_CVARS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "shugoconsole/cry/cvar.hpp"
+
+namespace shugoconsole::testing
+{
+
+// Names of the CVars ShugoConsole looks for
+extern const std::vector<std::string> TARGET_NAMES;
+
+// Names that are never found, with first letters different from the
+// targets so that the slot filter can only test the cat byte
+extern const std::vector<std::string> MISSING_NAMES;
+
+// Prefixes of the names of the fake CVars, as found in the client
+extern const std::vector<std::string> FAKE_PREFIXES;
+
+// Size of a fake CVar record, rounded up like CryEngine allocations
+constexpr size_t record_size = (sizeof(cry::cvar) + 15) / 16 * 16;
+
+// Vtable pointer of every record
+constexpr std::uintptr_t record_vtable = 0x1400c0de0;
+
+// Writes the header of a CVar named name at address
+cry::cvar* write_record(std::byte* address, const std::string& name);
+
+// Heaps are mostly zeros with some pointers and small integers
+void fill_noise(std::byte* data, size_t size, std::mt19937& random);
+
+// Patterns of TARGET_NAMES, in the same order
+std::vector<cry::cvar::pattern> target_patterns();
+
+} // namespace shugoconsole::testing
+
+#endif // SHUGOCONSOLE_TESTING_FAKE_CVARS_HPP
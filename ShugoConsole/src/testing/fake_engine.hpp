@@ -0,0 +1,39 @@
+#ifndef SHUGOCONSOLE_TESTING_FAKE_ENGINE_HPP
+#define SHUGOCONSOLE_TESTING_FAKE_ENGINE_HPP
+
+#include <cstddef>
+#include <cstdlib>
+
+#include "shugoconsole/cry/cvar.hpp"
+
+namespace shugoconsole::testing
+{
+
+// CVar class of the engine with the Set methods of ICVar, GCC puts them in the
+// vtable in this order: Set(const char*), Set(float) and Set(int) are in
+// slots 1, 2 and 3
+// Not in an anonymous namespace, where the compiler would know that no class
+// overrides them and would call them directly instead of through the vtable
+class fake_engine_cvar
+{
+public:
+	virtual void release() {}
+	virtual void set(const char* s) { value = std::strtof(s, nullptr); }
+	virtual void set(float f) { value = f; }
+	virtual void set(int i) { value = static_cast<float>(i); }
+
+	float value = 0.0f;
+};
+
+// Console of the engine, counting the CVars registered with it
+class fake_engine_console
+{
+public:
+	void register_var(cry::cvar*, void*) { ++registered; }
+
+	size_t registered = 0;
+};
+
+} // namespace shugoconsole::testing
+
+#endif // SHUGOCONSOLE_TESTING_FAKE_ENGINE_HPP
@@ -0,0 +1,59 @@
+#include "testing/process_heap.hpp"
+#include "testing/fake_cvars.hpp"
+
+#include <cstring>
+
+namespace shugoconsole::testing
+{
+
+process_heap::process_heap(
+	size_t blockCount,
+	size_t largeCount,
+	size_t largeSize,
+	std::uint32_t seed)
+{
+	std::mt19937 random{seed};
+
+	for (size_t i = 0; i < largeCount; ++i)
+		allocate(largeSize, random);
+
+	for (size_t i = 0; i < blockCount; ++i)
+	{
+		const size_t size =
+			(size_t{16} << random() % 12) + random() % 16 * 16;
+		allocate(size, random);
+
+		// Targets are allocated among the other blocks, each one after a
+		// stale copy whose vtable pointer was overwritten by the free list
+		// link of the allocator
+		if ((i + 1) % (blockCount / TARGET_NAMES.size()) == 0 &&
+			targets_.size() < TARGET_NAMES.size())
+		{
+			auto* stale = allocate(record_size, random);
+			write_record(stale, TARGET_NAMES[targets_.size()]);
+			std::memcpy(stale, &stale, sizeof(stale));
+
+			targets_.push_back(write_record(
+				allocate(record_size, random),
+				TARGET_NAMES[targets_.size()]));
+		}
+	}
+}
+
+cry::cvar* process_heap::move_target(size_t i)
+{
+	std::mt19937 random{static_cast<std::uint32_t>(i)};
+	auto* old = static_cast<std::byte*>(static_cast<void*>(targets_[i]));
+	targets_[i] = write_record(allocate(record_size, random), TARGET_NAMES[i]);
+	std::memcpy(old, &old, sizeof(old));
+	return targets_[i];
+}
+
+std::byte* process_heap::allocate(size_t size, std::mt19937& random)
+{
+	blocks_.emplace_back(new std::byte[size]());
+	fill_noise(blocks_.back().get(), size, random);
+	return blocks_.back().get();
+}
+
+} // namespace shugoconsole::testing
@@ -0,0 +1,43 @@
+#ifndef SHUGOCONSOLE_TESTING_PROCESS_HEAP_HPP
+#define SHUGOCONSOLE_TESTING_PROCESS_HEAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "shugoconsole/cry/cvar.hpp"
+
+namespace shugoconsole::testing
+{
+
+// Live allocations of the process: blocks of sizes spread from 16 bytes to
+// 32 KB, large buffers like textures and fake CVars with stale copies,
+// allocated with new[] like CryEngine objects
+class process_heap final
+{
+public:
+	process_heap(
+		size_t blockCount,
+		size_t largeCount,
+		size_t largeSize,
+		std::uint32_t seed);
+
+	// Addresses of the target CVars, in the same order as TARGET_NAMES
+	const std::vector<cry::cvar*>& targets() const noexcept { return targets_; }
+
+	// Reallocates target i like the client would, the old copy loses its
+	// vtable pointer
+	cry::cvar* move_target(size_t i);
+
+private:
+	std::byte* allocate(size_t size, std::mt19937& random);
+
+	std::vector<std::unique_ptr<std::byte[]>> blocks_;
+	std::vector<cry::cvar*> targets_;
+};
+
+} // namespace shugoconsole::testing
+
+#endif // SHUGOCONSOLE_TESTING_PROCESS_HEAP_HPP
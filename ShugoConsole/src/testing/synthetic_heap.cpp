@@ -0,0 +1,129 @@
+#include "testing/synthetic_heap.hpp"
+#include "testing/fake_cvars.hpp"
+
+#include <algorithm>
+#include <random>
+#include <utility>
+
+namespace shugoconsole::testing
+{
+
+synthetic_heap::synthetic_heap(
+	size_t size, size_t fakeCount, std::uint32_t seed) :
+	memory_(size + page_size)
+{
+	std::mt19937 random{seed};
+
+	// Regions are page aligned, like the allocations of a real process
+	const auto misalignment =
+		reinterpret_cast<std::uintptr_t>(memory_.data()) % page_size;
+	auto* base = memory_.data() + (page_size - misalignment) % page_size;
+
+	fill_noise(base, size, random);
+
+	std::uniform_int_distribution<size_t> regionPages{16, 4096};
+	for (size_t offset = 0; offset < size;)
+	{
+		const auto regionSize =
+			std::min(regionPages(random) * page_size, size - offset);
+		regions_.push_back(
+			cry::region{base + offset, regionSize, base + offset});
+		offset += regionSize;
+	}
+
+	// Fake records, some of them with names close to the targets
+	std::vector<cry::cvar*> records;
+	const size_t slotCount = (size - record_size) / 16;
+	std::uniform_int_distribution<size_t> slotDistribution{0, slotCount - 1};
+	std::uniform_int_distribution<size_t> prefixDistribution{
+		0, FAKE_PREFIXES.size() - 1};
+	std::uniform_int_distribution<size_t> targetDistribution{
+		0, TARGET_NAMES.size() - 1};
+	std::uniform_int_distribution<int> letterDistribution{'a', 'z'};
+
+	for (size_t i = 0; i < fakeCount; ++i)
+	{
+		std::string name;
+		if (i % 8 == 0)
+		{
+			// Shares a prefix with a target but is longer
+			name = TARGET_NAMES[targetDistribution(random)] + "_old";
+		}
+		else
+		{
+			name = FAKE_PREFIXES[prefixDistribution(random)];
+			const auto length = 4 + random() % 20;
+			for (size_t c = 0; c < length; ++c)
+				name += static_cast<char>(letterDistribution(random));
+		}
+
+		records.push_back(
+			write_record(base + slotDistribution(random) * 16, name));
+	}
+
+	// Targets are spread over the whole heap, the last one in the last
+	// region so that finding all of them scans everything
+	for (size_t i = 0; i < TARGET_NAMES.size(); ++i)
+	{
+		const size_t slot =
+			(i + 1) * slotCount / TARGET_NAMES.size() - 1 - random() % 64;
+		targets_.push_back(write_record(base + slot * 16, TARGET_NAMES[i]));
+	}
+
+	// Records may overlap, the registry holds the names left in memory
+	std::map<std::string, cry::cvar*> byName;
+	for (auto* var : targets_)
+		byName.emplace(var->name.data(), var);
+	for (auto* var : records)
+		byName.emplace(var->name.data(), var);
+	build_registry(byName);
+
+	size_ = size;
+}
+
+void synthetic_heap::build_registry(
+	const std::map<std::string, cry::cvar*>& byName)
+{
+	using node = cry::cvar_registry::map_node;
+
+	const std::vector<std::pair<std::string, cry::cvar*>> entries{
+		byName.begin(), byName.end()};
+
+	// The head is the first node
+	registry_.resize(entries.size() + 1);
+	const auto address = [this](size_t i) {
+		return static_cast<std::byte*>(static_cast<void*>(&registry_[i]));
+	};
+	std::byte* head = address(0);
+	registry_[0] = node{head, head, head, 1, 1, nullptr, nullptr};
+
+	const auto build = [&](const auto& self,
+						   size_t first,
+						   size_t last,
+						   std::byte* parent) -> std::byte* {
+		if (first >= last)
+			return head;
+
+		const size_t middle = (first + last) / 2;
+		auto* var = static_cast<std::byte*>(
+			static_cast<void*>(entries[middle].second));
+
+		node& n = registry_[middle + 1];
+		n.parent = parent;
+		n.color = 1;
+		n.is_nil = 0;
+		n.key = var + offsetof(cry::cvar, name);
+		n.value = var;
+		n.left = self(self, first, middle, address(middle + 1));
+		n.right = self(self, middle + 1, last, address(middle + 1));
+		return address(middle + 1);
+	};
+	registry_[0].parent = build(build, 0, entries.size(), head);
+	registry_[0].left = address(1);
+	registry_[0].right = address(entries.size());
+
+	regions_.push_back(
+		cry::region{head, registry_.size() * sizeof(node), head});
+}
+
+} // namespace shugoconsole::testing
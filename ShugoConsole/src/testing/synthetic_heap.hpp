@@ -0,0 +1,75 @@
+#ifndef SHUGOCONSOLE_TESTING_SYNTHETIC_HEAP_HPP
+#define SHUGOCONSOLE_TESTING_SYNTHETIC_HEAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "shugoconsole/cry/cvar.hpp"
+#include "shugoconsole/cry/cvar_registry.hpp"
+#include "shugoconsole/cry/region_source.hpp"
+
+namespace shugoconsole::testing
+{
+
+// Heap image split in regions of various sizes, filled with noise and fake
+// CVar records aligned on 16 bytes like CryEngine allocations, with the
+// console registry of the records in a region of its own
+class synthetic_heap final : public cry::region_source
+{
+public:
+	synthetic_heap(size_t size, size_t fakeCount, std::uint32_t seed);
+
+	size_t size() const noexcept { return size_; }
+
+	// Addresses of the target CVars, in the same order as TARGET_NAMES
+	const std::vector<cry::cvar*>& targets() const noexcept { return targets_; }
+
+	void reset() override { next_ = 0; }
+
+	bool next(cry::region& r) override
+	{
+		if (next_ >= regions_.size())
+			return false;
+
+		r = regions_[next_++];
+		return true;
+	}
+
+	size_t read(const std::byte* address, std::byte* buffer, size_t size)
+		override
+	{
+		std::memcpy(buffer, address, size);
+		return size;
+	}
+
+	bool read_in_place(
+		const std::byte* address,
+		size_t,
+		void (*f)(void* context, const std::byte* view),
+		void* context) override
+	{
+		f(context, address);
+		return true;
+	}
+
+private:
+	static constexpr size_t page_size = 4096;
+
+	// Builds the console registry of the records, a balanced MSVC std::map
+	void build_registry(const std::map<std::string, cry::cvar*>& byName);
+
+	std::vector<std::byte> memory_;
+	std::vector<cry::cvar_registry::map_node> registry_;
+	std::vector<cry::region> regions_;
+	std::vector<cry::cvar*> targets_;
+	size_t next_ = 0;
+	size_t size_ = 0;
+};
+
+} // namespace shugoconsole::testing
+
+#endif // SHUGOCONSOLE_TESTING_SYNTHETIC_HEAP_HPP
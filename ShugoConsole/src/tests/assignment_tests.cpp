@@ -0,0 +1,146 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "shugoconsole/cry/cvar.hpp"
+#include "shugoconsole/cry/cvar_layout.hpp"
+#include "shugoconsole/cry/cvar_liveness.hpp"
+#include "shugoconsole/cry/region_source.hpp"
+#include "testing/allocations.hpp"
+#include "testing/fake_cvars.hpp"
+#include "tests/test.hpp"
+
+using namespace shugoconsole;
+using namespace shugoconsole::testing;
+
+// Checks and writes of the enforcement loop, with the game overwriting a
+// CVar every 16 ticks
+TEST_CASE("assignment", "no_allocation")
+{
+	constexpr size_t ticks = 10000;
+	const std::vector<cry::cvar::value> values{
+		90.0f,
+		1,
+		30.0f,
+		0,
+		144,
+		std::string{"a string value longer than the SSO"}};
+
+	std::vector<std::byte> memory(TARGET_NAMES.size() * record_size);
+	std::vector<cry::cvar*> vars;
+	std::vector<cry::cvar::pattern> patterns;
+	std::vector<cry::cvar_assignment> plan;
+	for (size_t i = 0; i < TARGET_NAMES.size(); ++i)
+	{
+		vars.push_back(
+			write_record(memory.data() + i * record_size, TARGET_NAMES[i]));
+		patterns.emplace_back(TARGET_NAMES[i]);
+		plan.emplace_back(values[i]);
+	}
+
+	const auto source = cry::make_process_region_source();
+	const auto vtable = reinterpret_cast<std::uintptr_t>(vars.front()->dummy0);
+	constexpr cry::native_layout layout;
+
+	const auto check = [&](size_t i) {
+		const bool alive =
+			cry::check_liveness(*source, patterns[i], vars[i], vtable) ==
+			cry::liveness::alive;
+		if (plan[i].matches(vars[i], layout))
+			return alive;
+		plan[i].write(vars[i], layout);
+		return alive && plan[i].matches(vars[i], layout);
+	};
+
+	// The first checks may allocate while the source sets itself up
+	for (size_t i = 0; i < vars.size(); ++i)
+		check(i);
+
+	const auto before = allocation_count();
+	bool correct = true;
+	for (size_t tick = 0; tick < ticks; ++tick)
+	{
+		if (tick % 16 == 0)
+			*vars[(tick / 16) % vars.size()] = 0.5f;
+		for (size_t i = 0; i < vars.size(); ++i)
+			correct = check(i) && correct;
+	}
+	CHECK(allocation_count() == before);
+	CHECK(correct);
+}
+
+// Another thread reads the int and the float together while the CVar is
+// written back and forth: the numbers always belong to the same value
+TEST_CASE("assignment", "no_torn_numbers")
+{
+	using namespace std::chrono_literals;
+
+	alignas(16) std::array<std::byte, record_size> record{};
+	const auto var = write_record(record.data(), TARGET_NAMES.front());
+	constexpr cry::native_layout layout;
+	static_assert(
+		offsetof(cry::cvar, float_value) ==
+			offsetof(cry::cvar, int_value) + sizeof(int) &&
+		offsetof(cry::cvar, int_value) % 8 == 0);
+
+	const cry::cvar_assignment first{90.0f};
+	const cry::cvar_assignment second{120.0f};
+	first.write(var, layout);
+
+	std::atomic<bool> done{false};
+	size_t tears = 0;
+	std::thread reader{[&] {
+		// A single aligned 8-byte load on x86-64, like the one of the writer
+		const auto pair = reinterpret_cast<volatile const std::uint64_t*>(
+			record.data() + offsetof(cry::cvar, int_value));
+		while (!done.load(std::memory_order_relaxed))
+		{
+			const std::uint64_t bits = *pair;
+			const auto bytes = reinterpret_cast<const char*>(&bits);
+			int i;
+			float f;
+			std::memcpy(&i, bytes, sizeof(i));
+			std::memcpy(&f, bytes + sizeof(i), sizeof(f));
+			tears += i != static_cast<int>(f);
+		}
+	}};
+
+	const auto start = std::chrono::steady_clock::now();
+	while (std::chrono::steady_clock::now() - start < 200ms)
+	{
+		for (size_t n = 0; n < 1000; ++n)
+			(n % 2 ? second : first).write(var, layout);
+	}
+	done = true;
+	reader.join();
+	CHECK(tears == 0);
+}
+
+// A string longer than the field of the layout is stored truncated, and
+// still recognized once written
+TEST_CASE("assignment", "truncated_string")
+{
+	constexpr auto native = cry::cvar_layout::native();
+	constexpr cry::cvar_layout small{
+		native.int_offset, native.float_offset, native.string_offset, 6};
+
+	alignas(16) std::array<std::byte, record_size> record{};
+	const auto var = write_record(record.data(), TARGET_NAMES.front());
+
+	const cry::cvar_assignment value{std::string{"1234567890"}};
+	CHECK(!value.holds(var, small));
+	value.write(var, small);
+	CHECK(std::strcmp(var->string_value.data(), "12345") == 0);
+	CHECK(value.holds(var, small));
+	CHECK(value.matches(var, small));
+
+	// Strings are compared up to the terminator
+	CHECK(cry::cvar_assignment{std::string{"12345"}}.matches(var, small));
+	CHECK(!cry::cvar_assignment{std::string{"1234"}}.matches(var, small));
+}
@@ -0,0 +1,69 @@
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "shugoconsole/cry/cvar.hpp"
+#include "shugoconsole/cry/cvar_layout.hpp"
+#include "shugoconsole/cry/region_source.hpp"
+#include "testing/fake_cvars.hpp"
+#include "tests/test.hpp"
+
+using namespace shugoconsole;
+using namespace shugoconsole::testing;
+
+namespace
+{
+
+// Probes the layout of records holding numbers written with expected
+std::optional<cry::cvar_layout> probe(const cry::cvar_layout& expected)
+{
+	constexpr size_t count = 8;
+	constexpr size_t stride = 512;
+
+	std::vector<std::byte> records(count * stride);
+	std::vector<cry::layout_sample> samples;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const auto var = write_record(
+			records.data() + i * stride, TARGET_NAMES[i % TARGET_NAMES.size()]);
+
+		const bool integer = i % 2 == 0;
+		const auto number = static_cast<int>(i * 25 + 1);
+		const cry::cvar::value value =
+			integer ? cry::cvar::value{number} :
+					  cry::cvar::value{static_cast<float>(number) + 0.5f};
+		cry::set_value(var, value, expected);
+
+		samples.push_back(
+			{var,
+			 integer ? cry::cvar::type::integer : cry::cvar::type::floating});
+	}
+
+	const auto source = cry::make_process_region_source();
+	return cry::probe_layout(*source, samples);
+}
+
+} // namespace
+
+TEST_CASE("layout", "native")
+{
+	constexpr auto native = cry::cvar_layout::native();
+	CHECK(probe(native) == native);
+}
+
+TEST_CASE("layout", "shifted")
+{
+	constexpr auto native = cry::cvar_layout::native();
+	constexpr cry::cvar_layout shifted{
+		native.int_offset + 16,
+		native.float_offset + 16,
+		native.string_offset + 16,
+		native.string_size};
+	CHECK(probe(shifted) == shifted);
+}
+
+TEST_CASE("layout", "no_samples")
+{
+	const auto source = cry::make_process_region_source();
+	CHECK(!cry::probe_layout(*source, {}).has_value());
+}
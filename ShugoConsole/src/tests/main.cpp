@@ -0,0 +1,81 @@
+// Checks of the scanner, the enforcement and the hooks against fake CVars
+// Usage: ShugoConsoleTests [suite]
+// Returns 1 if a check fails or if no test belongs to suite
+
+#include <cstring>
+#include <vector>
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+#include "tests/test.hpp"
+
+namespace shugoconsole::tests
+{
+
+namespace
+{
+
+struct test
+{
+	const char* suite;
+	const char* name;
+	void (*f)();
+};
+
+// Tests are added before main, in the order of the static initializers
+std::vector<test>& tests()
+{
+	static std::vector<test> all;
+	return all;
+}
+
+size_t failures = 0;
+
+} // namespace
+
+bool add_test(const char* suite, const char* name, void (*f)())
+{
+	tests().push_back({suite, name, f});
+	return true;
+}
+
+void fail(const char* file, int line, const char* expression)
+{
+	fmt::print("{}:{:d}: check failed: {}\n", file, line, expression);
+	++failures;
+}
+
+} // namespace shugoconsole::tests
+
+int main(int argc, char** argv)
+{
+	using namespace shugoconsole::tests;
+
+	spdlog::set_level(spdlog::level::off);
+
+	size_t run = 0;
+	for (const auto& t : tests())
+	{
+		if (argc > 1 && std::strcmp(argv[1], t.suite) != 0)
+			continue;
+
+		const auto before = failures;
+		t.f();
+		++run;
+		fmt::print(
+			"{} {}.{}\n",
+			failures == before ? "ok  " : "FAIL",
+			t.suite,
+			t.name);
+	}
+
+	if (run == 0)
+	{
+		fmt::print("No test in suite '{}'\n", argc > 1 ? argv[1] : "");
+		return 1;
+	}
+
+	fmt::print("{:d} tests, {:d} failed checks\n", run, failures);
+	return failures == 0 ? 0 : 1;
+}
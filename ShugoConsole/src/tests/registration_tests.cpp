@@ -0,0 +1,194 @@
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "shugoconsole/cry/cvar.hpp"
+#include "shugoconsole/cry/method_address.hpp"
+#include "shugoconsole/cry/register_hook.hpp"
+#include "shugoconsole/cry/registered_cvars.hpp"
+#include "shugoconsole/cry/signature.hpp"
+#include "testing/fake_cvars.hpp"
+#include "testing/fake_engine.hpp"
+#include "tests/test.hpp"
+
+using namespace shugoconsole;
+using namespace shugoconsole::testing;
+
+namespace
+{
+
+// Fake CVars of the engine with the targets last
+class registered_records
+{
+public:
+	explicit registered_records(size_t count)
+	{
+		for (size_t i = 0; names_.size() < count; ++i)
+		{
+			const auto& prefix = FAKE_PREFIXES[i % FAKE_PREFIXES.size()];
+			names_.push_back(fmt::format("{}var{:d}", prefix, i));
+		}
+		names_.insert(names_.end(), TARGET_NAMES.begin(), TARGET_NAMES.end());
+
+		records_.resize(names_.size() * record_size);
+		for (size_t i = 0; i < names_.size(); ++i)
+		{
+			vars.push_back(
+				write_record(records_.data() + i * record_size, names_[i]));
+		}
+	}
+
+	std::vector<cry::cvar*> vars;
+
+private:
+	std::vector<std::string> names_;
+	std::vector<std::byte> records_;
+};
+
+} // namespace
+
+TEST_CASE("registration", "record_and_lookup")
+{
+	registered_records records{2000};
+	const auto table = std::make_unique<cry::registered_cvars>();
+	for (const auto var : records.vars)
+		CHECK(table->record(var));
+	CHECK(table->size() == records.vars.size());
+
+	const auto first = records.vars.size() - TARGET_NAMES.size();
+	for (size_t i = 0; i < TARGET_NAMES.size(); ++i)
+	{
+		const auto r = table->lookup(TARGET_NAMES[i]);
+		CHECK(r && r->var == records.vars[first + i]);
+		CHECK(
+			r && r->vtable == reinterpret_cast<std::uintptr_t>(
+								  records.vars[first + i]->dummy0));
+	}
+	for (const auto& name : MISSING_NAMES)
+		CHECK(!table->lookup(name));
+}
+
+// CVars created again under the same names, more times than the table
+// holds entries
+TEST_CASE("registration", "registered_again")
+{
+	const auto table = std::make_unique<cry::registered_cvars>();
+	constexpr size_t rounds = 3;
+	const size_t count = cry::registered_cvars::capacity / 2;
+
+	std::vector<registered_records> generations;
+	for (size_t round = 0; round < rounds; ++round)
+	{
+		generations.emplace_back(count);
+		for (const auto var : generations.back().vars)
+			CHECK(table->record(var));
+	}
+
+	const auto& last = generations.back().vars;
+	CHECK(table->size() == last.size());
+	for (const auto var : last)
+	{
+		const auto r = table->lookup(var->name.data());
+		CHECK(r && r->var == var);
+	}
+}
+
+// A lookup made while the name is registered again never pairs a CVar with
+// the vtable of the other one
+TEST_CASE("registration", "no_torn_entries")
+{
+	using namespace std::chrono_literals;
+
+	registered_records first{1};
+	registered_records second{1};
+	const auto otherVtable = record_vtable + 0x100;
+	std::memcpy(
+		&second.vars.back()->dummy0, &otherVtable, sizeof(otherVtable));
+
+	const auto table = std::make_unique<cry::registered_cvars>();
+	const auto name = TARGET_NAMES.back();
+	table->record(first.vars.back());
+
+	std::atomic<bool> done{false};
+	size_t tears = 0;
+	std::thread reader{[&] {
+		while (!done.load(std::memory_order_relaxed))
+		{
+			const auto r = table->lookup(name);
+			tears += !r ||
+				r->vtable != reinterpret_cast<std::uintptr_t>(r->var->dummy0);
+		}
+	}};
+
+	const auto start = std::chrono::steady_clock::now();
+	while (std::chrono::steady_clock::now() - start < 200ms)
+	{
+		for (size_t n = 0; n < 1000; ++n)
+			table->record((n % 2 ? second : first).vars.back());
+	}
+	done = true;
+	reader.join();
+	CHECK(tears == 0);
+}
+
+// Registrations are called through a pointer the compiler can't see
+// through, like the engine does
+TEST_CASE("registration", "hook")
+{
+	registered_records records{100};
+	using register_method = void (fake_engine_console::*)(cry::cvar*, void*);
+	const auto target = cry::register_hook::reserve(
+		cry::code_of(&fake_engine_console::register_var));
+
+	fake_engine_console console;
+	const auto table = std::make_unique<cry::registered_cvars>();
+	cry::register_hook::use(table.get());
+	const volatile auto m = cry::method_at<register_method>(target.replacement);
+	for (const auto var : records.vars)
+		(console.*m)(var, nullptr);
+	cry::register_hook::use(nullptr);
+
+	CHECK(console.registered == records.vars.size());
+	CHECK(table->size() == records.vars.size());
+	const auto r = table->lookup(TARGET_NAMES.back());
+	CHECK(r && r->var == records.vars.back());
+}
+
+TEST_CASE("registration", "signature")
+{
+	const auto signature = cry::signature::parse(
+		"48 89 5C 24 ?? 48 89 74 24 ?? 57 48 83 EC ?? 48 8B 02 48 8B FA");
+	CHECK(signature.has_value());
+	if (!signature)
+		return;
+	CHECK(signature->size() == 21);
+
+	const std::uint8_t code[] = {0x48, 0x89, 0x5C, 0x24, 0x08, 0x48, 0x89,
+								 0x74, 0x24, 0x10, 0x57, 0x48, 0x83, 0xEC,
+								 0x20, 0x48, 0x8B, 0x02, 0x48, 0x8B, 0xFA};
+	std::vector<std::byte> module(1 << 20);
+	std::mt19937 random{7};
+	fill_noise(module.data(), module.size(), random);
+	const auto offset = module.size() - 4096;
+	std::memcpy(module.data() + offset, code, sizeof(code));
+
+	const auto end = module.data() + module.size();
+	CHECK(signature->find(module.data(), end) == module.data() + offset);
+	CHECK(signature->find(module.data() + offset + 1, end) == nullptr);
+}
+
+TEST_CASE("registration", "invalid_signature")
+{
+	CHECK(!cry::signature::parse(""));
+	CHECK(!cry::signature::parse("48 8G"));
+	CHECK(!cry::signature::parse("48 ? 02"));
+}
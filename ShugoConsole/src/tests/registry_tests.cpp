@@ -0,0 +1,33 @@
+#include <cstddef>
+#include <vector>
+
+#include "shugoconsole/cry/cvar.hpp"
+#include "shugoconsole/cry/cvar_registry.hpp"
+#include "shugoconsole/cry/memory.hpp"
+#include "testing/fake_cvars.hpp"
+#include "testing/synthetic_heap.hpp"
+#include "tests/test.hpp"
+
+using namespace shugoconsole;
+using namespace shugoconsole::testing;
+
+TEST_CASE("registry", "find_and_lookup")
+{
+	synthetic_heap heap{16 << 20, 2000, 42};
+
+	// The registry is found from any CVar it holds
+	auto registry = cry::cvar_registry::find(heap, heap.targets().back());
+	CHECK(registry.has_value());
+	if (!registry)
+		return;
+
+	CHECK(registry->size() > TARGET_NAMES.size());
+	for (size_t i = 0; i < TARGET_NAMES.size(); ++i)
+		CHECK(registry->lookup(TARGET_NAMES[i]) == heap.targets()[i]);
+	for (const auto& name : MISSING_NAMES)
+		CHECK(registry->lookup(name) == nullptr);
+
+	CHECK(registry->refresh(heap));
+	for (size_t i = 0; i < TARGET_NAMES.size(); ++i)
+		CHECK(registry->lookup(TARGET_NAMES[i]) == heap.targets()[i]);
+}
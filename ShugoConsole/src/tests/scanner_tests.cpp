@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "shugoconsole/cry/cvar.hpp"
+#include "shugoconsole/cry/cvar_liveness.hpp"
+#include "shugoconsole/cry/heap_blocks.hpp"
+#include "shugoconsole/cry/incremental_region_source.hpp"
+#include "shugoconsole/cry/match_filters.hpp"
+#include "shugoconsole/cry/memory.hpp"
+#include "shugoconsole/cry/region_source.hpp"
+#include "testing/fake_cvars.hpp"
+#include "testing/process_heap.hpp"
+#include "testing/synthetic_heap.hpp"
+#include "tests/test.hpp"
+
+using namespace shugoconsole;
+using namespace shugoconsole::testing;
+
+namespace
+{
+
+// Small enough for every test to build its own
+synthetic_heap make_heap()
+{
+	return synthetic_heap{16 << 20, 2000, 42};
+}
+
+std::vector<cry::cvar*> find(
+	cry::region_source& source, const cry::scan_options& options = {})
+{
+	std::vector<std::byte> buffer(64 * 1024);
+	return cry::find_cvar_ptrs(
+		source, cry::cvar::pattern_set{target_patterns()}, buffer, options);
+}
+
+} // namespace
+
+TEST_CASE("scanner", "copy")
+{
+	auto heap = make_heap();
+	cry::scan_options options;
+	options.mode = cry::scan_mode::copy;
+	CHECK(find(heap, options) == heap.targets());
+}
+
+TEST_CASE("scanner", "in_place")
+{
+	auto heap = make_heap();
+	cry::scan_options options;
+	options.mode = cry::scan_mode::in_place;
+	CHECK(find(heap, options) == heap.targets());
+}
+
+TEST_CASE("scanner", "threads")
+{
+	auto heap = make_heap();
+	cry::scan_options options;
+	options.threads = 4;
+	options.chunk_size = 256 * 1024;
+	CHECK(find(heap, options) == heap.targets());
+}
+
+TEST_CASE("scanner", "missing_names")
+{
+	auto heap = make_heap();
+	auto patterns = target_patterns();
+	patterns.insert(patterns.end(), MISSING_NAMES.begin(), MISSING_NAMES.end());
+
+	std::vector<std::byte> buffer(64 * 1024);
+	auto found = cry::find_cvar_ptrs(
+		heap, cry::cvar::pattern_set{std::move(patterns)}, buffer);
+
+	for (size_t i = TARGET_NAMES.size(); i < found.size(); ++i)
+		CHECK(found[i] == nullptr);
+	found.resize(TARGET_NAMES.size());
+	CHECK(found == heap.targets());
+}
+
+TEST_CASE("scanner", "vtable_filter")
+{
+	auto heap = make_heap();
+	cry::scan_options options;
+	options.vtables = cry::cvar::vtable_range::around(heap.targets());
+	CHECK(options.vtables.has_value());
+	CHECK(find(heap, options) == heap.targets());
+}
+
+TEST_CASE("scanner", "resumable")
+{
+	auto heap = make_heap();
+	std::vector<std::byte> buffer(64 * 1024);
+	cry::scanner scanner{
+		heap, cry::cvar::pattern_set{target_patterns()}, buffer};
+
+	cry::scan_budget budget;
+	budget.bytes = cry::scan_budget::slice_size;
+	size_t steps = 1;
+	while (!scanner.step(budget))
+		++steps;
+
+	CHECK(steps > 1);
+	CHECK(scanner.results() == heap.targets());
+}
+
+TEST_CASE("scanner", "incremental")
+{
+	auto heap = make_heap();
+	cry::incremental_region_source incremental{heap};
+
+	// Nothing is found so that every pass covers all regions
+	const cry::cvar::pattern_set missing{{cry::cvar::pattern{"test_missing"}}};
+	std::vector<std::byte> buffer(64 * 1024);
+	cry::find_cvar_ptrs(incremental, missing, buffer);
+	CHECK(incremental.skipped_bytes() == 0);
+
+	// Nothing changed, the second pass skips everything
+	CHECK(cry::find_cvar_ptrs(incremental, missing, buffer).front() == nullptr);
+	CHECK(incremental.returned_bytes() == 0);
+	CHECK(incremental.skipped_bytes() >= heap.size());
+
+	// A call checksums at most one block past checked_per_call bytes,
+	// unchanged blocks are returned as empty regions
+	using incremental_source = cry::incremental_region_source;
+	incremental.reset();
+	cry::region r{};
+	size_t calls = 0;
+	while (incremental.next(r))
+	{
+		CHECK(r.size == 0);
+		++calls;
+	}
+	CHECK(
+		calls + 1 >= heap.size() / (incremental_source::checked_per_call +
+									incremental_source::block_size));
+
+	// The CVars written since are found again
+	incremental.clear();
+	CHECK(find(incremental) == heap.targets());
+}
+
+// A CVar constructed in a region already scanned is found by the next pass,
+// wherever its slot is in the block
+TEST_CASE("scanner", "incremental_new_cvar")
+{
+	auto heap = make_heap();
+	cry::incremental_region_source incremental{heap};
+	const cry::cvar::pattern_set created{{cry::cvar::pattern{"test_created"}}};
+	std::vector<std::byte> buffer(64 * 1024);
+	CHECK(cry::find_cvar_ptrs(incremental, created, buffer).front() == nullptr);
+
+	// Slots of the first region that hold no target
+	cry::region region{};
+	heap.reset();
+	CHECK(heap.next(region));
+	const auto free = [&](const std::byte* address) {
+		for (const auto target : heap.targets())
+		{
+			const auto t = reinterpret_cast<const std::byte*>(target);
+			if (address < t + record_size && t < address + record_size)
+				return false;
+		}
+		return true;
+	};
+
+	for (size_t offset = 16; offset + record_size <= region.size;
+		 offset += 16 * 17)
+	{
+		const auto address = region.base + offset;
+		if (!free(address))
+			continue;
+
+		std::vector<std::byte> saved(address, address + record_size);
+		const auto var = write_record(address, "test_created");
+		CHECK(cry::find_cvar_ptrs(incremental, created, buffer).front() == var);
+		std::copy(saved.begin(), saved.end(), address);
+
+		if (offset > 4096)
+			break;
+	}
+}
+
+// Every match is yielded once, even when an in-place read faults after
+// scanning part of its range and the range is copied instead
+TEST_CASE("scanner", "all_matches_after_fault")
+{
+	class faulting_source final : public cry::region_source
+	{
+	public:
+		explicit faulting_source(cry::region_source& inner) : inner_{inner}
+		{
+		}
+
+		void reset() override { inner_.reset(); }
+		bool next(cry::region& r) override { return inner_.next(r); }
+
+		size_t read(const std::byte* address, std::byte* buffer, size_t size)
+			override
+		{
+			return inner_.read(address, buffer, size);
+		}
+
+		bool read_in_place(
+			const std::byte* address,
+			size_t size,
+			void (*f)(void* context, const std::byte* view),
+			void* context) override
+		{
+			inner_.read_in_place(address, size, f, context);
+			return false;
+		}
+
+	private:
+		cry::region_source& inner_;
+	};
+
+	auto heap = make_heap();
+	faulting_source source{heap};
+	const cry::cvar::pattern_set patterns{target_patterns()};
+	std::vector<std::byte> buffer(64 * 1024);
+	std::vector<size_t> counts(TARGET_NAMES.size());
+	for (const auto& match : cry::cvar_matches{source, patterns, buffer})
+	{
+		CHECK(match.var == heap.targets()[match.pattern]);
+		++counts[match.pattern];
+	}
+	CHECK(counts == std::vector<size_t>(TARGET_NAMES.size(), 1));
+}
+
+// The process heap holds a stale copy before each target
+TEST_CASE("scanner", "process_vtable_filter")
+{
+	process_heap heap{2000, 4, 1 << 20, 42};
+	const auto regions = cry::make_process_region_source();
+
+	cry::scan_options options;
+	options.vtables = cry::cvar::vtable_range::around(heap.targets());
+	CHECK(find(*regions, options) == heap.targets());
+
+	const auto filter = cry::match_filters::all_of(
+		{cry::match_filters::layout(),
+		 cry::match_filters::vtable(*options.vtables)});
+	const cry::cvar::pattern_set patterns{target_patterns()};
+	std::vector<cry::cvar*> found(TARGET_NAMES.size());
+	std::vector<std::byte> buffer(64 * 1024);
+	for (const auto& match :
+		 cry::cvar_matches{*regions, patterns, buffer, filter})
+	{
+		if (found[match.pattern] == nullptr)
+			found[match.pattern] = match.var;
+	}
+	CHECK(found == heap.targets());
+}
+
+TEST_CASE("scanner", "liveness")
+{
+	process_heap heap{2000, 4, 1 << 20, 42};
+	const auto regions = cry::make_process_region_source();
+
+	const auto old = heap.targets().front();
+	const auto vtable = reinterpret_cast<std::uintptr_t>(old->dummy0);
+	const cry::cvar::pattern pattern{TARGET_NAMES.front()};
+	CHECK(
+		cry::check_liveness(*regions, pattern, old, vtable) ==
+		cry::liveness::alive);
+
+	const auto moved = heap.move_target(0);
+	CHECK(
+		cry::check_liveness(*regions, pattern, old, vtable) ==
+		cry::liveness::replaced);
+
+	std::vector<std::byte> buffer(64 * 1024);
+	CHECK(
+		cry::resolve_moved_cvar(*regions, pattern, old, vtable, buffer) ==
+		moved);
+}
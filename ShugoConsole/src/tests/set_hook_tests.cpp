@@ -0,0 +1,149 @@
+#include <array>
+#include <cstring>
+#include <utility>
+
+#include "shugoconsole/cry/cvar.hpp"
+#include "shugoconsole/cry/cvar_layout.hpp"
+#include "shugoconsole/cry/set_hooks.hpp"
+#include "shugoconsole/cry/set_interceptor.hpp"
+#include "testing/fake_engine.hpp"
+#include "tests/test.hpp"
+
+using namespace shugoconsole;
+using namespace shugoconsole::testing;
+
+namespace
+{
+
+// The Set methods of the fake engine CVars hooked by a copy of their vtable,
+// in place of Detours
+class hooked_cvars
+{
+public:
+	hooked_cvars()
+	{
+		std::memcpy(
+			vtable_.data(),
+			*reinterpret_cast<void***>(&plain),
+			sizeof(vtable_));
+
+		using cry::set_hooks::method;
+		const std::pair<method, size_t> methods[] = {
+			{method::string, 1}, {method::floating, 2}, {method::integer, 3}};
+		for (const auto& [m, slot] : methods)
+		{
+			const auto target = cry::set_hooks::reserve(m, vtable_[slot]);
+			CHECK(target.has_value());
+			if (target)
+				vtable_[slot] = target->replacement;
+		}
+
+		for (auto var : {&managed, &unmanaged})
+		{
+			const auto patched = vtable_.data();
+			std::memcpy(static_cast<void*>(var), &patched, sizeof(patched));
+		}
+	}
+
+	// The objects get their own vtable back before they are destroyed
+	~hooked_cvars()
+	{
+		cry::set_hooks::use(nullptr);
+		for (auto var : {&managed, &unmanaged})
+			std::memcpy(static_cast<void*>(var), &plain, sizeof(void*));
+		cry::set_hooks::release_all();
+	}
+
+	fake_engine_cvar managed;
+	fake_engine_cvar unmanaged;
+	fake_engine_cvar plain;
+
+private:
+	std::array<void*, 4> vtable_;
+};
+
+// Calls through a pointer the compiler can't see through
+template<typename T>
+void set(fake_engine_cvar& var, T value)
+{
+	fake_engine_cvar* volatile p = &var;
+	p->set(value);
+}
+
+void check_mode(cry::set_interceptor::mode mode)
+{
+	constexpr float wanted = 90.0f;
+
+	hooked_cvars cvars;
+	cry::set_interceptor interceptor{mode};
+	cry::set_hooks::use(&interceptor);
+	CHECK(interceptor.manage(
+		reinterpret_cast<const cry::cvar*>(&cvars.managed),
+		cry::cvar_assignment{wanted}));
+	cvars.managed.value = wanted;
+
+	set(cvars.managed, 30.0f);
+	CHECK(cvars.managed.value == wanted);
+	set(cvars.managed, "60");
+	CHECK(cvars.managed.value == wanted);
+	set(cvars.managed, 60);
+	CHECK(cvars.managed.value == wanted);
+	CHECK(interceptor.take_intercepted() == 3);
+
+	set(cvars.unmanaged, 30.0f);
+	CHECK(cvars.unmanaged.value == 30.0f);
+	CHECK(interceptor.take_intercepted() == 0);
+
+	// Managed again without a value, Sets go through
+	CHECK(interceptor.manage(
+		reinterpret_cast<const cry::cvar*>(&cvars.managed), std::nullopt));
+	set(cvars.managed, 30.0f);
+	CHECK(cvars.managed.value == 30.0f);
+}
+
+} // namespace
+
+TEST_CASE("set_hooks", "rewrite")
+{
+	check_mode(cry::set_interceptor::mode::rewrite);
+}
+
+TEST_CASE("set_hooks", "reject")
+{
+	check_mode(cry::set_interceptor::mode::reject);
+}
+
+TEST_CASE("set_hooks", "no_interceptor")
+{
+	hooked_cvars cvars;
+	set(cvars.managed, 30.0f);
+	CHECK(cvars.managed.value == 30.0f);
+}
+
+// The entries of the CVars that are not managed anymore are reused, and
+// values are replaced in place
+TEST_CASE("set_hooks", "interceptor_entries")
+{
+	constexpr auto capacity = cry::set_interceptor::capacity;
+	std::array<fake_engine_cvar, 2 * capacity> vars;
+	const auto var = [&](size_t i) {
+		return reinterpret_cast<const cry::cvar*>(&vars[i]);
+	};
+
+	cry::set_interceptor interceptor{cry::set_interceptor::mode::rewrite};
+	for (size_t i = 0; i < capacity; ++i)
+		CHECK(interceptor.manage(var(i), cry::cvar_assignment{1}));
+	CHECK(!interceptor.manage(var(capacity), cry::cvar_assignment{1}));
+
+	for (int value = 0; value < 1000; ++value)
+		CHECK(interceptor.manage(var(0), cry::cvar_assignment{value}));
+	CHECK(interceptor.find(var(0))->int_value() == 999);
+
+	for (size_t i = 0; i < capacity; ++i)
+		CHECK(interceptor.manage(var(i), std::nullopt));
+	for (size_t i = capacity; i < vars.size(); ++i)
+		CHECK(interceptor.manage(var(i), cry::cvar_assignment{2}));
+
+	CHECK(interceptor.find(var(0)) == nullptr);
+	CHECK(interceptor.find(var(vars.size() - 1))->int_value() == 2);
+}
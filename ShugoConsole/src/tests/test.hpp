@@ -0,0 +1,31 @@
+#ifndef SHUGOCONSOLE_TESTS_TEST_HPP
+#define SHUGOCONSOLE_TESTS_TEST_HPP
+
+namespace shugoconsole::tests
+{
+
+// Registers a test of suite, run by ShugoConsoleTests <suite>
+bool add_test(const char* suite, const char* name, void (*f)());
+
+// Records a failed check, the test goes on
+void fail(const char* file, int line, const char* expression);
+
+} // namespace shugoconsole::tests
+
+#define SHUGOCONSOLE_CONCAT2(a, b) a##b
+#define SHUGOCONSOLE_CONCAT(a, b) SHUGOCONSOLE_CONCAT2(a, b)
+
+// Defines a test function registered before main, at most one per line
+#define TEST_CASE(suite, name)                                             \
+	static void SHUGOCONSOLE_CONCAT(test_, __LINE__)();                    \
+	static const bool SHUGOCONSOLE_CONCAT(registered_, __LINE__) =         \
+		shugoconsole::tests::add_test(                                     \
+			suite, name, &SHUGOCONSOLE_CONCAT(test_, __LINE__));           \
+	static void SHUGOCONSOLE_CONCAT(test_, __LINE__)()
+
+#define CHECK(expression)                                                  \
+	((expression) ?                                                        \
+		 static_cast<void>(0) :                                            \
+		 shugoconsole::tests::fail(__FILE__, __LINE__, #expression))
+
+#endif // SHUGOCONSOLE_TESTS_TEST_HPP
@@ -0,0 +1,56 @@
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "shugoconsole/cry/watched_pages.hpp"
+#include "tests/test.hpp"
+
+using namespace shugoconsole;
+
+TEST_CASE("write_watch", "armed_pages")
+{
+	const auto pages = std::make_unique<cry::watched_pages>();
+	const std::uintptr_t page = 0x10000;
+
+	CHECK(!pages->on_write(page));
+	CHECK(pages->arm(page));
+	CHECK(pages->armed(page));
+
+	// Only the first write to an armed page is caught
+	CHECK(pages->on_write(page));
+	CHECK(!pages->armed(page));
+	CHECK(!pages->on_write(page));
+	CHECK(pages->take_writes() == 1);
+
+	// Released by the handler, forgotten by release()
+	CHECK(!pages->release(page));
+	CHECK(!pages->on_write(page));
+
+	CHECK(pages->arm(page));
+	CHECK(pages->release(page));
+	CHECK(!pages->on_write(page));
+	CHECK(pages->releases() == 2);
+}
+
+TEST_CASE("write_watch", "released_entries_reused")
+{
+	const auto pages = std::make_unique<cry::watched_pages>();
+	const auto page = [](size_t i) {
+		return static_cast<std::uintptr_t>(0x10000 + i * 0x1000);
+	};
+
+	// Pages of CVars that moved don't fill the set
+	for (size_t round = 0; round < 4; ++round)
+	{
+		const auto first = round * cry::watched_pages::capacity;
+		for (size_t i = 0; i < cry::watched_pages::capacity; ++i)
+			CHECK(pages->arm(page(first + i)));
+		CHECK(!pages->arm(page(first + cry::watched_pages::capacity)));
+
+		std::vector<std::uintptr_t> listed;
+		pages->for_each_page([&](std::uintptr_t p) { listed.push_back(p); });
+		CHECK(listed.size() == cry::watched_pages::capacity);
+		for (const auto p : listed)
+			CHECK(pages->release(p));
+	}
+}